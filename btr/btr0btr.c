@@ -22,6 +22,8 @@ Created 6/2/1994 Heikki Tuuri
 #include "lock0lock.h"
 #include "ibuf0ibuf.h"
 #include "trx0trx.h"
+#include "srv0srv.h"
+#include "log0log.h"
 
 /*
 Latching strategy of the InnoDB B-tree
@@ -1324,6 +1326,114 @@ split_at_new:
 	return(FALSE);
 }
 
+/* If this many consecutive page splits of an index have split the
+rightmost page of a tree level, we assume that the index is growing by
+appends to its end, like an index on an auto-increment or timestamp
+column */
+#define BTR_N_APPEND_SPLITS	3
+
+/*****************************************************************
+Updates the count of consecutive splits of rightmost pages in an index,
+and decides if the index is being appended to. */
+static
+ibool
+btr_page_split_is_append(
+/*=====================*/
+				/* out: TRUE if the index is in a sustained
+				pattern of appends */
+	btr_cur_t*	cursor,	/* in: cursor at which to insert */
+	mtr_t*		mtr)	/* in: mtr holding an x-latch on the tree */
+{
+	dict_index_t*	index	= cursor->index;
+	page_t*		page	= btr_cur_get_page(cursor);
+
+	ut_ad(mtr_memo_contains(mtr, dict_index_get_lock(index),
+				MTR_MEMO_X_LOCK));
+
+	if (dict_index_is_ibuf(index)
+	    || btr_page_get_next(page, mtr) != FIL_NULL) {
+
+		index->n_append_splits = 0;
+
+		return(FALSE);
+	}
+
+	if (index->n_append_splits < BTR_N_APPEND_SPLITS) {
+		index->n_append_splits++;
+	}
+
+	return(index->n_append_splits >= BTR_N_APPEND_SPLITS);
+}
+
+/*****************************************************************
+Calculates the split record of the rightmost page of an index that is
+being appended to, so that the records up to the insert point are kept
+on the page as far as they fit in innodb_fill_factor percent of it. The
+rest of a leaf page is left free for future updates of the records. If
+the insert point is too far from the end of the page, we split the page
+to halves as usual. */
+static
+rec_t*
+btr_page_get_append_split_rec(
+/*==========================*/
+				/* out: split record, or NULL if the page
+				should be split at the insert point */
+	btr_cur_t*	cursor)	/* in: cursor at which to insert */
+{
+	page_t*		page;
+	rec_t*		ins_rec;
+	rec_t*		rec;
+	ulint		fill_factor;
+	ulint		limit;
+	ulint		incl_data;
+	ulint		n;
+	mem_heap_t*	heap;
+	ulint*		offsets;
+
+	page = btr_cur_get_page(cursor);
+	ins_rec = btr_cur_get_rec(cursor);
+
+	fill_factor = page_is_leaf(page) ? srv_fill_factor : 100;
+
+	limit = page_get_free_space_of_empty(page_is_comp(page))
+		* fill_factor / 100;
+
+	n = 0;
+	incl_data = 0;
+	heap = NULL;
+	offsets = NULL;
+	rec = page_get_infimum_rec(page);
+
+	while (rec != ins_rec) {
+		rec = page_rec_get_next(rec);
+
+		offsets = rec_get_offsets(rec, cursor->index, offsets,
+					  ULINT_UNDEFINED, &heap);
+		incl_data += rec_offs_size(offsets);
+		n++;
+
+		if (n > 1 && incl_data + page_dir_calc_reserved_space(n)
+		    > limit) {
+
+			/* Keep the records before rec on the page */
+			goto func_exit;
+		}
+	}
+
+	if (incl_data + page_dir_calc_reserved_space(n) < limit / 2) {
+		rec = page_get_middle_rec(page);
+	} else {
+		rec = NULL;
+	}
+
+func_exit:
+	if (UNIV_LIKELY_NULL(heap)) {
+		mem_heap_free(heap);
+	}
+
+	return(rec);
+}
+
 /*****************************************************************
 Calculates a split record such that the tuple will certainly fit on
 its half-page when the split is performed. We assume in this function
@@ -1784,6 +1894,11 @@ func_start:
 		hint_page_no = page_no + 1;
 		split_rec = btr_page_get_sure_split_rec(cursor, tuple, n_ext);
 
+	} else if (btr_page_split_is_append(cursor, mtr)) {
+		direction = FSP_APPEND;
+		hint_page_no = page_no + 1;
+		split_rec = btr_page_get_append_split_rec(cursor);
+
 	} else if (btr_page_get_split_rec_to_right(cursor, &split_rec)) {
 		direction = FSP_UP;
 		hint_page_no = page_no + 1;
@@ -2744,6 +2859,696 @@ btr_discard_page(
 	ut_ad(btr_check_node_ptr(index, merge_block, mtr));
 }
 
+/* State of a bulk load of sorted records into an empty index tree */
+struct btr_bulk_struct{
+	dict_index_t*	index;	/* the index */
+	dulint		trx_id;	/* id of the transaction that builds the
+				index */
+	mem_heap_t*	heap;	/* memory heap for this struct and the
+				carry buffer */
+	mem_heap_t*	rec_heap;/* memory heap for the record being
+				inserted */
+	ulint		height;	/* number of levels started */
+	ulint		page_no[BTR_MAX_LEVELS];
+				/* the page being filled on each level */
+	ulint		leaf_limit;/* number of record bytes to fill a leaf
+				page with, according to srv_fill_factor */
+	mtr_t		mtr;	/* mini-transaction holding block; it does
+				not log the records appended to block */
+	buf_block_t*	block;	/* the leaf page being filled, or NULL */
+	rec_t*		last_rec;/* the last record on block */
+	page_t*		carry;	/* copy of a compressed leaf page that did
+				not compress with all its records, or NULL */
+	rec_t*		carry_rec;/* first record on carry to append to the
+				next leaf page, or NULL */
+};
+
+/******************************************************************
+Allocates and creates a page for a bulk load, and links it after the
+previous page of its level. */
+static
+ulint
+btr_bulk_page_alloc(
+/*================*/
+				/* out: DB_SUCCESS or DB_OUT_OF_FILE_SPACE */
+	btr_bulk_t*	bulk,	/* in: bulk load */
+	ulint		prev_page_no,/* in: previous page on the level,
+				or FIL_NULL */
+	ulint		level,	/* in: B-tree level of the page */
+	mtr_t*		mtr,	/* in: mtr holding an x-latch on the tree */
+	buf_block_t**	block)	/* out: the created page, x-latched */
+{
+	dict_index_t*	index	= bulk->index;
+	page_t*		page;
+	page_zip_des_t*	page_zip;
+	ulint		hint_page_no;
+	ulint		n_reserved;
+
+	if (!fsp_reserve_free_extents(&n_reserved, index->space, 1,
+				      FSP_NORMAL, mtr)) {
+
+		return(DB_OUT_OF_FILE_SPACE);
+	}
+
+	hint_page_no = prev_page_no == FIL_NULL
+		? dict_index_get_page(index) + 1
+		: prev_page_no + 1;
+
+	/* The index grows only at its right end: ask for contiguous
+	extents */
+
+	*block = btr_page_alloc(index, hint_page_no, FSP_APPEND, level, mtr);
+
+	fil_space_release_free_extents(index->space, n_reserved);
+
+	if (UNIV_UNLIKELY(*block == NULL)) {
+
+		return(DB_OUT_OF_FILE_SPACE);
+	}
+
+	page = buf_block_get_frame(*block);
+	page_zip = buf_block_get_page_zip(*block);
+
+	btr_page_create(*block, page_zip, index, level, mtr);
+
+	btr_page_set_next(page, page_zip, FIL_NULL, mtr);
+	btr_page_set_prev(page, page_zip, prev_page_no, mtr);
+
+	if (level == 0) {
+		page_set_max_trx_id(*block, page_zip, bulk->trx_id);
+	}
+
+	return(DB_SUCCESS);
+}
+
+/******************************************************************
+Inserts a node pointer to the end of a non-leaf level of a bulk load.
+When the page of the level is full, continues on a new page, and inserts
+a node pointer to it on the level above. */
+static
+ulint
+btr_bulk_insert_node_ptr(
+/*=====================*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in/out: bulk load */
+	dtuple_t*	node_ptr,/* in: node pointer */
+	ulint		level)	/* in: level where to insert, >= 1 */
+{
+	dict_index_t*	index	= bulk->index;
+	buf_block_t*	block;
+	page_t*		page;
+	page_cur_t	cursor;
+	rec_t*		rec;
+	mem_heap_t*	heap	= NULL;
+	dtuple_t*	parent_ptr = NULL;
+	ulint		err	= DB_SUCCESS;
+	mtr_t		mtr;
+
+	ut_ad(level > 0);
+	ut_ad(level <= bulk->height);
+
+	if (UNIV_UNLIKELY(level >= BTR_MAX_LEVELS)) {
+
+		return(DB_TOO_BIG_RECORD);
+	}
+
+	mtr_start(&mtr);
+	mtr_x_lock(dict_index_get_lock(index), &mtr);
+
+	if (level == bulk->height) {
+		/* Start a new level. The node pointer must be marked as
+		the predefined minimum record, as there is no lower
+		alphabetical limit to records in the leftmost node of a
+		level. */
+
+		err = btr_bulk_page_alloc(bulk, FIL_NULL, level, &mtr, &block);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			goto func_exit;
+		}
+
+		bulk->page_no[level] = buf_block_get_page_no(block);
+		bulk->height++;
+
+		dtuple_set_info_bits(node_ptr,
+				     dtuple_get_info_bits(node_ptr)
+				     | REC_INFO_MIN_REC_FLAG);
+	} else {
+		block = btr_block_get(index->space,
+				      dict_table_zip_size(index->table),
+				      bulk->page_no[level], RW_X_LATCH, &mtr);
+	}
+
+	page = buf_block_get_frame(block);
+
+	page_cur_position(page_rec_get_prev(page_get_supremum_rec(page)),
+			  block, &cursor);
+
+	rec = page_cur_tuple_insert(&cursor, node_ptr, index, 0, &mtr);
+
+	if (UNIV_UNLIKELY(rec == NULL)) {
+		/* The page is full: continue on a new page */
+		buf_block_t*	new_block;
+		ulint		page_no	= buf_block_get_page_no(block);
+
+		heap = mem_heap_create(256);
+
+		parent_ptr = dict_index_build_node_ptr(
+			index, page_rec_get_next(page_get_infimum_rec(page)),
+			page_no, heap, level);
+
+		err = btr_bulk_page_alloc(bulk, page_no, level, &mtr,
+					  &new_block);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+			parent_ptr = NULL;
+
+			goto func_exit;
+		}
+
+		bulk->page_no[level] = buf_block_get_page_no(new_block);
+
+		btr_page_set_next(page, buf_block_get_page_zip(block),
+				  bulk->page_no[level], &mtr);
+
+		page_cur_set_before_first(new_block, &cursor);
+
+		rec = page_cur_tuple_insert(&cursor, node_ptr, index, 0, &mtr);
+
+		ut_a(rec);
+	}
+
+func_exit:
+	mtr_commit(&mtr);
+
+	if (parent_ptr) {
+		err = btr_bulk_insert_node_ptr(bulk, parent_ptr, level + 1);
+	}
+
+	if (heap) {
+		mem_heap_free(heap);
+	}
+
+	return(err);
+}
+
+/******************************************************************
+Starts filling a leaf page in bulk->mtr, appending to it the records that
+were carried over from the previous page. */
+static
+void
+btr_bulk_leaf_open(
+/*===============*/
+	btr_bulk_t*	bulk,	/* in/out: bulk load */
+	buf_block_t*	block)	/* in: leaf page, x-latched in bulk->mtr */
+{
+	bulk->block = block;
+	bulk->last_rec = page_rec_get_prev(
+		page_get_supremum_rec(buf_block_get_frame(block)));
+
+	/* The records are logged when the page is full */
+
+	mtr_set_log_mode(&bulk->mtr, MTR_LOG_NONE);
+
+	if (bulk->carry_rec) {
+		rec_t*		rec	= bulk->carry_rec;
+		mem_heap_t*	heap	= NULL;
+		ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+		ulint*		offsets	= offsets_;
+		rec_offs_init(offsets_);
+
+		bulk->carry_rec = NULL;
+
+		do {
+			offsets = rec_get_offsets(rec, bulk->index, offsets,
+						  ULINT_UNDEFINED, &heap);
+			bulk->last_rec = page_cur_insert_rec_low(
+				bulk->last_rec, bulk->index, rec, offsets,
+				&bulk->mtr);
+			ut_a(bulk->last_rec);
+
+			rec = page_rec_get_next(rec);
+		} while (!page_rec_is_supremum(rec));
+
+		if (UNIV_LIKELY_NULL(heap)) {
+			mem_heap_free(heap);
+		}
+	}
+}
+
+/******************************************************************
+Compresses a leaf page filled in a bulk load. If the page does not
+compress, moves records from its end to bulk->carry, to be appended to
+the next leaf page, until it does. */
+static
+void
+btr_bulk_leaf_compress(
+/*===================*/
+	btr_bulk_t*	bulk)	/* in/out: bulk load */
+{
+	dict_index_t*	index		= bulk->index;
+	buf_block_t*	block		= bulk->block;
+	page_t*		page		= buf_block_get_frame(block);
+	page_zip_des_t*	page_zip	= buf_block_get_page_zip(block);
+	mem_heap_t*	heap		= NULL;
+	ulint		n_keep;
+	rec_t*		rec;
+	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+	ulint*		offsets		= offsets_;
+	rec_offs_init(offsets_);
+
+	if (UNIV_LIKELY(page_zip_compress(page_zip, page, index,
+					  &bulk->mtr))) {
+
+		return;
+	}
+
+	if (bulk->carry == NULL) {
+		bulk->carry = ut_align(mem_heap_alloc(bulk->heap,
+						      2 * UNIV_PAGE_SIZE),
+				       UNIV_PAGE_SIZE);
+	}
+
+	memcpy(bulk->carry, page, UNIV_PAGE_SIZE);
+
+	n_keep = page_get_n_recs(page);
+
+	do {
+		ulint	i;
+
+		/* Rebuild the page with fewer records from the copy */
+
+		ut_a(n_keep > 1);
+		n_keep -= n_keep / 8 ? n_keep / 8 : 1;
+
+		mtr_set_log_mode(&bulk->mtr, MTR_LOG_NONE);
+
+		page_create(block, &bulk->mtr, TRUE);
+		page_set_max_trx_id(block, NULL, bulk->trx_id);
+
+		rec = page_get_infimum_rec(bulk->carry);
+		bulk->last_rec = page_get_infimum_rec(page);
+
+		for (i = 0; i < n_keep; i++) {
+			rec = page_rec_get_next(rec);
+			offsets = rec_get_offsets(rec, index, offsets,
+						  ULINT_UNDEFINED, &heap);
+			bulk->last_rec = page_cur_insert_rec_low(
+				bulk->last_rec, index, rec, offsets,
+				&bulk->mtr);
+			ut_a(bulk->last_rec);
+		}
+
+		page_header_set_ptr(page, NULL, PAGE_LAST_INSERT, NULL);
+		page_header_set_field(page, NULL, PAGE_DIRECTION,
+				      PAGE_NO_DIRECTION);
+		page_header_set_field(page, NULL, PAGE_N_DIRECTION, 0);
+
+		mtr_set_log_mode(&bulk->mtr, MTR_LOG_ALL);
+	} while (!page_zip_compress(page_zip, page, index, &bulk->mtr));
+
+	bulk->carry_rec = page_rec_get_next(rec);
+
+	if (UNIV_LIKELY_NULL(heap)) {
+		mem_heap_free(heap);
+	}
+}
+
+/******************************************************************
+Completes the leaf page being filled in a bulk load: writes its records
+to the redo log, links a new leaf page after it unless this is the end of
+the load, and inserts a node pointer to the completed page on level 1. */
+static
+ulint
+btr_bulk_leaf_next(
+/*===============*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in/out: bulk load */
+	ibool		last)	/* in: TRUE if no more records follow */
+{
+	dict_index_t*	index		= bulk->index;
+	buf_block_t*	block		= bulk->block;
+	page_t*		page		= buf_block_get_frame(block);
+	page_zip_des_t*	page_zip	= buf_block_get_page_zip(block);
+	ulint		page_no		= buf_block_get_page_no(block);
+	ulint		new_page_no	= FIL_NULL;
+	buf_block_t*	new_block;
+	mem_heap_t*	heap		= NULL;
+	dtuple_t*	node_ptr	= NULL;
+	ulint		err		= DB_SUCCESS;
+
+	/* Write the records to the log, in the form that recovery
+	applies to the created page */
+
+	mtr_set_log_mode(&bulk->mtr, MTR_LOG_ALL);
+
+	page_header_set_ptr(page, NULL, PAGE_LAST_INSERT, NULL);
+	page_header_set_field(page, NULL, PAGE_DIRECTION, PAGE_NO_DIRECTION);
+	page_header_set_field(page, NULL, PAGE_N_DIRECTION, 0);
+
+	if (UNIV_LIKELY_NULL(page_zip)) {
+		btr_bulk_leaf_compress(bulk);
+	} else {
+		page_cur_log_appended_recs(page, index, &bulk->mtr);
+	}
+
+	if (!last || bulk->carry_rec) {
+		err = btr_bulk_page_alloc(bulk, page_no, 0, &bulk->mtr,
+					  &new_block);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			goto func_exit;
+		}
+
+		new_page_no = buf_block_get_page_no(new_block);
+
+		btr_page_set_next(page, page_zip, new_page_no, &bulk->mtr);
+	}
+
+	if (new_page_no != FIL_NULL || bulk->height > 1) {
+		heap = mem_heap_create(256);
+
+		node_ptr = dict_index_build_node_ptr(
+			index, page_rec_get_next(page_get_infimum_rec(page)),
+			page_no, heap, 0);
+	}
+
+func_exit:
+	mtr_commit(&bulk->mtr);
+	bulk->block = NULL;
+
+	if (node_ptr) {
+		err = btr_bulk_insert_node_ptr(bulk, node_ptr, 1);
+	}
+
+	if (heap) {
+		mem_heap_free(heap);
+	}
+
+	if (err == DB_SUCCESS && new_page_no != FIL_NULL) {
+		log_free_check();
+
+		mtr_start(&bulk->mtr);
+		mtr_x_lock(dict_index_get_lock(index), &bulk->mtr);
+
+		bulk->page_no[0] = new_page_no;
+
+		btr_bulk_leaf_open(bulk, btr_block_get(
+					   index->space,
+					   dict_table_zip_size(index->table),
+					   new_page_no, RW_X_LATCH,
+					   &bulk->mtr));
+	}
+
+	return(err);
+}
+
+/******************************************************************
+Starts a bulk load of records into an empty index tree. The records
+must be inserted in ascending order, and no other thread may access the
+index until btr_bulk_finish() has been called. The leaf pages are filled
+sequentially, up to innodb_fill_factor percent, and the node pointer
+levels are built as the leaf level grows; the records of a leaf page are
+written to the redo log in one short record when the page is full. */
+UNIV_INTERN
+btr_bulk_t*
+btr_bulk_create(
+/*============*/
+				/* out, own: bulk load */
+	dict_index_t*	index,	/* in: index whose tree is empty */
+	dulint		trx_id)	/* in: id of the transaction building the
+				index */
+{
+	btr_bulk_t*	bulk;
+	mem_heap_t*	heap;
+
+	ut_ad(!dict_index_is_clust(index));
+	ut_ad(!dict_index_is_ibuf(index));
+
+	heap = mem_heap_create(sizeof *bulk);
+
+	bulk = mem_heap_alloc(heap, sizeof *bulk);
+
+	bulk->index = index;
+	bulk->trx_id = trx_id;
+	bulk->heap = heap;
+	bulk->rec_heap = mem_heap_create(UNIV_PAGE_SIZE / 4);
+	bulk->height = 0;
+	bulk->leaf_limit = page_get_free_space_of_empty(
+		dict_table_is_comp(index->table)) * srv_fill_factor / 100;
+	bulk->block = NULL;
+	bulk->last_rec = NULL;
+	bulk->carry = NULL;
+	bulk->carry_rec = NULL;
+
+	return(bulk);
+}
+
+/******************************************************************
+Appends a record to the leaf level of a bulk load. */
+UNIV_INTERN
+ulint
+btr_bulk_insert(
+/*============*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in/out: bulk load */
+	const dtuple_t*	tuple)	/* in: index entry, not smaller than the
+				previous one; it must not need externally
+				stored fields */
+{
+	dict_index_t*	index	= bulk->index;
+	ulint		size;
+	rec_t*		rec;
+	ulint*		offsets;
+	ulint		err	= DB_SUCCESS;
+
+	size = rec_get_converted_size(index, tuple, 0);
+
+	ut_ad(!page_zip_rec_needs_ext(size, dict_table_is_comp(index->table),
+				      dict_table_zip_size(index->table)));
+
+	rec = rec_convert_dtuple_to_rec(
+		mem_heap_alloc(bulk->rec_heap, size), index, tuple, 0);
+	offsets = rec_get_offsets(rec, index, NULL, ULINT_UNDEFINED,
+				  &bulk->rec_heap);
+
+	if (UNIV_UNLIKELY(bulk->block == NULL)) {
+		/* Start the first leaf page. Allocate it in a separate
+		mini-transaction, so that bulk->mtr does not keep the
+		tablespace latched while the page is being filled. */
+		buf_block_t*	block;
+		mtr_t		mtr;
+
+		mtr_start(&mtr);
+		mtr_x_lock(dict_index_get_lock(index), &mtr);
+
+		err = btr_bulk_page_alloc(bulk, FIL_NULL, 0, &mtr, &block);
+
+		if (UNIV_LIKELY(err == DB_SUCCESS)) {
+			bulk->page_no[0] = buf_block_get_page_no(block);
+		}
+
+		mtr_commit(&mtr);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			goto func_exit;
+		}
+
+		bulk->height = 1;
+
+		mtr_start(&bulk->mtr);
+		mtr_x_lock(dict_index_get_lock(index), &bulk->mtr);
+
+		btr_bulk_leaf_open(bulk, btr_block_get(
+					   index->space,
+					   dict_table_zip_size(index->table),
+					   bulk->page_no[0], RW_X_LATCH,
+					   &bulk->mtr));
+	}
+
+	for (;;) {
+		page_t*	page = buf_block_get_frame(bulk->block);
+		rec_t*	ins_rec;
+
+		if (page_get_n_recs(page) == 0
+		    || page_get_data_size(page) + rec_offs_size(offsets)
+		    <= bulk->leaf_limit) {
+
+			ins_rec = page_cur_insert_rec_low(
+				bulk->last_rec, index, rec, offsets,
+				&bulk->mtr);
+
+			if (UNIV_LIKELY(ins_rec != NULL)) {
+				bulk->last_rec = ins_rec;
+
+				break;
+			}
+
+			ut_a(page_get_n_recs(page) > 0);
+		}
+
+		err = btr_bulk_leaf_next(bulk, FALSE);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			break;
+		}
+	}
+
+func_exit:
+	mem_heap_empty(bulk->rec_heap);
+
+	return(err);
+}
+
+/******************************************************************
+Completes a bulk load: completes the last page of each level, and copies
+the only page of the top level to the root page of the index. Frees the
+bulk load. */
+UNIV_INTERN
+ulint
+btr_bulk_finish(
+/*============*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in, own: bulk load */
+	ulint		err)	/* in: DB_SUCCESS, or the error that
+				aborted the load */
+{
+	dict_index_t*	index	= bulk->index;
+	ulint		zip_size = dict_table_zip_size(index->table);
+	ulint		level;
+	buf_block_t*	root_block;
+	page_t*		root;
+	page_zip_des_t*	root_page_zip;
+	buf_block_t*	top_block;
+	page_t*		top;
+	mem_heap_t*	heap;
+	dtuple_t*	node_ptr;
+	mtr_t		mtr;
+
+	if (err != DB_SUCCESS) {
+		/* The index will be dropped: just release the latches */
+
+		if (bulk->block) {
+			mtr_set_log_mode(&bulk->mtr, MTR_LOG_ALL);
+			mtr_commit(&bulk->mtr);
+		}
+
+		goto func_exit;
+	}
+
+	while (bulk->block) {
+		err = btr_bulk_leaf_next(bulk, TRUE);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			goto func_exit;
+		}
+	}
+
+	if (bulk->height == 0) {
+		/* No records were inserted */
+
+		goto func_exit;
+	}
+
+	/* Insert the node pointers to the last pages of the non-leaf
+	levels; this may add levels on top */
+
+	for (level = 1; level + 1 < bulk->height; level++) {
+		heap = mem_heap_create(256);
+
+		mtr_start(&mtr);
+		mtr_x_lock(dict_index_get_lock(index), &mtr);
+
+		top = buf_block_get_frame(btr_block_get(
+						  index->space, zip_size,
+						  bulk->page_no[level],
+						  RW_X_LATCH, &mtr));
+
+		node_ptr = dict_index_build_node_ptr(
+			index, page_rec_get_next(page_get_infimum_rec(top)),
+			bulk->page_no[level], heap, level);
+
+		mtr_commit(&mtr);
+
+		err = btr_bulk_insert_node_ptr(bulk, node_ptr, level + 1);
+
+		mem_heap_free(heap);
+
+		if (UNIV_UNLIKELY(err != DB_SUCCESS)) {
+
+			goto func_exit;
+		}
+	}
+
+	/* The top level now consists of one page: copy it to the root */
+
+	level = bulk->height - 1;
+
+	mtr_start(&mtr);
+	mtr_x_lock(dict_index_get_lock(index), &mtr);
+
+	root_block = btr_root_block_get(index, &mtr);
+	root = buf_block_get_frame(root_block);
+	root_page_zip = buf_block_get_page_zip(root_block);
+
+	top_block = btr_block_get(index->space, zip_size,
+				  bulk->page_no[level], RW_X_LATCH, &mtr);
+	top = buf_block_get_frame(top_block);
+
+	ut_ad(btr_page_get_prev(top, &mtr) == FIL_NULL);
+	ut_ad(btr_page_get_next(top, &mtr) == FIL_NULL);
+	ut_ad(page_get_n_recs(root) == 0);
+
+	if (UNIV_LIKELY_NULL(root_page_zip)) {
+		page_create_zip(root_block, index, level, &mtr);
+	} else {
+		page_create(root_block, &mtr, dict_table_is_comp(index->table));
+		btr_page_set_level(root, NULL, level, &mtr);
+	}
+
+	if (UNIV_UNLIKELY
+	    (!page_copy_rec_list_end(root_block, top_block,
+				     page_get_infimum_rec(top),
+				     index, &mtr))) {
+		const page_zip_des_t*	top_page_zip
+			= buf_block_get_page_zip(top_block);
+		byte			seg_headers[2 * FSEG_HEADER_SIZE];
+		byte*			root_seg
+			= root + PAGE_HEADER + PAGE_BTR_SEG_LEAF;
+
+		ut_a(root_page_zip);
+		ut_a(top_page_zip);
+
+		/* Copy the page byte for byte. This would overwrite the
+		file segment headers of the root with those of the top
+		page: preserve them. */
+
+		memcpy(seg_headers, root_seg, sizeof seg_headers);
+
+		page_zip_copy(root_page_zip, root, top_page_zip, top,
+			      index, &mtr);
+
+		memcpy(root_seg, seg_headers, sizeof seg_headers);
+		page_zip_write_header(root_page_zip, root_seg,
+				      sizeof seg_headers, &mtr);
+	}
+
+	btr_page_free(index, top_block, &mtr);
+
+	mtr_commit(&mtr);
+
+func_exit:
+	mem_heap_free(bulk->rec_heap);
+	mem_heap_free(bulk->heap);
+
+	return(err);
+}
+
 #ifdef UNIV_BTR_PRINT
 /*****************************************************************
 Prints size info of a B-tree. */
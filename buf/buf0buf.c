@@ -2925,6 +2925,17 @@ corrupt:
 				"InnoDB: You may have to recover"
 				" from a backup.\n",
 				(ulong) bpage->offset);
+			if (srv_use_atomic_writes
+			    && fil_space_get_atomic_writes(bpage->space)) {
+				fputs("InnoDB: The tablespace is written"
+				      " without the doublewrite buffer\n"
+				      "InnoDB: (innodb_use_atomic_writes)."
+				      " If the server crashed, the page\n"
+				      "InnoDB: may have been torn by a"
+				      " device that does not write\n"
+				      "InnoDB: pages atomically.\n",
+				      stderr);
+			}
 			fputs("InnoDB: It is also possible that"
 			      " your operating\n"
 			      "InnoDB: system has corrupted its"
@@ -33,6 +33,25 @@ flushed along with the original page. */
 #define BUF_FLUSH_AREA		ut_min(BUF_READ_AHEAD_AREA,\
 		buf_pool->curr_size / 16)
 
+/* With innodb_flush_neighbors=3 (BUF_FLUSH_NEIGHBORS_AUTO), the neighbors
+of a page are flushed only if the average latency of a data file write is
+at least this many microseconds. A random write costs milliseconds on a
+rotational disk, where writing the neighbors in the same sweep is almost
+free, but only some tens of microseconds on solid state storage, where the
+neighbor writes just add to the write volume. The latency is measured as
+the fsync time per write flushed, see fil_get_flush_time(). */
+#define BUF_FLUSH_NEIGHBORS_AUTO_LATENCY	1000
+
+/* The write latency is re-estimated when at least this many data file
+writes have been flushed since the previous estimate */
+#define BUF_FLUSH_NEIGHBORS_AUTO_MIN_WRITES	64
+
+/* Moving average of the data file write latency in microseconds, or 0 if
+not measured yet; the counters of the previous estimate */
+static ulint	buf_flush_write_latency		= 0;
+static ulint	buf_flush_n_flushed_writes_old	= 0;
+static ullint	buf_flush_flush_time_us_old	= 0;
+
 #if defined UNIV_DEBUG || defined UNIV_BUF_DEBUG
 /**********************************************************************
 Validates the flush list. */
@@ -291,45 +310,61 @@ buf_flush_write_complete(
 }
 
 /************************************************************************
-Flushes possible buffered writes from the doublewrite memory buffer to disk,
-and also wakes up the aio thread if simulated aio is used. It is very
-important to call this function after a batch of writes has been posted,
-and also when we may have to wait for a page latch! Otherwise a deadlock
-of threads can occur. */
+Returns the doublewrite buffer slot used by a flush type. */
+UNIV_INLINE
+trx_doublewrite_slot_t*
+buf_flush_get_doublewrite_slot(
+/*===========================*/
+					/* out: doublewrite buffer slot */
+	enum buf_flush	flush_type)	/* in: BUF_FLUSH_LRU,
+					BUF_FLUSH_SINGLE_PAGE or
+					BUF_FLUSH_LIST */
+{
+#if TRX_DOUBLEWRITE_N_SLOTS < 2
+# error "TRX_DOUBLEWRITE_N_SLOTS < 2"
+#endif
+	/* Single page flushes share the slot of the LRU flush */
+
+	return(trx_doublewrite->slots + (flush_type == BUF_FLUSH_LIST));
+}
+
+/************************************************************************
+Flushes possible buffered writes from a slot of the doublewrite memory
+buffer to disk, and also wakes up the aio thread if simulated aio is used. */
 static
 void
-buf_flush_buffered_writes(void)
-/*===========================*/
+buf_flush_buffered_writes_low(
+/*==========================*/
+	trx_doublewrite_slot_t*	slot)	/* in: doublewrite buffer slot */
 {
 	byte*		write_buf;
 	ulint		len;
 	ulint		len2;
 	ulint		i;
 
-	if (!srv_use_doublewrite_buf || trx_doublewrite == NULL) {
-		os_aio_simulated_wake_handler_threads();
-
-		return;
-	}
-
-	mutex_enter(&(trx_doublewrite->mutex));
+	mutex_enter(&(slot->mutex));
 
 	/* Write first to doublewrite buffer blocks. We use synchronous
 	aio and thus know that file write has been completed when the
 	control returns. */
 
-	if (trx_doublewrite->first_free == 0) {
+	if (slot->first_free == 0) {
+
+		mutex_exit(&(slot->mutex));
 
-		mutex_exit(&(trx_doublewrite->mutex));
+		/* Pages of tablespaces in the atomic-write mode may have
+		been posted directly to the data files */
+
+		os_aio_simulated_wake_handler_threads();
 
 		return;
 	}
 
-	for (i = 0; i < trx_doublewrite->first_free; i++) {
+	for (i = 0; i < slot->first_free; i++) {
 
 		const buf_block_t*	block;
 
-		block = (buf_block_t*) trx_doublewrite->buf_block_arr[i];
+		block = (buf_block_t*) slot->buf_block_arr[i];
 
 		if (buf_block_get_state(block) != BUF_BLOCK_FILE_PAGE
 		    || block->page.zip.data) {
@@ -381,23 +416,22 @@ corrupted_page:
 	}
 
 	/* increment the doublewrite flushed pages counter */
-	srv_dblwr_pages_written+= trx_doublewrite->first_free;
+	srv_dblwr_pages_written+= slot->first_free;
 	srv_dblwr_writes++;
 
-	len = ut_min(TRX_SYS_DOUBLEWRITE_BLOCK_SIZE,
-		     trx_doublewrite->first_free) * UNIV_PAGE_SIZE;
+	len = slot->first_free * UNIV_PAGE_SIZE;
 
-	write_buf = trx_doublewrite->write_buf;
+	write_buf = slot->write_buf;
 	i = 0;
 
 	fil_io(OS_FILE_WRITE, TRUE, TRX_SYS_SPACE, 0,
-	       trx_doublewrite->block1, 0, len,
+	       slot->page_no, 0, len,
 	       (void*) write_buf, NULL);
 
 	for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len;
 	     len2 += UNIV_PAGE_SIZE, i++) {
 		const buf_block_t* block = (buf_block_t*)
-			trx_doublewrite->buf_block_arr[i];
+			slot->buf_block_arr[i];
 
 		if (UNIV_LIKELY(!block->page.zip.data)
 		    && UNIV_LIKELY(buf_block_get_state(block)
@@ -412,49 +446,10 @@ corrupted_page:
 				"  InnoDB: ERROR: The page to be written"
 				" seems corrupt!\n"
 				"InnoDB: The lsn fields do not match!"
-				" Noticed in the doublewrite block1.\n");
-		}
-	}
-
-	if (trx_doublewrite->first_free <= TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		goto flush;
-	}
-
-	len = (trx_doublewrite->first_free - TRX_SYS_DOUBLEWRITE_BLOCK_SIZE)
-		* UNIV_PAGE_SIZE;
-
-	write_buf = trx_doublewrite->write_buf
-		+ TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
-	ut_ad(i == TRX_SYS_DOUBLEWRITE_BLOCK_SIZE);
-
-	fil_io(OS_FILE_WRITE, TRUE, TRX_SYS_SPACE, 0,
-	       trx_doublewrite->block2, 0, len,
-	       (void*) write_buf, NULL);
-
-	for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len;
-	     len2 += UNIV_PAGE_SIZE, i++) {
-		const buf_block_t* block = (buf_block_t*)
-			trx_doublewrite->buf_block_arr[i];
-
-		if (UNIV_LIKELY(!block->page.zip.data)
-		    && UNIV_LIKELY(buf_block_get_state(block)
-				   == BUF_BLOCK_FILE_PAGE)
-		    && UNIV_UNLIKELY
-		    (memcmp(write_buf + len2 + (FIL_PAGE_LSN + 4),
-			    write_buf + len2
-			    + (UNIV_PAGE_SIZE
-			       - FIL_PAGE_END_LSN_OLD_CHKSUM + 4), 4))) {
-			ut_print_timestamp(stderr);
-			fprintf(stderr,
-				"  InnoDB: ERROR: The page to be"
-				" written seems corrupt!\n"
-				"InnoDB: The lsn fields do not match!"
-				" Noticed in"
-				" the doublewrite block2.\n");
+				" Noticed in the doublewrite block.\n");
 		}
 	}
 
-flush:
 	/* Now flush the doublewrite buffer data to disk */
 
 	fil_flush(TRX_SYS_SPACE);
@@ -463,9 +458,9 @@ flush:
 	and in recovery we will find them in the doublewrite buffer
 	blocks. Next do the writes to the intended positions. */
 
-	for (i = 0; i < trx_doublewrite->first_free; i++) {
+	for (i = 0; i < slot->first_free; i++) {
 		const buf_block_t* block = (buf_block_t*)
-			trx_doublewrite->buf_block_arr[i];
+			slot->buf_block_arr[i];
 
 		ut_a(buf_page_in_file(&block->page));
 		if (UNIV_LIKELY_NULL(block->page.zip.data)) {
@@ -523,32 +518,79 @@ flush:
 
 	/* We can now reuse the doublewrite memory buffer: */
 
-	trx_doublewrite->first_free = 0;
+	slot->first_free = 0;
 
-	mutex_exit(&(trx_doublewrite->mutex));
+	mutex_exit(&(slot->mutex));
 }
 
 /************************************************************************
-Posts a buffer page for writing. If the doublewrite memory buffer is
-full, calls buf_flush_buffered_writes and waits for for free space to
-appear. */
+Flushes possible buffered writes from all the slots of the doublewrite
+memory buffer to disk, and also wakes up the aio thread if simulated aio
+is used. It is very important to call this function when we may have to
+wait for a page latch! Otherwise a deadlock of threads can occur. */
+static
+void
+buf_flush_buffered_writes(void)
+/*===========================*/
+{
+	ulint	i;
+
+	if (!srv_use_doublewrite_buf || trx_doublewrite == NULL) {
+		os_aio_simulated_wake_handler_threads();
+
+		return;
+	}
+
+	for (i = 0; i < TRX_DOUBLEWRITE_N_SLOTS; i++) {
+		buf_flush_buffered_writes_low(trx_doublewrite->slots + i);
+	}
+}
+
+/************************************************************************
+Flushes possible buffered writes of a flush batch from the doublewrite
+memory buffer to disk, and also wakes up the aio thread if simulated aio
+is used. It is very important to call this function after a batch of
+writes has been posted! Otherwise a deadlock of threads can occur. */
+static
+void
+buf_flush_buffered_writes_for_batch(
+/*================================*/
+	enum buf_flush	flush_type)	/* in: BUF_FLUSH_LRU or
+					BUF_FLUSH_LIST */
+{
+	if (!srv_use_doublewrite_buf || trx_doublewrite == NULL) {
+		os_aio_simulated_wake_handler_threads();
+
+		return;
+	}
+
+	buf_flush_buffered_writes_low(
+		buf_flush_get_doublewrite_slot(flush_type));
+}
+
+/************************************************************************
+Posts a buffer page for writing. If the doublewrite memory buffer slot of
+the flush type of the page is full, calls buf_flush_buffered_writes_low
+and waits for for free space to appear. */
 static
 void
 buf_flush_post_to_doublewrite_buf(
 /*==============================*/
 	buf_page_t*	bpage)	/* in: buffer block to write */
 {
-	ulint	zip_size;
+	trx_doublewrite_slot_t*	slot;
+	ulint			zip_size;
+
+	slot = buf_flush_get_doublewrite_slot(buf_page_get_flush_type(bpage));
 try_again:
-	mutex_enter(&(trx_doublewrite->mutex));
+	mutex_enter(&(slot->mutex));
 
 	ut_a(buf_page_in_file(bpage));
 
-	if (trx_doublewrite->first_free
-	    >= 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		mutex_exit(&(trx_doublewrite->mutex));
+	if (slot->first_free >= slot->n_pages) {
+		mutex_exit(&(slot->mutex));
 
-		buf_flush_buffered_writes();
+		buf_flush_buffered_writes_low(slot);
 
 		goto try_again;
 	}
@@ -557,34 +599,33 @@ try_again:
 
 	if (UNIV_UNLIKELY(zip_size)) {
 		/* Copy the compressed page and clear the rest. */
-		memcpy(trx_doublewrite->write_buf
-		       + UNIV_PAGE_SIZE * trx_doublewrite->first_free,
+		memcpy(slot->write_buf
+		       + UNIV_PAGE_SIZE * slot->first_free,
 		       bpage->zip.data, zip_size);
-		memset(trx_doublewrite->write_buf
-		       + UNIV_PAGE_SIZE * trx_doublewrite->first_free
+		memset(slot->write_buf
+		       + UNIV_PAGE_SIZE * slot->first_free
 		       + zip_size, 0, UNIV_PAGE_SIZE - zip_size);
 	} else {
 		ut_a(buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE);
 
-		memcpy(trx_doublewrite->write_buf
-		       + UNIV_PAGE_SIZE * trx_doublewrite->first_free,
+		memcpy(slot->write_buf
+		       + UNIV_PAGE_SIZE * slot->first_free,
 		       ((buf_block_t*) bpage)->frame, UNIV_PAGE_SIZE);
 	}
 
-	trx_doublewrite->buf_block_arr[trx_doublewrite->first_free] = bpage;
+	slot->buf_block_arr[slot->first_free] = bpage;
 
-	trx_doublewrite->first_free++;
+	slot->first_free++;
 
-	if (trx_doublewrite->first_free
-	    >= 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
-		mutex_exit(&(trx_doublewrite->mutex));
+	if (slot->first_free >= slot->n_pages) {
+		mutex_exit(&(slot->mutex));
 
-		buf_flush_buffered_writes();
+		buf_flush_buffered_writes_low(slot);
 
 		return;
 	}
 
-	mutex_exit(&(trx_doublewrite->mutex));
+	mutex_exit(&(slot->mutex));
 }
 
 /************************************************************************
@@ -670,6 +711,7 @@ buf_flush_write_block_low(
 {
 	ulint	zip_size	= buf_page_get_zip_size(bpage);
 	page_t*	frame		= NULL;
+	ibool	use_doublewrite;
 #ifdef UNIV_LOG_DEBUG
 	static ibool univ_log_debug_warned;
 #endif /* UNIV_LOG_DEBUG */
@@ -725,7 +767,18 @@ buf_flush_write_block_low(
 		break;
 	}
 
-	if (!srv_use_doublewrite_buf || !trx_doublewrite) {
+	use_doublewrite = srv_use_doublewrite_buf && trx_doublewrite;
+
+	if (use_doublewrite && srv_use_atomic_writes
+	    && fil_space_get_atomic_writes(buf_page_get_space(bpage))) {
+		/* The device will not tear the page write: there is no
+		need to write the page first to the doublewrite buffer */
+
+		srv_dblwr_pages_skipped++;
+		use_doublewrite = FALSE;
+	}
+
+	if (!use_doublewrite) {
 		fil_io(OS_FILE_WRITE | OS_AIO_SIMULATED_WAKE_LATER,
 		       FALSE, buf_page_get_space(bpage), zip_size,
 		       buf_page_get_page_no(bpage), 0,
@@ -888,7 +941,107 @@ buf_flush_try_page(
 }
 
 /***************************************************************
-Flushes to disk all flushable pages within the flush area. */
+Determines the neighbor flushing policy for a flush batch. In the
+automatic mode, the fsync time per data file write flushed since the
+previous estimate is folded into a moving average, and the neighbors
+are flushed only if the writes look like those of a rotational disk. */
+static
+ulint
+buf_flush_get_neighbors_mode(void)
+/*==============================*/
+				/* out: BUF_FLUSH_NEIGHBORS_OFF, ..._AREA
+				or ..._CONTIGUOUS */
+{
+	ulint	n_flushed_writes;
+	ullint	flush_time_us;
+	ulint	n_writes;
+	ulint	latency;
+
+	if (srv_flush_neighbors != BUF_FLUSH_NEIGHBORS_AUTO) {
+
+		return(srv_flush_neighbors);
+	}
+
+	fil_get_flush_time(&n_flushed_writes, &flush_time_us);
+
+	n_writes = n_flushed_writes - buf_flush_n_flushed_writes_old;
+
+	if (n_writes >= BUF_FLUSH_NEIGHBORS_AUTO_MIN_WRITES) {
+		latency = (ulint) ((flush_time_us
+				    - buf_flush_flush_time_us_old)
+				   / n_writes);
+
+		if (buf_flush_write_latency == 0) {
+			buf_flush_write_latency = latency;
+		} else {
+			buf_flush_write_latency
+				= (7 * buf_flush_write_latency + latency) / 8;
+		}
+
+		buf_flush_n_flushed_writes_old = n_flushed_writes;
+		buf_flush_flush_time_us_old = flush_time_us;
+	}
+
+	if (buf_flush_write_latency == 0) {
+		/* Nothing measured yet, e.g. because the data files are
+		not fsynced: keep the traditional policy */
+
+		return(BUF_FLUSH_NEIGHBORS_AREA);
+	}
+
+	return(buf_flush_write_latency >= BUF_FLUSH_NEIGHBORS_AUTO_LATENCY
+	       ? BUF_FLUSH_NEIGHBORS_AREA : BUF_FLUSH_NEIGHBORS_OFF);
+}
+
+/***************************************************************
+Checks if a neighbor of a page that is being flushed can be flushed
+along with it. The caller must own the buf_pool mutex. */
+static
+ibool
+buf_flush_check_neighbor(
+/*=====================*/
+					/* out: TRUE if the page is in the
+					buffer pool and can be flushed */
+	ulint		space,		/* in: space id */
+	ulint		offset,		/* in: page offset */
+	enum buf_flush	flush_type)	/* in: BUF_FLUSH_LRU or
+					BUF_FLUSH_LIST */
+{
+	buf_page_t*	bpage;
+	mutex_t*	block_mutex;
+	ibool		ret;
+
+	ut_ad(buf_pool_mutex_own());
+
+	bpage = buf_page_hash_get(space, offset);
+
+	if (!bpage) {
+
+		return(FALSE);
+	}
+
+	ut_a(buf_page_in_file(bpage));
+
+	if (flush_type == BUF_FLUSH_LRU && !buf_page_is_old(bpage)) {
+
+		return(FALSE);
+	}
+
+	block_mutex = buf_page_get_mutex(bpage);
+
+	mutex_enter(block_mutex);
+
+	ret = buf_flush_ready_for_flush(bpage, flush_type)
+		&& !bpage->buf_fix_count;
+
+	mutex_exit(block_mutex);
+
+	return(ret);
+}
+
+/***************************************************************
+Flushes to disk a page and the flushable pages around it, as selected by
+the neighbor flushing policy. */
 static
 ulint
 buf_flush_try_neighbors(
@@ -896,20 +1049,26 @@ buf_flush_try_neighbors(
 					/* out: number of pages flushed */
 	ulint		space,		/* in: space id */
 	ulint		offset,		/* in: page offset */
-	enum buf_flush	flush_type)	/* in: BUF_FLUSH_LRU or
+	enum buf_flush	flush_type,	/* in: BUF_FLUSH_LRU or
 					BUF_FLUSH_LIST */
+	ulint		neighbors)	/* in: BUF_FLUSH_NEIGHBORS_OFF, ..._AREA
+					or ..._CONTIGUOUS */
 {
 	buf_page_t*	bpage;
 	ulint		low, high;
 	ulint		count		= 0;
+	ulint		n_neighbors	= 0;
+	ulint		n;
 	ulint		i;
 
 	ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
+	ut_ad(neighbors != BUF_FLUSH_NEIGHBORS_AUTO);
 
 	low = (offset / BUF_FLUSH_AREA) * BUF_FLUSH_AREA;
 	high = (offset / BUF_FLUSH_AREA + 1) * BUF_FLUSH_AREA;
 
-	if (UT_LIST_GET_LEN(buf_pool->LRU) < BUF_LRU_OLD_MIN_LEN) {
+	if (neighbors == BUF_FLUSH_NEIGHBORS_OFF
+	    || UT_LIST_GET_LEN(buf_pool->LRU) < BUF_LRU_OLD_MIN_LEN) {
 		/* If there is little space, it is better not to flush any
 		block except from the end of the LRU list */
 
@@ -925,6 +1084,27 @@ buf_flush_try_neighbors(
 
 	buf_pool_mutex_enter();
 
+	if (neighbors == BUF_FLUSH_NEIGHBORS_CONTIGUOUS) {
+		/* Shrink the area to the run of flushable pages around
+		the page, so that the writes can be merged into one */
+
+		for (i = offset;
+		     i > low && buf_flush_check_neighbor(space, i - 1,
+							 flush_type);
+		     i--) {
+		}
+
+		low = i;
+
+		for (i = offset + 1;
+		     i < high && buf_flush_check_neighbor(space, i,
+							  flush_type);
+		     i++) {
+		}
+
+		high = i;
+	}
+
 	for (i = low; i < high; i++) {
 
 		bpage = buf_page_hash_get(space, i);
@@ -967,8 +1147,13 @@ buf_flush_try_neighbors(
 				therefore we check it again inside that
 				function. */
 
-				count += buf_flush_try_page(space, i,
-							    flush_type);
+				n = buf_flush_try_page(space, i, flush_type);
+
+				count += n;
+
+				if (i != offset) {
+					n_neighbors += n;
+				}
 
 				buf_pool_mutex_enter();
 			} else {
@@ -977,6 +1162,8 @@ buf_flush_try_neighbors(
 		}
 	}
 
+	srv_buf_pool_flushed_neighbors += n_neighbors;
+
 	buf_pool_mutex_exit();
 
 	return(count);
@@ -1014,6 +1201,7 @@ buf_flush_batch(
 	ulint		old_page_count;
 	ulint		space;
 	ulint		offset;
+	ulint		neighbors;
 
 	ut_ad((flush_type == BUF_FLUSH_LRU)
 	      || (flush_type == BUF_FLUSH_LIST));
@@ -1035,6 +1223,8 @@ buf_flush_batch(
 
 	buf_pool->init_flush[flush_type] = TRUE;
 
+	neighbors = buf_flush_get_neighbors_mode();
+
 	for (;;) {
 flush_next:
 		/* If we have flushed enough, leave the loop */
@@ -1086,7 +1276,7 @@ flush_next:
 
 				/* Try to flush also all the neighbors */
 				page_count += buf_flush_try_neighbors(
-					space, offset, flush_type);
+					space, offset, flush_type, neighbors);
 				/* fprintf(stderr,
 				"Flush type %lu, page no %lu, neighb %lu\n",
 				flush_type, offset,
@@ -1127,7 +1317,7 @@ flush_next:
 
 	buf_pool_mutex_exit();
 
-	buf_flush_buffered_writes();
+	buf_flush_buffered_writes_for_batch(flush_type);
 
 #ifdef UNIV_DEBUG
 	if (buf_debug_prints && page_count > 0) {
@@ -1164,10 +1354,16 @@ a big enough margin of replaceable blocks near the end of the LRU list
 and in the free list. */
 static
 ulint
-buf_flush_LRU_recommendation(void)
-/*==============================*/
-			/* out: number of blocks which should be flushed
-			from the end of the LRU list */
+buf_flush_LRU_recommendation_low(
+/*=============================*/
+				/* out: number of blocks which should be
+				flushed from the end of the LRU list */
+	ulint	margin,		/* in: if there are fewer free and
+				replaceable blocks than this, flush */
+	ulint	extra_margin,	/* in: flush so many blocks that there
+				will be this many more than margin */
+	ulint	scan_depth)	/* in: how many blocks to scan from the
+				end of the LRU list */
 {
 	buf_page_t*	bpage;
 	ulint		n_replaceable;
@@ -1180,9 +1376,8 @@ buf_flush_LRU_recommendation(void)
 	bpage = UT_LIST_GET_LAST(buf_pool->LRU);
 
 	while ((bpage != NULL)
-	       && (n_replaceable < BUF_FLUSH_FREE_BLOCK_MARGIN
-		   + BUF_FLUSH_EXTRA_MARGIN)
-	       && (distance < BUF_LRU_FREE_SEARCH_LEN)) {
+	       && (n_replaceable < margin + extra_margin)
+	       && (distance < scan_depth)) {
 
 		mutex_t* block_mutex = buf_page_get_mutex(bpage);
 
@@ -1201,25 +1396,41 @@ buf_flush_LRU_recommendation(void)
 
 	buf_pool_mutex_exit();
 
-	if (n_replaceable >= BUF_FLUSH_FREE_BLOCK_MARGIN) {
+	if (n_replaceable >= margin) {
 
 		return(0);
 	}
 
-	return(BUF_FLUSH_FREE_BLOCK_MARGIN + BUF_FLUSH_EXTRA_MARGIN
-	       - n_replaceable);
+	return(margin + extra_margin - n_replaceable);
+}
+
+/**********************************************************************
+Gives a recommendation of how many blocks should be flushed to establish
+a big enough margin of replaceable blocks near the end of the LRU list
+and in the free list. */
+static
+ulint
+buf_flush_LRU_recommendation(void)
+/*==============================*/
+			/* out: number of blocks which should be flushed
+			from the end of the LRU list */
+{
+	return(buf_flush_LRU_recommendation_low(BUF_FLUSH_FREE_BLOCK_MARGIN,
+						BUF_FLUSH_EXTRA_MARGIN,
+						BUF_LRU_FREE_SEARCH_LEN));
 }
 
 /*************************************************************************
 Flushes pages from the end of the LRU list if there is too small a margin
-of replaceable pages there or in the free list. VERY IMPORTANT: this function
-is called also by threads which have locks on pages. To avoid deadlocks, we
-flush only pages such that the s-lock required for flushing can be acquired
-immediately, without waiting. */
+of replaceable pages there or in the free list, without leaving the work
+to the LRU flusher thread. VERY IMPORTANT: this function is called also by
+threads which have locks on pages. To avoid deadlocks, we flush only pages
+such that the s-lock required for flushing can be acquired immediately,
+without waiting. */
 UNIV_INTERN
 void
-buf_flush_free_margin(void)
-/*=======================*/
+buf_flush_free_margin_low(void)
+/*===========================*/
 {
 	ulint	n_to_flush;
 	ulint	n_flushed;
@@ -1237,6 +1448,70 @@ buf_flush_free_margin(void)
 	}
 }
 
+/*************************************************************************
+Flushes pages from the end of the LRU list if there is too small a margin
+of replaceable pages there or in the free list. If the LRU flusher thread
+is running, it is only woken up to do the flushing. */
+UNIV_INTERN
+void
+buf_flush_free_margin(void)
+/*=======================*/
+{
+	if (srv_LRU_flusher_active && srv_LRU_scan_depth > 0) {
+
+		if (buf_flush_LRU_recommendation() > 0) {
+			os_event_set(srv_LRU_flusher_event);
+		}
+
+		return;
+	}
+
+	buf_flush_free_margin_low();
+}
+
+/*************************************************************************
+Flushes pages from the end of the LRU list so that the free list and the
+last pages of the LRU list contain a reserve of replaceable blocks. This is
+called by the LRU flusher thread, which owns no page latches. */
+UNIV_INTERN
+ibool
+buf_flush_LRU_reserve(
+/*==================*/
+				/* out: TRUE if pages were flushed, or
+				another LRU flush batch was running, so
+				that the reserve may still be short */
+	ulint	n_reserve)	/* in: wished number of free and
+				replaceable blocks */
+{
+	ulint	n_to_flush;
+	ulint	n_flushed;
+
+	/* Never try to keep more than a quarter of the buffer pool
+	replaceable */
+
+	n_reserve = ut_min(n_reserve, buf_pool->curr_size / 4);
+
+	n_to_flush = buf_flush_LRU_recommendation_low(
+		n_reserve, BUF_FLUSH_EXTRA_MARGIN,
+		n_reserve + BUF_FLUSH_EXTRA_MARGIN);
+
+	if (n_to_flush == 0) {
+
+		return(FALSE);
+	}
+
+	n_flushed = buf_flush_batch(BUF_FLUSH_LRU, n_to_flush, 0);
+
+	/* Wait for the writes, and move the flushed blocks to the free
+	list, so that the next recommendation counts them */
+
+	buf_flush_wait_batch_end(BUF_FLUSH_LRU);
+
+	buf_LRU_try_free_flushed_blocks();
+
+	return(n_flushed == ULINT_UNDEFINED || n_flushed > 0);
+}
+
 #if defined UNIV_DEBUG || defined UNIV_BUF_DEBUG
 /**********************************************************************
 Validates the flush list. */
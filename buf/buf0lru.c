@@ -44,6 +44,12 @@ initial segment in buf_LRU_get_recent_limit */
 
 #define BUF_LRU_INITIAL_RATIO	8
 
+/* When the LRU flusher thread is running, a thread that finds no free
+block wakes it up and waits for its flush batch at most this many times
+before it flushes pages itself */
+
+#define BUF_LRU_N_FLUSHER_WAITS	3
+
 /* If we switch on the InnoDB monitor because there are too few available
 frames in the buffer pool, we set this to TRUE */
 UNIV_INTERN ibool	buf_lru_switched_on_innodb_mon	= FALSE;
@@ -610,9 +616,27 @@ loop:
 
 	/* No free block was found: try to flush the LRU list */
 
-	buf_flush_free_margin();
 	++srv_buf_pool_wait_free;
 
+	if (srv_LRU_flusher_active && srv_LRU_scan_depth > 0
+	    && n_iterations <= BUF_LRU_N_FLUSHER_WAITS) {
+		/* Let the LRU flusher thread do the flushing, and wait
+		for its batch to end; only if it cannot keep up, flush
+		in this thread */
+
+		os_event_set(srv_LRU_flusher_event);
+
+		os_thread_sleep(1000);
+
+		buf_flush_wait_batch_end(BUF_FLUSH_LRU);
+
+		n_iterations++;
+
+		goto loop;
+	}
+
+	buf_flush_free_margin_low();
+
 	os_aio_simulated_wake_handler_threads();
 
 	buf_pool_mutex_enter();
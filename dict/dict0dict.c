@@ -27,6 +27,7 @@ Created 1/8/1996 Heikki Tuuri
 #include "que0que.h"
 #include "rem0cmp.h"
 #include "row0merge.h"
+#include "srv0srv.h"
 #ifndef UNIV_HOTBACKUP
 # include "m_ctype.h" /* my_isspace() */
 #endif /* !UNIV_HOTBACKUP */
@@ -51,6 +52,15 @@ UNIV_INTERN rw_lock_t	dict_operation_lock;
 #define DICT_POOL_PER_VARYING	4	/* buffer pool max size per data
 					dictionary varying size in bytes */
 
+/* The id of a table evicted from the dictionary cache, kept in
+dict_sys->evicted_hash so that loading the table again can be counted */
+typedef struct dict_evicted_struct	dict_evicted_t;
+
+struct dict_evicted_struct{
+	dulint		id;		/* table id */
+	hash_node_t	hash;		/* hash chain node */
+};
+
 /* Identifies generated InnoDB foreign key names */
 static char	dict_ibfk[] = "_ibfk_";
 
@@ -359,9 +369,26 @@ dict_table_autoinc_initialize(
 	ut_ad(mutex_own(&table->autoinc_mutex));
 
 	table->autoinc_inited = TRUE;
+	table->autoinc_pinned = FALSE;
 	table->autoinc = value;
 }
 
+/************************************************************************
+Initializes the autoinc counter to a value that cannot be found from the
+rows of the table, as in CREATE TABLE ... AUTO_INCREMENT=N. The table is
+kept in the dictionary cache until the counter is next advanced. */
+UNIV_INTERN
+void
+dict_table_autoinc_initialize_pinned(
+/*=================================*/
+	dict_table_t*	table,	/* in/out: table */
+	ib_longlong	value)	/* in: next value to assign to a row */
+{
+	dict_table_autoinc_initialize(table, value);
+
+	table->autoinc_pinned = TRUE;
+}
+
 /************************************************************************
 Reads the next autoinc value (== autoinc counter value), 0 if not yet
 initialized. */
@@ -400,6 +427,9 @@ dict_table_autoinc_update(
 	if (table->autoinc_inited && value > table->autoinc) {
 
 		table->autoinc = value;
+
+		/* The counter can now be found from the rows */
+		table->autoinc_pinned = FALSE;
 	}
 }
 
@@ -676,6 +706,12 @@ dict_init(void)
 						 * UNIV_WORD_SIZE));
 	dict_sys->size = 0;
 
+	dict_sys->evicted_hash = hash_create(buf_pool_get_curr_size()
+					     / (DICT_POOL_PER_TABLE_HASH
+						* UNIV_WORD_SIZE));
+	dict_sys->n_evicted = 0;
+	dict_sys->n_reloaded = 0;
+
 	UT_LIST_INIT(dict_sys->table_LRU);
 
 	rw_lock_create(&dict_operation_lock, SYNC_DICT_OPERATION);
@@ -708,8 +744,20 @@ dict_table_get(
 
 	table = dict_table_get_low(table_name);
 
-	if (inc_mysql_count && table) {
-		table->n_mysql_handles_opened++;
+	if (table) {
+		if (inc_mysql_count) {
+			table->n_mysql_handles_opened++;
+		}
+
+		/* Move the table to the head of the LRU list, so that
+		dict_table_LRU_trim() evicts the least recently used
+		tables first */
+
+		if (table != UT_LIST_GET_FIRST(dict_sys->table_LRU)) {
+			UT_LIST_REMOVE(table_LRU, dict_sys->table_LRU, table);
+			UT_LIST_ADD_FIRST(table_LRU, dict_sys->table_LRU,
+					  table);
+		}
 	}
 
 	mutex_exit(&(dict_sys->mutex));
@@ -772,6 +820,43 @@ dict_table_add_system_columns(
 #endif
 }
 
+/**************************************************************************
+Forgets that a table was evicted from the dictionary cache. */
+static
+ibool
+dict_evicted_remove(
+/*================*/
+			/* out: TRUE if the table had been evicted */
+	dulint	id)	/* in: table id */
+{
+	dict_evicted_t*	evicted;
+	ulint		id_fold;
+
+	ut_ad(mutex_own(&(dict_sys->mutex)));
+
+	if (UNIV_LIKELY(dict_sys->n_evicted == 0)) {
+
+		return(FALSE);
+	}
+
+	id_fold = ut_fold_dulint(id);
+
+	HASH_SEARCH(hash, dict_sys->evicted_hash, id_fold,
+		    dict_evicted_t*, evicted,
+		    (ut_dulint_cmp(evicted->id, id) == 0));
+
+	if (evicted == NULL) {
+
+		return(FALSE);
+	}
+
+	HASH_DELETE(dict_evicted_t, hash, dict_sys->evicted_hash, id_fold,
+		    evicted);
+	mem_free(evicted);
+
+	return(TRUE);
+}
+
 /**************************************************************************
 Adds a table object to the dictionary cache. */
 UNIV_INTERN
@@ -834,6 +919,13 @@ dict_table_add_to_cache(
 		ut_a(table2 == NULL);
 	}
 
+	/* If the table was evicted from the cache earlier, count the
+	reload and forget the eviction */
+	if (dict_evicted_remove(table->id)) {
+
+		dict_sys->n_reloaded++;
+	}
+
 	/* Add table to hash table of tables */
 	HASH_INSERT(dict_table_t, name_hash, dict_sys->table_hash, fold,
 		    table);
@@ -1178,6 +1270,10 @@ dict_table_remove_from_cache(
 	HASH_DELETE(dict_table_t, id_hash, dict_sys->table_id_hash,
 		    ut_fold_dulint(table->id), table);
 
+	/* A table that is dropped or renamed away is not loaded back:
+	do not leave its id in the hash table of evicted tables */
+	dict_evicted_remove(table->id);
+
 	/* Remove table from LRU list of tables */
 	UT_LIST_REMOVE(table_LRU, dict_sys->table_LRU, table);
 
@@ -1190,6 +1286,124 @@ dict_table_remove_from_cache(
 	dict_mem_table_free(table);
 }
 
+/**************************************************************************
+Checks if a table can be evicted from the dictionary cache. */
+static
+ibool
+dict_table_can_be_evicted(
+/*======================*/
+				/* out: TRUE if the table is not in use */
+	dict_table_t*	table)	/* in: table */
+{
+	dict_index_t*	index;
+
+	ut_ad(mutex_own(&(dict_sys->mutex)));
+	ut_ad(mutex_own(&kernel_mutex));
+
+	/* The system tables and the insert buffer trees have no
+	database name. The auto-increment counter is rebuilt from the
+	index when the table is loaded again, except for the value of a
+	CREATE TABLE ... AUTO_INCREMENT=N before the first insert. */
+
+	if (!strchr(table->name, '/')
+	    || table->n_mysql_handles_opened > 0
+	    || table->n_foreign_key_checks_running > 0
+	    || table->n_waiting_or_granted_auto_inc_locks > 0
+	    || table->autoinc_pinned
+	    || UT_LIST_GET_LEN(table->locks) > 0
+	    || UT_LIST_GET_LEN(table->foreign_list) > 0
+	    || UT_LIST_GET_LEN(table->referenced_list) > 0) {
+
+		return(FALSE);
+	}
+
+	/* The adaptive hash index of a buffer pool page points to the
+	index object; the index cannot be freed before all such pages
+	have been dropped from the hash index */
+
+	for (index = dict_table_get_first_index(table);
+	     index != NULL;
+	     index = dict_table_get_next_index(index)) {
+
+		if (btr_search_info_get_ref_count(index->search_info) > 0) {
+
+			return(FALSE);
+		}
+	}
+
+	return(TRUE);
+}
+
+/**************************************************************************
+Evicts unused tables from the tail of the dictionary cache LRU list until
+the cache occupies at most the given number of bytes. A table is evicted
+only if MySQL has no handles open to it, it has no locks, no foreign key
+constraints, no pinned auto-increment counter and no adaptive hash
+index pages in the buffer pool. Does
+nothing if a table create, drop, etc. is in progress. */
+UNIV_INTERN
+ulint
+dict_table_LRU_trim(
+/*================*/
+				/* out: number of tables evicted */
+	ulint	max_size)	/* in: size limit of the cache in bytes */
+{
+	dict_table_t*	table;
+	dict_table_t*	prev_table;
+	ulint		n_evicted	= 0;
+
+	if (dict_sys->size <= max_size) {
+
+		return(0);
+	}
+
+	/* Purge, rollback and foreign key checks use tables without
+	MySQL handles; they hold dict_operation_lock in S-mode */
+
+	if (!rw_lock_x_lock_nowait(&dict_operation_lock)) {
+
+		return(0);
+	}
+
+	mutex_enter(&(dict_sys->mutex));
+
+	table = UT_LIST_GET_LAST(dict_sys->table_LRU);
+
+	while (table != NULL && dict_sys->size > max_size) {
+		ibool	evict;
+
+		prev_table = UT_LIST_GET_PREV(table_LRU, table);
+
+		mutex_enter(&kernel_mutex);
+		evict = dict_table_can_be_evicted(table);
+		mutex_exit(&kernel_mutex);
+
+		if (evict) {
+			dict_evicted_t*	evicted;
+
+			evicted = mem_alloc(sizeof(dict_evicted_t));
+			evicted->id = table->id;
+
+			dict_table_remove_from_cache(table);
+
+			HASH_INSERT(dict_evicted_t, hash,
+				    dict_sys->evicted_hash,
+				    ut_fold_dulint(evicted->id), evicted);
+
+			dict_sys->n_evicted++;
+			n_evicted++;
+		}
+
+		table = prev_table;
+	}
+
+	mutex_exit(&(dict_sys->mutex));
+
+	rw_lock_x_unlock(&dict_operation_lock);
+
+	return(n_evicted);
+}
+
 /********************************************************************
 If the given column name is reserved for InnoDB system columns, return
 TRUE. */
@@ -1324,6 +1538,51 @@ is_ord_part:
 	return(undo_page_len >= UNIV_PAGE_SIZE);
 }
 
+/**************************************************************************
+Precomputes the end offsets of the leading fixed-length NOT NULL fields
+of an index.  rec_get_offsets() copies them instead of decoding the
+record header field by field; when all fields of the index are covered,
+decoding a ROW_FORMAT=COMPACT leaf record becomes a single copy. */
+static
+void
+dict_index_build_fixed_offs(
+/*========================*/
+	dict_index_t*	index)	/* in/out: index in the cache internal
+				representation */
+{
+	ulint*	offs;
+	ulint	end	= 0;
+	ulint	i;
+
+	for (i = 0; i < index->n_fields; i++) {
+		const dict_field_t*	field
+			= dict_index_get_nth_field(index, i);
+
+		if (!field->fixed_len
+		    || !(dict_field_get_col(field)->prtype & DATA_NOT_NULL)) {
+
+			break;
+		}
+	}
+
+	index->n_fixed_prefix = (unsigned int) i;
+
+	if (!i) {
+		index->fixed_offs = NULL;
+
+		return;
+	}
+
+	offs = mem_heap_alloc(index->heap, i * sizeof *offs);
+
+	for (i = 0; i < index->n_fixed_prefix; i++) {
+		end += dict_index_get_nth_field(index, i)->fixed_len;
+		offs[i] = end;
+	}
+
+	index->fixed_offs = offs;
+}
+
 /**************************************************************************
 Adds an index to the dictionary cache. */
 UNIV_INTERN
@@ -1365,6 +1624,8 @@ dict_index_add_to_cache(
 
 	new_index->n_fields = new_index->n_def;
 
+	dict_index_build_fixed_offs(new_index);
+
 	if (UNIV_UNLIKELY(index->type & DICT_UNIVERSAL)) {
 		n_ord = new_index->n_fields;
 	} else {
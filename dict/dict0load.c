@@ -351,9 +351,18 @@ loop:
 			/* It is a normal database startup: create the space
 			object and check that the .ibd file exists. */
 
-			fil_open_single_table_tablespace(FALSE, space_id,
-							 zip_size_in_k * 1024,
-							 name);
+			if (srv_lazy_open_tablespaces) {
+				/* Leave the .ibd file alone until the
+				table is loaded or its pages are
+				accessed */
+
+				fil_space_create_unopened(
+					space_id, zip_size_in_k * 1024, name);
+			} else {
+				fil_open_single_table_tablespace(
+					FALSE, space_id, zip_size_in_k * 1024,
+					name);
+			}
 		}
 
 		mem_free(name);
@@ -840,6 +849,14 @@ err_exit:
 						      FALSE, FALSE)) {
 			/* Ok; (if we did a crash recovery then the tablespace
 			can already be in the memory cache) */
+
+			if (srv_lazy_open_tablespaces
+			    && !fil_space_check_unopened(space)) {
+				/* The space object was created at
+				startup without looking at the file */
+
+				ibd_file_missing = TRUE;
+			}
 		} else {
 			/* In >= 4.1.9, InnoDB scans the data dictionary also
 			at a normal mysqld startup. It is an error if the
@@ -80,10 +80,18 @@ Some operating systems do not support many open files at the same time,
 though NT seems to tolerate at least 900 open files. Therefore, we put the
 open files in an LRU-list. If we need to open another file, we may close the
 file at the end of the LRU-list. When an i/o-operation is pending on a file,
-the file cannot be closed. We take the file nodes with pending i/o-operations
-out of the LRU-list and keep a count of pending operations. When an operation
-completes, we decrement the count and return the file node to the LRU-list if
-the count drops to zero. */
+the file cannot be closed. We keep a count of pending operations in the file
+node, and skip the nodes where it is nonzero when we look for a file to close.
+
+An i/o on a file which is already open does not reserve the fil_system mutex.
+The spaces are divided into FIL_N_IO_MUTEXES groups by their cell in the
+space id hash table. The i/o mutex of a group protects the hash chains of
+its cells, and the fields of its nodes which change on every i/o: the count
+of pending operations and the modification counter. An i/o only marks the
+node accessed; the node is moved to the start of the LRU-list when the
+file closing finds it marked at the end of the list. The master thread
+closes files in the background so that opening a file in fil_io() seldom
+has to close another one first. */
 
 /* When mysqld is run, the default directory "." is the mysqld datadir,
 but in the MySQL Embedded Server Library and ibbackup it is not the default
@@ -96,6 +104,15 @@ UNIV_INTERN ulint	fil_n_log_flushes			= 0;
 UNIV_INTERN ulint	fil_n_pending_log_flushes		= 0;
 UNIV_INTERN ulint	fil_n_pending_tablespace_flushes	= 0;
 
+/* The number of data file writes made durable by fsyncs and the total
+duration of those fsyncs in microseconds, protected by the fil_system
+mutex: from these, buf_flush estimates the write latency of the storage.
+An fsync waits for the writes cached by the OS, or by the drive, to reach
+the media, so its duration per write reflects the device whatever the
+flush method and the aio implementation are. */
+static ulint	fil_n_flushed_writes	= 0;
+static ullint	fil_flush_time_us	= 0;
+
 /* Null file address */
 UNIV_INTERN fil_addr_t	fil_addr_null = {FIL_NULL, 0};
 
@@ -114,19 +131,31 @@ struct fil_node_struct {
 	ulint		n_pending;
 				/* count of pending i/o's on this file;
 				closing of the file is not allowed if
-				this is > 0 */
+				this is > 0; protected by the i/o mutex
+				of the space */
 	ulint		n_pending_flushes;
 				/* count of pending flushes on this file;
 				closing of the file is not allowed if
 				this is > 0 */
 	ib_longlong	modification_counter;/* when we write to the file we
-				increment this by one */
+				increment this by one; protected by the
+				i/o mutex of the space */
 	ib_longlong	flush_counter;/* up to what modification_counter value
 				we have flushed the modifications to disk */
 	UT_LIST_NODE_T(fil_node_t) chain;
 				/* link field for the file chain */
 	UT_LIST_NODE_T(fil_node_t) LRU;
 				/* link field for the LRU list */
+	ibool		LRU_accessed;
+				/* TRUE if an i/o has been done on the
+				file since the node was last moved to the
+				start of the LRU list; protected by the
+				i/o mutex of the space */
+	ibool		unbuffered;
+				/* TRUE if the file was opened with the
+				file cache of the operating system bypassed,
+				see os_file_is_unbuffered(); remembered when
+				the file is closed */
 	ulint		magic_n;
 };
 
@@ -160,6 +189,13 @@ struct fil_space_struct {
 				or flush requests can be placed on this space,
 				though there may be such requests still being
 				processed on this space */
+	ibool		unchecked;/* TRUE if the space was created by
+				fil_space_create_unopened() and its .ibd file
+				has not been opened and checked yet */
+	ibool		missing;/* TRUE if the .ibd file of an unchecked
+				space could not be opened or does not match
+				the data dictionary; i/o to the space fails
+				as if the space did not exist */
 	ulint		purpose;/* FIL_TABLESPACE, FIL_LOG, or FIL_ARCH_LOG */
 	UT_LIST_BASE_NODE_T(fil_node_t) chain;
 				/* base node for the file chain */
@@ -189,6 +225,17 @@ struct fil_space_struct {
 				file we have written to */
 	ibool		is_in_unflushed_spaces; /* TRUE if this space is
 				currently in the list above */
+	UT_LIST_NODE_T(fil_space_t) prealloc_spaces;
+				/* list of spaces waiting for the
+				preallocation thread */
+	ibool		is_in_prealloc_spaces; /* TRUE if this space is
+				currently in the list above */
+	ulint		prealloc_size;/* the preallocation thread extends
+				the space to this size in pages */
+	ibool		atomic_writes;/* TRUE if the pages of the space are
+				written without the doublewrite buffer, see
+				fil_space_can_skip_doublewrite(); protected
+				by the i/o mutex of the space */
 	UT_LIST_NODE_T(fil_space_t) space_list;
 				/* list of all spaces */
 	ibuf_data_t*	ibuf_data;
@@ -202,21 +249,34 @@ struct fil_space_struct {
 is stored here; below we talk about tablespaces, but also the ib_logfiles
 form a 'space' and it is handled here */
 
+/* Number of i/o mutexes in the tablespace memory cache */
+#define FIL_N_IO_MUTEXES	64
+
+/* The preallocation thread extends a tablespace by at most this many pages
+at a time while holding the fil_system mutex */
+#define FIL_PREALLOC_STEP	256
+
 typedef	struct fil_system_struct	fil_system_t;
 struct fil_system_struct {
 	mutex_t		mutex;		/* The mutex protecting the cache */
+	mutex_t		io_mutexes[FIL_N_IO_MUTEXES];
+					/* The mutexes protecting the
+					pending i/o counts and the
+					modification counters of the file
+					nodes, and the hash chains of the
+					spaces table; see
+					fil_space_get_io_mutex() */
 	hash_table_t*	spaces;		/* The hash table of spaces in the
 					system; they are hashed on the space
-					id */
+					id; modifying a hash chain requires
+					also the i/o mutex of the chain */
 	hash_table_t*	name_hash;	/* hash table based on the space
 					name */
 	UT_LIST_BASE_NODE_T(fil_node_t) LRU;
 					/* base node for the LRU list of the
-					most recently used open files with no
-					pending i/o's; if we start an i/o on
-					the file, we first remove it from this
-					list, and return it to the start of
-					the list when the i/o ends;
+					most recently used open files; a file
+					with pending i/o's stays in the list,
+					but it is not closed;
 					log files and the system tablespace are
 					not put to this list: they are opened
 					after the startup, and kept open until
@@ -227,11 +287,13 @@ struct fil_system_struct {
 					unflushed writes; those spaces have
 					at least one file node where
 					modification_counter > flush_counter */
+	UT_LIST_BASE_NODE_T(fil_space_t) prealloc_spaces;
+					/* base node for the list of those
+					tablespaces which the preallocation
+					thread should extend */
 	ulint		n_open;		/* number of files currently open */
 	ulint		max_n_open;	/* n_open is not allowed to exceed
 					this */
-	ib_longlong	modification_counter;/* when we write to a file we
-					increment this by one */
 	ulint		max_assigned_id;/* maximum space id in the existing
 					tables, or assigned during the time
 					mysqld has been up; at an InnoDB
@@ -259,19 +321,23 @@ UNIV_INTERN fil_system_t*	fil_system	= NULL;
 NOTE: you must call fil_mutex_enter_and_prepare_for_io() first!
 
 Prepares a file node for i/o. Opens the file if it is closed. Updates the
-pending i/o's field in the node and the system appropriately. Takes the node
-off the LRU list if it is in the LRU list. The caller must hold the fil_sys
-mutex. */
+pending i/o's field in the node and the system appropriately. Moves the node
+to the start of the LRU list if it is in the LRU list. The caller must hold
+the fil_sys mutex. */
 static
-void
+ibool
 fil_node_prepare_for_io(
 /*====================*/
+				/* out: TRUE if success, FALSE if the file
+				of an unchecked tablespace turned out to
+				be missing: then no i/o is pending */
 	fil_node_t*	node,	/* in: file node */
 	fil_system_t*	system,	/* in: tablespace memory cache */
 	fil_space_t*	space);	/* in: space */
 /************************************************************************
 Updates the data structures when an i/o operation finishes. Updates the
-pending i/o's field in the node appropriately. */
+pending i/o's field in the node appropriately. The caller must hold the
+fil_sys mutex. */
 static
 void
 fil_node_complete_io(
@@ -281,6 +347,20 @@ fil_node_complete_io(
 	ulint		type);	/* in: OS_FILE_WRITE or OS_FILE_READ; marks
 				the node as modified if
 				type == OS_FILE_WRITE */
+
+/***********************************************************************
+Returns the i/o mutex of a space. The spaces in the same cell of the space
+id hash table share the mutex. */
+UNIV_INLINE
+mutex_t*
+fil_space_get_io_mutex(
+/*===================*/
+			/* out: i/o mutex */
+	ulint	id)	/* in: space id */
+{
+	return(fil_system->io_mutexes
+	       + hash_calc_hash(id, fil_system->spaces) % FIL_N_IO_MUTEXES);
+}
 /***********************************************************************
 Checks if a single-table tablespace for a given table name exists in the
 tablespace memory cache. */
@@ -505,7 +585,7 @@ fil_space_get_ibuf_data(
 
 /**************************************************************************
 Checks if all the file nodes in a space are flushed. The caller must hold
-the fil_system mutex. */
+the fil_system mutex and the i/o mutex of the space. */
 static
 ibool
 fil_space_is_flushed(
@@ -516,6 +596,7 @@ fil_space_is_flushed(
 	fil_node_t*	node;
 
 	ut_ad(mutex_own(&(fil_system->mutex)));
+	ut_ad(mutex_own(fil_space_get_io_mutex(space->id)));
 
 	node = UT_LIST_GET_FIRST(space->chain);
 
@@ -565,6 +646,8 @@ fil_node_create(
 	node->magic_n = FIL_NODE_MAGIC_N;
 	node->n_pending = 0;
 	node->n_pending_flushes = 0;
+	node->LRU_accessed = FALSE;
+	node->unbuffered = FALSE;
 
 	node->modification_counter = 0;
 	node->flush_counter = 0;
@@ -591,26 +674,75 @@ fil_node_create(
 
 	node->space = space;
 
+	mutex_enter(fil_space_get_io_mutex(id));
 	UT_LIST_ADD_LAST(chain, space->chain, node);
+	/* The new file has not been opened yet */
+	space->atomic_writes = FALSE;
+	mutex_exit(fil_space_get_io_mutex(id));
 
 	mutex_exit(&(system->mutex));
 }
 
+/***********************************************************************
+Checks if the pages of a tablespace can be written without going through
+the doublewrite buffer. This requires that the user has declared with
+innodb_use_atomic_writes that the storage never tears a page write, and
+that every file of the space has been opened unbuffered, so that a page
+write reaches the device as a single aligned request. A torn page in such
+a space is not repaired at startup; buf_page_is_corrupted() reports it
+when the page is read. The caller must own the i/o mutex of the space. */
+static
+ibool
+fil_space_can_skip_doublewrite(
+/*===========================*/
+				/* out: TRUE if the doublewrite buffer
+				can be skipped */
+	fil_space_t*	space)	/* in: tablespace */
+{
+	fil_node_t*	node;
+
+	ut_ad(mutex_own(fil_space_get_io_mutex(space->id)));
+
+	if (!srv_use_atomic_writes || space->purpose != FIL_TABLESPACE) {
+
+		return(FALSE);
+	}
+
+	for (node = UT_LIST_GET_FIRST(space->chain);
+	     node != NULL;
+	     node = UT_LIST_GET_NEXT(chain, node)) {
+
+		if (!node->unbuffered) {
+
+			return(FALSE);
+		}
+	}
+
+	return(TRUE);
+}
+
 /************************************************************************
-Opens a the file of a node of a tablespace. The caller must own the fil_system
-mutex. */
+Opens the .ibd file of a single-table tablespace whose size is not known
+yet, reads the size, and checks the space id and the compressed page size
+in the header against the memory object. A failed check is fatal, unless
+the space was created by fil_space_create_unopened() and has not been
+checked yet: then the error is printed and FALSE returned, so that the
+tablespace can be treated as missing, as it is when
+fil_open_single_table_tablespace() fails at a normal startup. The caller
+must own the fil_system mutex. */
 static
-void
-fil_node_open_file(
+ibool
+fil_node_read_size(
 /*===============*/
-	fil_node_t*	node,	/* in: file node */
+				/* out: TRUE if success, FALSE if the
+				check of an unchecked tablespace failed */
+	fil_node_t*	node,	/* in: file node, not open, size 0 */
 	fil_system_t*	system,	/* in: tablespace memory cache */
 	fil_space_t*	space)	/* in: space */
 {
 	ib_longlong	size_bytes;
 	ulint		size_low;
 	ulint		size_high;
-	ibool		ret;
 	ibool		success;
 #ifndef UNIV_HOTBACKUP
 	byte*		buf2;
@@ -620,119 +752,164 @@ fil_node_open_file(
 #endif /* !UNIV_HOTBACKUP */
 
 	ut_ad(mutex_own(&(system->mutex)));
-	ut_a(node->n_pending == 0);
 	ut_a(node->open == FALSE);
+	ut_a(node->size == 0);
+
+	/* It must be a single-table tablespace and we do not know the
+	size of the file yet. First we open the file in the normal
+	mode, no async I/O here, for simplicity. Then do some checks,
+	and close the file again.
+	NOTE that we could not use the simple file read function
+	os_file_read() in Windows to read from a file opened for
+	async I/O! */
+
+	node->handle = os_file_create_simple_no_error_handling(
+		node->name, OS_FILE_OPEN, OS_FILE_READ_ONLY, &success);
+	if (!success) {
+		/* The following call prints an error message */
+		os_file_get_last_error(TRUE);
 
-	if (node->size == 0) {
-		/* It must be a single-table tablespace and we do not know the
-		size of the file yet. First we open the file in the normal
-		mode, no async I/O here, for simplicity. Then do some checks,
-		and close the file again.
-		NOTE that we could not use the simple file read function
-		os_file_read() in Windows to read from a file opened for
-		async I/O! */
-
-		node->handle = os_file_create_simple_no_error_handling(
-			node->name, OS_FILE_OPEN, OS_FILE_READ_ONLY, &success);
-		if (!success) {
-			/* The following call prints an error message */
-			os_file_get_last_error(TRUE);
+		ut_print_timestamp(stderr);
 
-			ut_print_timestamp(stderr);
+		fprintf(stderr,
+			"  InnoDB: %s: cannot open %s\n."
+			"InnoDB: Have you deleted .ibd files"
+			" under a running mysqld server?\n",
+			space->unchecked ? "Error" : "Fatal error",
+			node->name);
 
-			fprintf(stderr,
-				"  InnoDB: Fatal error: cannot open %s\n."
-				"InnoDB: Have you deleted .ibd files"
-				" under a running mysqld server?\n",
-				node->name);
-			ut_a(0);
-		}
+		goto func_exit;
+	}
 
-		os_file_get_size(node->handle, &size_low, &size_high);
+	os_file_get_size(node->handle, &size_low, &size_high);
 
-		size_bytes = (((ib_longlong)size_high) << 32)
-			+ (ib_longlong)size_low;
+	size_bytes = (((ib_longlong)size_high) << 32)
+		+ (ib_longlong)size_low;
 #ifdef UNIV_HOTBACKUP
-		node->size = (ulint) (size_bytes / UNIV_PAGE_SIZE);
-
+	node->size = (ulint) (size_bytes / UNIV_PAGE_SIZE);
 #else
-		ut_a(space->purpose != FIL_LOG);
-		ut_a(space->id != 0);
+	ut_a(space->purpose != FIL_LOG);
+	ut_a(space->id != 0);
 
-		if (size_bytes < FIL_IBD_FILE_INITIAL_SIZE * UNIV_PAGE_SIZE) {
-			fprintf(stderr,
-				"InnoDB: Error: the size of single-table"
-				" tablespace file %s\n"
-				"InnoDB: is only %lu %lu,"
-				" should be at least %lu!\n",
-				node->name,
-				(ulong) size_high,
-				(ulong) size_low,
-				(ulong) (FIL_IBD_FILE_INITIAL_SIZE
-					 * UNIV_PAGE_SIZE));
-
-			ut_a(0);
-		}
+	if (size_bytes < FIL_IBD_FILE_INITIAL_SIZE * UNIV_PAGE_SIZE) {
+		fprintf(stderr,
+			"InnoDB: Error: the size of single-table"
+			" tablespace file %s\n"
+			"InnoDB: is only %lu %lu,"
+			" should be at least %lu!\n",
+			node->name,
+			(ulong) size_high,
+			(ulong) size_low,
+			(ulong) (FIL_IBD_FILE_INITIAL_SIZE
+				 * UNIV_PAGE_SIZE));
 
-		/* Read the first page of the tablespace */
+		os_file_close(node->handle);
 
-		buf2 = ut_malloc(2 * UNIV_PAGE_SIZE);
-		/* Align the memory for file i/o if we might have O_DIRECT
-		set */
-		page = ut_align(buf2, UNIV_PAGE_SIZE);
+		success = FALSE;
 
-		success = os_file_read(node->handle, page, 0, 0,
-				       UNIV_PAGE_SIZE);
-		space_id = fsp_header_get_space_id(page);
-		zip_size = fsp_header_get_zip_size(page);
+		goto func_exit;
+	}
 
-		ut_free(buf2);
+	/* Read the first page of the tablespace */
 
-		/* Close the file now that we have read the space id from it */
+	buf2 = ut_malloc(2 * UNIV_PAGE_SIZE);
+	/* Align the memory for file i/o if we might have O_DIRECT
+	set */
+	page = ut_align(buf2, UNIV_PAGE_SIZE);
 
-		os_file_close(node->handle);
+	success = os_file_read(node->handle, page, 0, 0,
+			       UNIV_PAGE_SIZE);
+	space_id = fsp_header_get_space_id(page);
+	zip_size = fsp_header_get_zip_size(page);
 
-		if (space_id == ULINT_UNDEFINED || space_id == 0) {
-			fprintf(stderr,
-				"InnoDB: Error: tablespace id %lu"
-				" in file %s is not sensible\n",
-				(ulong) space_id, node->name);
+	ut_free(buf2);
 
-			ut_a(0);
-		}
+	/* Close the file now that we have read the space id from it */
 
-		if (space_id != space->id) {
-			fprintf(stderr,
-				"InnoDB: Error: tablespace id is %lu"
-				" in the data dictionary\n"
-				"InnoDB: but in file %s it is %lu!\n",
-				space->id, node->name, space_id);
+	os_file_close(node->handle);
 
-			ut_a(0);
-		}
+	if (space_id == ULINT_UNDEFINED || space_id == 0) {
+		fprintf(stderr,
+			"InnoDB: Error: tablespace id %lu"
+			" in file %s is not sensible\n",
+			(ulong) space_id, node->name);
 
-		if (UNIV_UNLIKELY(zip_size != space->zip_size)) {
-			fprintf(stderr,
-				"InnoDB: Error: compressed page size is %lu"
-				" in the data dictionary\n"
-				"InnoDB: but in file %s it is %lu!\n",
-				space->zip_size, node->name, zip_size);
+		success = FALSE;
+	} else if (space_id != space->id) {
+		fprintf(stderr,
+			"InnoDB: Error: tablespace id is %lu"
+			" in the data dictionary\n"
+			"InnoDB: but in file %s it is %lu!\n",
+			space->id, node->name, space_id);
 
-			ut_error;
-		}
+		success = FALSE;
+	} else if (UNIV_UNLIKELY(zip_size != space->zip_size)) {
+		fprintf(stderr,
+			"InnoDB: Error: compressed page size is %lu"
+			" in the data dictionary\n"
+			"InnoDB: but in file %s it is %lu!\n",
+			space->zip_size, node->name, zip_size);
 
-		if (size_bytes >= 1024 * 1024) {
-			/* Truncate the size to whole megabytes. */
-			size_bytes = ut_2pow_round(size_bytes, 1024 * 1024);
-		}
+		success = FALSE;
+	}
 
-		if (!zip_size) {
-			node->size = (ulint) (size_bytes / UNIV_PAGE_SIZE);
-		} else {
-			node->size = (ulint) (size_bytes / zip_size);
-		}
+	if (!success) {
+
+		goto func_exit;
+	}
+
+	if (size_bytes >= 1024 * 1024) {
+		/* Truncate the size to whole megabytes. */
+		size_bytes = ut_2pow_round(size_bytes, 1024 * 1024);
+	}
+
+	if (!zip_size) {
+		node->size = (ulint) (size_bytes / UNIV_PAGE_SIZE);
+	} else {
+		node->size = (ulint) (size_bytes / zip_size);
+	}
 #endif
-		space->size += node->size;
+	space->size += node->size;
+	space->unchecked = FALSE;
+
+func_exit:
+	if (!success) {
+		/* Only a tablespace that was not checked at startup
+		may turn out to be missing */
+
+		ut_a(space->unchecked);
+
+		space->missing = TRUE;
+	}
+
+	return(success);
+}
+
+/************************************************************************
+Opens a the file of a node of a tablespace. The caller must own the fil_system
+mutex. */
+static
+ibool
+fil_node_open_file(
+/*===============*/
+				/* out: TRUE if success, FALSE if the
+				file of a tablespace created by
+				fil_space_create_unopened() turned out
+				to be missing, see fil_node_read_size() */
+	fil_node_t*	node,	/* in: file node */
+	fil_system_t*	system,	/* in: tablespace memory cache */
+	fil_space_t*	space)	/* in: space */
+{
+	ibool		ret;
+
+	ut_ad(mutex_own(&(system->mutex)));
+	ut_a(node->n_pending == 0);
+	ut_a(node->open == FALSE);
+
+	if (node->size == 0
+	    && !fil_node_read_size(node, system, space)) {
+
+		return(FALSE);
 	}
 
 	/* printf("Opening file %s\n", node->name); */
@@ -755,18 +932,26 @@ fil_node_open_file(
 
 	ut_a(ret);
 
+	mutex_enter(fil_space_get_io_mutex(space->id));
 	node->open = TRUE;
+	node->unbuffered = os_file_is_unbuffered(node->handle);
+	space->atomic_writes = fil_space_can_skip_doublewrite(space);
+	mutex_exit(fil_space_get_io_mutex(space->id));
 
 	system->n_open++;
 
 	if (space->purpose == FIL_TABLESPACE && space->id != 0) {
 		/* Put the node to the LRU list */
+		node->LRU_accessed = FALSE;
 		UT_LIST_ADD_FIRST(LRU, system->LRU, node);
 	}
+
+	return(TRUE);
 }
 
 /**************************************************************************
-Closes a file. */
+Closes a file. The caller must hold the fil_system mutex and the i/o mutex
+of the space. */
 static
 void
 fil_node_close_file(
@@ -778,6 +963,7 @@ fil_node_close_file(
 
 	ut_ad(node && system);
 	ut_ad(mutex_own(&(system->mutex)));
+	ut_ad(mutex_own(fil_space_get_io_mutex(node->space->id)));
 	ut_a(node->open);
 	ut_a(node->n_pending == 0);
 	ut_a(node->n_pending_flushes == 0);
@@ -801,7 +987,10 @@ fil_node_close_file(
 }
 
 /************************************************************************
-Tries to close a file in the LRU list. The caller must hold the fil_sys
+Tries to close a file in the LRU list. A file which has been accessed since
+it was last moved to the start of the list is given a second chance: it is
+moved to the start and closed only if no unaccessed file can be closed.
+Each node is visited at most twice. The caller must hold the fil_sys
 mutex. */
 static
 ibool
@@ -819,26 +1008,69 @@ fil_try_to_close_file_in_LRU(
 {
 	fil_system_t*	system		= fil_system;
 	fil_node_t*	node;
+	fil_node_t*	prev_node;
+	mutex_t*	io_mutex;
+	ulint		n_visits;
 
 	ut_ad(mutex_own(&(system->mutex)));
 
 	node = UT_LIST_GET_LAST(system->LRU);
 
+	/* Bound the scan to one second-chance pass: the i/o threads may
+	mark the nodes accessed again under the i/o mutex while we walk */
+
+	n_visits = 2 * UT_LIST_GET_LEN(system->LRU);
+
 	if (print_info) {
 		fprintf(stderr,
 			"InnoDB: fil_sys open file LRU len %lu\n",
 			(ulong) UT_LIST_GET_LEN(system->LRU));
 	}
 
-	while (node != NULL) {
+	while (node != NULL && n_visits-- > 0) {
+		prev_node = UT_LIST_GET_PREV(LRU, node);
+
+		io_mutex = fil_space_get_io_mutex(node->space->id);
+
+		mutex_enter(io_mutex);
+
+		if (node->LRU_accessed) {
+			/* Move the node to the start of the list; the
+			scan meets it again when it reaches the start,
+			unless an unaccessed file can be closed first */
+
+			node->LRU_accessed = FALSE;
+
+			mutex_exit(io_mutex);
+
+			UT_LIST_REMOVE(LRU, system->LRU, node);
+			UT_LIST_ADD_FIRST(LRU, system->LRU, node);
+
+			if (prev_node != NULL) {
+				node = prev_node;
+			}
+
+			continue;
+		}
+
 		if (node->modification_counter == node->flush_counter
+		    && node->n_pending == 0
 		    && node->n_pending_flushes == 0) {
 
 			fil_node_close_file(node, system);
 
+			mutex_exit(io_mutex);
+
 			return(TRUE);
 		}
 
+		if (print_info && node->n_pending > 0) {
+			fputs("InnoDB: cannot close file ", stderr);
+			ut_print_filename(stderr, node->name);
+			fprintf(stderr, ", because n_pending %lu\n",
+				(ulong) node->n_pending);
+		}
+
 		if (print_info && node->n_pending_flushes > 0) {
 			fputs("InnoDB: cannot close file ", stderr);
 			ut_print_filename(stderr, node->name);
@@ -856,7 +1088,9 @@ fil_try_to_close_file_in_LRU(
 				(long) node->flush_counter);
 		}
 
-		node = UT_LIST_GET_PREV(LRU, node);
+		mutex_exit(io_mutex);
+
+		node = prev_node;
 	}
 
 	return(FALSE);
@@ -992,9 +1226,16 @@ fil_node_free(
 	fil_system_t*	system,	/* in: tablespace memory cache */
 	fil_space_t*	space)	/* in: space where the file node is chained */
 {
+	mutex_t*	io_mutex;
+
 	ut_ad(node && system && space);
 	ut_ad(mutex_own(&(system->mutex)));
 	ut_a(node->magic_n == FIL_NODE_MAGIC_N);
+
+	io_mutex = fil_space_get_io_mutex(space->id);
+
+	mutex_enter(io_mutex);
+
 	ut_a(node->n_pending == 0);
 
 	if (node->open) {
@@ -1020,6 +1261,8 @@ fil_node_free(
 
 	UT_LIST_REMOVE(chain, space->chain, node);
 
+	mutex_exit(io_mutex);
+
 	mem_free(node->name);
 	mem_free(node);
 }
@@ -1171,6 +1414,8 @@ try_again:
 	space->stop_ios = FALSE;
 	space->stop_ibuf_merges = FALSE;
 	space->is_being_deleted = FALSE;
+	space->unchecked = FALSE;
+	space->missing = FALSE;
 	space->purpose = purpose;
 	space->size = 0;
 	space->zip_size = zip_size;
@@ -1180,6 +1425,8 @@ try_again:
 	space->n_pending_flushes = 0;
 	space->n_pending_ibuf_merges = 0;
 
+	space->atomic_writes = FALSE;
+
 	UT_LIST_INIT(space->chain);
 	space->magic_n = FIL_SPACE_MAGIC_N;
 
@@ -1187,11 +1434,15 @@ try_again:
 
 	rw_lock_create(&space->latch, SYNC_FSP);
 
+	mutex_enter(fil_space_get_io_mutex(id));
 	HASH_INSERT(fil_space_t, hash, system->spaces, id, space);
+	mutex_exit(fil_space_get_io_mutex(id));
 
 	HASH_INSERT(fil_space_t, name_hash, system->name_hash,
 		    ut_fold_string(name), space);
 	space->is_in_unflushed_spaces = FALSE;
+	space->is_in_prealloc_spaces = FALSE;
+	space->prealloc_size = 0;
 
 	UT_LIST_ADD_LAST(space_list, system->space_list, space);
 
@@ -1286,7 +1537,9 @@ fil_space_free(
 		return(FALSE);
 	}
 
+	mutex_enter(fil_space_get_io_mutex(id));
 	HASH_DELETE(fil_space_t, hash, system->spaces, id, space);
+	mutex_exit(fil_space_get_io_mutex(id));
 
 	namespace = fil_space_get_by_name(space->name);
 	ut_a(namespace);
@@ -1302,6 +1555,13 @@ fil_space_free(
 			       space);
 	}
 
+	if (space->is_in_prealloc_spaces) {
+		space->is_in_prealloc_spaces = FALSE;
+
+		UT_LIST_REMOVE(prealloc_spaces, system->prealloc_spaces,
+			       space);
+	}
+
 	UT_LIST_REMOVE(space_list, system->space_list, space);
 
 	ut_a(space->magic_n == FIL_SPACE_MAGIC_N);
@@ -1371,7 +1631,7 @@ fil_space_get_size(
 
 	space = fil_space_get_by_id(id);
 
-	if (space == NULL) {
+	if (space == NULL || space->missing) {
 		mutex_exit(&(system->mutex));
 
 		return(0);
@@ -1388,7 +1648,13 @@ fil_space_get_size(
 		the file yet; the following calls will open it and update the
 		size fields */
 
-		fil_node_prepare_for_io(node, system, space);
+		if (UNIV_UNLIKELY(!fil_node_prepare_for_io(node, system,
+							   space))) {
+			mutex_exit(&(system->mutex));
+
+			return(0);
+		}
+
 		fil_node_complete_io(node, system, OS_FILE_READ);
 	}
 
@@ -1425,7 +1691,7 @@ fil_space_get_zip_size(
 
 	space = fil_space_get_by_id(id);
 
-	if (space == NULL) {
+	if (space == NULL || space->missing) {
 		mutex_exit(&(system->mutex));
 
 		return(ULINT_UNDEFINED);
@@ -1442,7 +1708,13 @@ fil_space_get_zip_size(
 		the file yet; the following calls will open it and update the
 		size fields */
 
-		fil_node_prepare_for_io(node, system, space);
+		if (UNIV_UNLIKELY(!fil_node_prepare_for_io(node, system,
+							   space))) {
+			mutex_exit(&(system->mutex));
+
+			return(ULINT_UNDEFINED);
+		}
+
 		fil_node_complete_io(node, system, OS_FILE_READ);
 	}
 
@@ -1453,6 +1725,37 @@ fil_space_get_zip_size(
 	return(size);
 }
 
+/***********************************************************************
+Checks if the pages of a tablespace are written without the doublewrite
+buffer. This only needs the i/o mutex of the space, not the fil_system
+mutex. */
+UNIV_INTERN
+ibool
+fil_space_get_atomic_writes(
+/*========================*/
+			/* out: TRUE if the space is in the atomic-write
+			mode; FALSE if not, or if the space is not found
+			or none of its files has been opened yet */
+	ulint	id)	/* in: space id */
+{
+	mutex_t*	io_mutex;
+	fil_space_t*	space;
+	ibool		atomic_writes;
+
+	io_mutex = fil_space_get_io_mutex(id);
+
+	mutex_enter(io_mutex);
+
+	HASH_SEARCH(hash, fil_system->spaces, id,
+		    fil_space_t*, space, space->id == id);
+
+	atomic_writes = space != NULL && space->atomic_writes;
+
+	mutex_exit(io_mutex);
+
+	return(atomic_writes);
+}
+
 /***********************************************************************
 Checks if the pair space, page_no refers to an existing page in a tablespace
 file space. The tablespace must be cached in the memory cache. */
@@ -1484,6 +1787,7 @@ fil_system_create(
 				> 10 */
 {
 	fil_system_t*	system;
+	ulint		i;
 
 	ut_a(hash_size > 0);
 	ut_a(max_n_open > 0);
@@ -1492,6 +1796,10 @@ fil_system_create(
 
 	mutex_create(&system->mutex, SYNC_ANY_LATCH);
 
+	for (i = 0; i < FIL_N_IO_MUTEXES; i++) {
+		mutex_create(&system->io_mutexes[i], SYNC_FIL_IO);
+	}
+
 	system->spaces = hash_create(hash_size);
 	system->name_hash = hash_create(hash_size);
 
@@ -1500,12 +1808,12 @@ fil_system_create(
 	system->n_open = 0;
 	system->max_n_open = max_n_open;
 
-	system->modification_counter = 0;
 	system->max_assigned_id = 0;
 
 	system->tablespace_version = 0;
 
 	UT_LIST_INIT(system->unflushed_spaces);
+	UT_LIST_INIT(system->prealloc_spaces);
 	UT_LIST_INIT(system->space_list);
 
 	return(system);
@@ -1611,7 +1919,9 @@ fil_close_all_files(void)
 
 		while (node != NULL) {
 			if (node->open) {
+				mutex_enter(fil_space_get_io_mutex(space->id));
 				fil_node_close_file(node, system);
+				mutex_exit(fil_space_get_io_mutex(space->id));
 			}
 			node = UT_LIST_GET_NEXT(chain, node);
 		}
@@ -2156,6 +2466,7 @@ fil_delete_tablespace(
 	ibool		success;
 	fil_space_t*	space;
 	fil_node_t*	node;
+	ulint		n_pending;
 	ulint		count		= 0;
 	char*		path;
 
@@ -2226,7 +2537,14 @@ try_again:
 	ut_a(UT_LIST_GET_LEN(space->chain) == 1);
 	node = UT_LIST_GET_FIRST(space->chain);
 
-	if (space->n_pending_flushes > 0 || node->n_pending > 0) {
+	/* An i/o on an open file does not reserve the fil_system mutex;
+	it checks is_being_deleted under the i/o mutex */
+
+	mutex_enter(fil_space_get_io_mutex(id));
+	n_pending = node->n_pending;
+	mutex_exit(fil_space_get_io_mutex(id));
+
+	if (space->n_pending_flushes > 0 || n_pending > 0) {
 		if (count > 1000) {
 			ut_print_timestamp(stderr);
 			fputs("  InnoDB: Warning: trying to"
@@ -2237,7 +2555,7 @@ try_again:
 				" and %lu pending i/o's on it\n"
 				"InnoDB: Loop %lu.\n",
 				(ulong) space->n_pending_flushes,
-				(ulong) node->n_pending,
+				(ulong) n_pending,
 				(ulong) count);
 		}
 		mutex_exit(&(system->mutex));
@@ -2487,10 +2805,16 @@ retry:
 	ut_a(UT_LIST_GET_LEN(space->chain) == 1);
 	node = UT_LIST_GET_FIRST(space->chain);
 
+	/* An i/o on an open file does not reserve the fil_system mutex;
+	it checks stop_ios under the i/o mutex */
+
+	mutex_enter(fil_space_get_io_mutex(id));
+
 	if (node->n_pending > 0 || node->n_pending_flushes > 0) {
 		/* There are pending i/o's or flushes, sleep for a while and
 		retry */
 
+		mutex_exit(fil_space_get_io_mutex(id));
 		mutex_exit(&(system->mutex));
 
 		os_thread_sleep(20000);
@@ -2500,6 +2824,7 @@ retry:
 	} else if (node->modification_counter > node->flush_counter) {
 		/* Flush the space */
 
+		mutex_exit(fil_space_get_io_mutex(id));
 		mutex_exit(&(system->mutex));
 
 		os_thread_sleep(20000);
@@ -2514,6 +2839,8 @@ retry:
 		fil_node_close_file(node, system);
 	}
 
+	mutex_exit(fil_space_get_io_mutex(id));
+
 	/* Check that the old name in the space is right */
 
 	if (old_name_was_specified) {
@@ -3049,6 +3376,105 @@ func_exit:
 	return(ret);
 }
 
+/************************************************************************
+Creates the memory objects of a single-table tablespace without opening
+its .ibd file. The file is opened, and the space id and the size in it are
+checked, by fil_space_check_unopened() when the table is loaded, or by
+fil_node_read_size() when the first i/o is done to the tablespace. If the
+check fails, the i/o fails as if the tablespace did not exist. This is used at a normal startup when
+srv_lazy_open_tablespaces is set, so that the startup does not need to
+open every .ibd file. */
+UNIV_INTERN
+ibool
+fil_space_create_unopened(
+/*======================*/
+					/* out: TRUE if success */
+	ulint		id,		/* in: space id */
+	ulint		zip_size,	/* in: compressed page size,
+					or 0 if uncompressed tablespace */
+	const char*	name)		/* in: table name in the
+					databasename/tablename format */
+{
+	char*	filepath;
+	ibool	success;
+
+	filepath = fil_make_ibd_name(name, FALSE);
+
+	success = fil_space_create(filepath, id, zip_size, FIL_TABLESPACE);
+
+	if (success) {
+		/* The size of the file is not known yet */
+
+		fil_node_create(filepath, 0, id, FALSE);
+
+		mutex_enter(&(fil_system->mutex));
+		fil_space_get_by_id(id)->unchecked = TRUE;
+		mutex_exit(&(fil_system->mutex));
+	}
+
+	mem_free(filepath);
+
+	return(success);
+}
+
+/************************************************************************
+Checks the .ibd file of a tablespace created with
+fil_space_create_unopened(), if no i/o has been done to the tablespace
+yet. The file is opened, and the space id and the compressed page size in
+its header are compared to the data dictionary, as
+fil_open_single_table_tablespace() does at a normal startup. If the check
+fails, prints an error message to the .err log and frees the memory
+objects of the tablespace, so that the caller can treat the .ibd file as
+missing. */
+UNIV_INTERN
+ibool
+fil_space_check_unopened(
+/*=====================*/
+				/* out: TRUE if the tablespace exists
+				and its file matches the data dictionary */
+	ulint	id)		/* in: space id */
+{
+	fil_system_t*	system	= fil_system;
+	fil_space_t*	space;
+	ibool		missing;
+
+	mutex_enter(&(system->mutex));
+
+	space = fil_space_get_by_id(id);
+
+	if (space == NULL) {
+		mutex_exit(&(system->mutex));
+
+		return(FALSE);
+	}
+
+	if (space->unchecked && !space->missing) {
+		fil_node_read_size(UT_LIST_GET_FIRST(space->chain),
+				   system, space);
+	}
+
+	missing = space->missing;
+
+	if (missing) {
+		ut_print_timestamp(stderr);
+
+		fputs("  InnoDB: Error: trying to open a table,"
+		      " but the tablespace file\n"
+		      "InnoDB: ", stderr);
+		ut_print_filename(stderr, space->name);
+		fputs(" is missing or does not match"
+		      " the data dictionary!\n", stderr);
+	}
+
+	mutex_exit(&(system->mutex));
+
+	if (missing) {
+		fil_space_free(id);
+	}
+
+	return(!missing);
+}
+
 #ifdef UNIV_HOTBACKUP
 /***********************************************************************
 Allocates a file name for an old version of a single-table tablespace.
@@ -3564,7 +3990,15 @@ fil_tablespace_deleted_or_being_deleted_in_mem(
 
 	space = fil_space_get_by_id(id);
 
-	if (space == NULL || space->is_being_deleted) {
+	if (space != NULL && space->unchecked && !space->missing) {
+		/* Check the file before a page of the tablespace is read,
+		so that the read fails softly if the file is missing */
+
+		fil_node_read_size(UT_LIST_GET_FIRST(space->chain),
+				   system, space);
+	}
+
+	if (space == NULL || space->is_being_deleted || space->missing) {
 		mutex_exit(&(system->mutex));
 
 		return(TRUE);
@@ -3826,7 +4260,20 @@ fil_extend_space_to_desired_size(
 	fil_mutex_enter_and_prepare_for_io(space_id);
 
 	space = fil_space_get_by_id(space_id);
-	ut_a(space);
+
+	if (UNIV_UNLIKELY(space == NULL)
+	    || UNIV_UNLIKELY(space->is_being_deleted)
+	    || UNIV_UNLIKELY(space->missing)) {
+		/* This can only happen to a preallocation by
+		fil_preallocate_next_space() of a space that was dropped
+		meanwhile, or to a space whose file is missing */
+
+		*actual_size = 0;
+
+		mutex_exit(&(system->mutex));
+
+		return(FALSE);
+	}
 
 	if (space->size >= size_after_extend) {
 		/* Space already big enough */
@@ -3845,11 +4292,38 @@ fil_extend_space_to_desired_size(
 
 	node = UT_LIST_GET_LAST(space->chain);
 
-	fil_node_prepare_for_io(node, system, space);
+	if (UNIV_UNLIKELY(!fil_node_prepare_for_io(node, system, space))) {
+		*actual_size = 0;
+
+		mutex_exit(&(system->mutex));
+
+		return(FALSE);
+	}
 
 	start_page_no = space->size;
 	file_start_page_no = space->size - node->size;
 
+#ifndef UNIV_HOTBACKUP
+	/* Try first to reserve the space without writing to the file */
+
+	offset_high = (start_page_no - file_start_page_no)
+		/ (4096 * ((1024 * 1024) / page_size));
+	offset_low  = ((start_page_no - file_start_page_no)
+		       % (4096 * ((1024 * 1024) / page_size)))
+		* page_size;
+
+	if (os_file_allocate(node->handle, offset_low, offset_high,
+			     (size_after_extend - start_page_no) * page_size)) {
+
+		node->size += size_after_extend - start_page_no;
+		space->size += size_after_extend - start_page_no;
+
+		os_has_said_disk_full = FALSE;
+
+		goto extended;
+	}
+#endif /* !UNIV_HOTBACKUP */
+
 	/* Extend at most 64 pages at a time */
 	buf_size = ut_min(64, size_after_extend - start_page_no) * page_size;
 	buf2 = mem_alloc(buf_size + page_size);
@@ -3902,6 +4376,9 @@ fil_extend_space_to_desired_size(
 
 	mem_free(buf2);
 
+#ifndef UNIV_HOTBACKUP
+extended:
+#endif /* !UNIV_HOTBACKUP */
 	fil_node_complete_io(node, system, OS_FILE_WRITE);
 
 	*actual_size = space->size;
@@ -3928,6 +4405,102 @@ fil_extend_space_to_desired_size(
 	return(success);
 }
 
+#ifndef UNIV_HOTBACKUP
+/**************************************************************************
+Asks the preallocation thread to extend a single-table tablespace in the
+background, so that later extensions of the space find the file big
+enough already and do not have to write to it. */
+UNIV_INTERN
+void
+fil_space_request_preallocation(
+/*============================*/
+	ulint	id,	/* in: space id */
+	ulint	size)	/* in: desired size of the space in pages */
+{
+	fil_system_t*	system		= fil_system;
+	fil_space_t*	space;
+
+	ut_ad(id != 0);
+
+	mutex_enter(&(system->mutex));
+
+	space = fil_space_get_by_id(id);
+
+	if (space == NULL || space->is_being_deleted
+	    || size <= space->size || size <= space->prealloc_size) {
+
+		mutex_exit(&(system->mutex));
+
+		return;
+	}
+
+	space->prealloc_size = size;
+
+	if (!space->is_in_prealloc_spaces) {
+		space->is_in_prealloc_spaces = TRUE;
+
+		UT_LIST_ADD_LAST(prealloc_spaces, system->prealloc_spaces,
+				 space);
+	}
+
+	mutex_exit(&(system->mutex));
+
+	os_event_set(srv_preallocate_event);
+}
+
+/**************************************************************************
+Extends the first tablespace waiting in the preallocation list to the
+requested size. This is done in steps of FIL_PREALLOC_STEP pages, so that
+when the file system cannot reserve space without writing zeros, the
+fil_system mutex is not held for long. Called by the preallocation
+thread. */
+UNIV_INTERN
+ibool
+fil_preallocate_next_space(void)
+/*============================*/
+				/* out: TRUE if a space was extended,
+				FALSE if the list was empty */
+{
+	fil_system_t*	system		= fil_system;
+	fil_space_t*	space;
+	ulint		id;
+	ulint		size;
+	ulint		actual_size	= 0;
+	ibool		success		= TRUE;
+
+	mutex_enter(&(system->mutex));
+
+	space = UT_LIST_GET_FIRST(system->prealloc_spaces);
+
+	if (space == NULL) {
+		mutex_exit(&(system->mutex));
+
+		return(FALSE);
+	}
+
+	space->is_in_prealloc_spaces = FALSE;
+
+	UT_LIST_REMOVE(prealloc_spaces, system->prealloc_spaces, space);
+
+	id = space->id;
+	size = space->prealloc_size;
+
+	mutex_exit(&(system->mutex));
+
+	/* The first call only returns the current size of the space */
+
+	while (success && actual_size < size
+	       && srv_shutdown_state < SRV_SHUTDOWN_CLEANUP) {
+
+		success = fil_extend_space_to_desired_size(
+			&actual_size, id,
+			ut_min(actual_size + FIL_PREALLOC_STEP, size));
+	}
+
+	return(TRUE);
+}
+#endif /* !UNIV_HOTBACKUP */
+
 #ifdef UNIV_HOTBACKUP
 /************************************************************************
 Extends all tablespaces to the size stored in the space header. During the
@@ -4088,13 +4661,16 @@ fil_space_get_n_reserved_extents(
 NOTE: you must call fil_mutex_enter_and_prepare_for_io() first!
 
 Prepares a file node for i/o. Opens the file if it is closed. Updates the
-pending i/o's field in the node and the system appropriately. Takes the node
-off the LRU list if it is in the LRU list. The caller must hold the fil_sys
-mutex. */
+pending i/o's field in the node and the system appropriately. Moves the node
+to the start of the LRU list if it is in the LRU list. The caller must hold
+the fil_sys mutex. */
 static
-void
+ibool
 fil_node_prepare_for_io(
 /*====================*/
+				/* out: TRUE if success, FALSE if the file
+				of an unchecked tablespace turned out to
+				be missing: then no i/o is pending */
 	fil_node_t*	node,	/* in: file node */
 	fil_system_t*	system,	/* in: tablespace memory cache */
 	fil_space_t*	space)	/* in: space */
@@ -4115,24 +4691,118 @@ fil_node_prepare_for_io(
 		/* File is closed: open it */
 		ut_a(node->n_pending == 0);
 
-		fil_node_open_file(node, system, space);
+		if (UNIV_UNLIKELY(!fil_node_open_file(node, system, space))) {
+
+			return(FALSE);
+		}
 	}
 
-	if (node->n_pending == 0 && space->purpose == FIL_TABLESPACE
-	    && space->id != 0) {
-		/* The node is in the LRU list, remove it */
+	mutex_enter(fil_space_get_io_mutex(space->id));
+	node->n_pending++;
+	mutex_exit(fil_space_get_io_mutex(space->id));
 
-		ut_a(UT_LIST_GET_LEN(system->LRU) > 0);
+	if (space->purpose == FIL_TABLESPACE && space->id != 0
+	    && UT_LIST_GET_FIRST(system->LRU) != node) {
+		/* The node is in the LRU list, move it to the start */
 
 		UT_LIST_REMOVE(LRU, system->LRU, node);
+		UT_LIST_ADD_FIRST(LRU, system->LRU, node);
+	}
+
+	return(TRUE);
+}
+
+/************************************************************************
+Prepares a file node for i/o if the file is already open, without reserving
+the fil_system mutex. Updates the pending i/o's field in the node and marks
+the node accessed for the LRU list. */
+static
+fil_node_t*
+fil_node_prepare_for_io_fast(
+/*=========================*/
+				/* out: file node, or NULL if the space
+				does not exist, the file is not open, or the
+				i/o must go through fil_node_prepare_for_io()
+				for some other reason */
+	fil_system_t*	system,	/* in: tablespace memory cache */
+	ulint		space_id,/* in: space id */
+	ulint*		block_offset)/* in: offset in the space in number of
+				blocks; out: offset in the file of the node */
+{
+	mutex_t*	io_mutex;
+	fil_space_t*	space;
+	fil_node_t*	node;
+	ulint		offset;
+
+	io_mutex = fil_space_get_io_mutex(space_id);
+
+	mutex_enter(io_mutex);
+
+	HASH_SEARCH(hash, system->spaces, space_id, fil_space_t*, space,
+		    space->id == space_id);
+
+	if (UNIV_UNLIKELY(space == NULL)
+	    || UNIV_UNLIKELY(space->stop_ios)
+	    || UNIV_UNLIKELY(space->is_being_deleted)) {
+
+		mutex_exit(io_mutex);
+
+		return(NULL);
+	}
+
+	offset = *block_offset;
+
+	for (node = UT_LIST_GET_FIRST(space->chain);
+	     node != NULL && node->size <= offset;
+	     node = UT_LIST_GET_NEXT(chain, node)) {
+
+		offset -= node->size;
+	}
+
+	if (UNIV_UNLIKELY(node == NULL) || UNIV_UNLIKELY(!node->open)) {
+
+		mutex_exit(io_mutex);
+
+		return(NULL);
 	}
 
 	node->n_pending++;
+	node->LRU_accessed = TRUE;
+
+	mutex_exit(io_mutex);
+
+	*block_offset = offset;
+
+	return(node);
+}
+
+/************************************************************************
+Updates the pending i/o's field and the modification counter of a file
+node when an i/o operation finishes. The caller must hold the i/o mutex of
+the space. */
+UNIV_INLINE
+void
+fil_node_complete_io_low(
+/*=====================*/
+	fil_node_t*	node,	/* in: file node */
+	ulint		type)	/* in: OS_FILE_WRITE or OS_FILE_READ; marks
+				the node as modified if
+				type == OS_FILE_WRITE */
+{
+	ut_ad(mutex_own(fil_space_get_io_mutex(node->space->id)));
+	ut_a(node->n_pending > 0);
+
+	node->n_pending--;
+
+	if (type == OS_FILE_WRITE) {
+		node->modification_counter++;
+	}
 }
 
 /************************************************************************
 Updates the data structures when an i/o operation finishes. Updates the
-pending i/o's field in the node appropriately. */
+pending i/o's field in the node appropriately. The caller must hold the
+fil_sys mutex. */
 static
 void
 fil_node_complete_io(
@@ -4147,28 +4817,92 @@ fil_node_complete_io(
 	ut_ad(system);
 	ut_ad(mutex_own(&(system->mutex)));
 
-	ut_a(node->n_pending > 0);
+	mutex_enter(fil_space_get_io_mutex(node->space->id));
+	fil_node_complete_io_low(node, type);
+	mutex_exit(fil_space_get_io_mutex(node->space->id));
 
-	node->n_pending--;
+	if (type == OS_FILE_WRITE
+	    && !node->space->is_in_unflushed_spaces) {
 
-	if (type == OS_FILE_WRITE) {
-		system->modification_counter++;
-		node->modification_counter = system->modification_counter;
+		node->space->is_in_unflushed_spaces = TRUE;
+		UT_LIST_ADD_FIRST(unflushed_spaces,
+				  system->unflushed_spaces,
+				  node->space);
+	}
+}
 
-		if (!node->space->is_in_unflushed_spaces) {
+/************************************************************************
+Updates the data structures when an i/o operation finishes, without
+reserving the fil_system mutex unless the first write after a flush made
+the space unflushed. */
+static
+void
+fil_node_complete_io_fast(
+/*======================*/
+	fil_node_t*	node,	/* in: file node */
+	fil_system_t*	system,	/* in: tablespace memory cache */
+	ulint		type)	/* in: OS_FILE_WRITE or OS_FILE_READ; marks
+				the node as modified if
+				type == OS_FILE_WRITE */
+{
+	mutex_t*	io_mutex;
 
-			node->space->is_in_unflushed_spaces = TRUE;
-			UT_LIST_ADD_FIRST(unflushed_spaces,
-					  system->unflushed_spaces,
-					  node->space);
-		}
+	io_mutex = fil_space_get_io_mutex(node->space->id);
+
+	mutex_enter(io_mutex);
+
+	/* fil_flush() resets is_in_unflushed_spaces while holding the
+	i/o mutex, after it has seen that the modification counters of
+	the space are flushed; thus, if the flag is set here, it stays
+	set until fil_flush() sees this write */
+
+	if (UNIV_LIKELY(type != OS_FILE_WRITE
+			|| node->space->is_in_unflushed_spaces)) {
+
+		fil_node_complete_io_low(node, type);
+
+		mutex_exit(io_mutex);
+
+		return;
 	}
 
-	if (node->n_pending == 0 && node->space->purpose == FIL_TABLESPACE
-	    && node->space->id != 0) {
-		/* The node must be put back to the LRU list */
-		UT_LIST_ADD_FIRST(LRU, system->LRU, node);
+	/* The pending i/o keeps the space from being freed meanwhile */
+
+	mutex_exit(io_mutex);
+
+	mutex_enter(&(system->mutex));
+
+	fil_node_complete_io(node, system, type);
+
+	mutex_exit(&(system->mutex));
+}
+
+/************************************************************************
+Closes files from the end of the LRU list until there are at most 90 % of
+innodb_open_files open, so that an i/o seldom has to close a file before it
+can open another one. */
+UNIV_INTERN
+void
+fil_close_files_in_LRU(void)
+/*========================*/
+{
+	fil_system_t*	system	= fil_system;
+	ulint		limit;
+
+	limit = system->max_n_open - system->max_n_open / 10;
+
+	if (system->n_open <= limit) {
+
+		return;
 	}
+
+	mutex_enter(&(system->mutex));
+
+	while (system->n_open > limit
+	       && fil_try_to_close_file_in_LRU(FALSE)) {
+	}
+
+	mutex_exit(&(system->mutex));
 }
 
 /************************************************************************
@@ -4286,6 +5020,16 @@ fil_io(
 		srv_data_written+= len;
 	}
 
+	/* If the file is open, reserve it for the i/o without the
+	fil_system mutex */
+
+	node = fil_node_prepare_for_io_fast(system, space_id, &block_offset);
+
+	if (UNIV_LIKELY(node != NULL)) {
+
+		goto do_io;
+	}
+
 	/* Reserve the fil_system mutex and make sure that we can open at
 	least one file while holding it, if the file is not already open */
 
@@ -4293,19 +5037,10 @@ fil_io(
 
 	space = fil_space_get_by_id(space_id);
 
-	if (!space) {
+	if (!space || UNIV_UNLIKELY(space->missing)) {
 		mutex_exit(&(system->mutex));
 
-		ut_print_timestamp(stderr);
-		fprintf(stderr,
-			"  InnoDB: Error: trying to do i/o"
-			" to a tablespace which does not exist.\n"
-			"InnoDB: i/o type %lu, space id %lu,"
-			" page no. %lu, i/o length %lu bytes\n",
-			(ulong) type, (ulong) space_id, (ulong) block_offset,
-			(ulong) len);
-
-		return(DB_TABLESPACE_DELETED);
+		goto not_found;
 	}
 
 	ut_ad((mode != OS_AIO_IBUF) || (space->purpose == FIL_TABLESPACE));
@@ -4338,7 +5073,14 @@ fil_io(
 	}
 
 	/* Open file if closed */
-	fil_node_prepare_for_io(node, system, space);
+	if (UNIV_UNLIKELY(!fil_node_prepare_for_io(node, system, space))) {
+		/* The .ibd file of a tablespace that was not checked
+		at startup is missing */
+
+		mutex_exit(&(system->mutex));
+
+		goto not_found;
+	}
 
 	/* Check that at least the start offset is within the bounds of a
 	single-table tablespace */
@@ -4355,6 +5097,7 @@ fil_io(
 	/* Now we have made the changes in the data structures of system */
 	mutex_exit(&(system->mutex));
 
+do_io:
 	/* Calculate the low 32 bits and the high 32 bits of the file offset */
 
 	if (!zip_size) {
@@ -4407,16 +5150,24 @@ fil_io(
 		/* The i/o operation is already completed when we return from
 		os_aio: */
 
-		mutex_enter(&(system->mutex));
-
-		fil_node_complete_io(node, system, type);
-
-		mutex_exit(&(system->mutex));
+		fil_node_complete_io_fast(node, system, type);
 
 		ut_ad(fil_validate());
 	}
 
 	return(DB_SUCCESS);
+
+not_found:
+	ut_print_timestamp(stderr);
+	fprintf(stderr,
+		"  InnoDB: Error: trying to do i/o"
+		" to a tablespace which does not exist.\n"
+		"InnoDB: i/o type %lu, space id %lu,"
+		" page no. %lu, i/o length %lu bytes\n",
+		(ulong) type, (ulong) space_id, (ulong) block_offset,
+		(ulong) len);
+
+	return(DB_TABLESPACE_DELETED);
 }
 
 /**************************************************************************
@@ -4461,11 +5212,7 @@ fil_aio_wait(
 
 	srv_set_io_thread_op_info(segment, "complete io for fil node");
 
-	mutex_enter(&(system->mutex));
-
-	fil_node_complete_io(fil_node, fil_system, type);
-
-	mutex_exit(&(system->mutex));
+	fil_node_complete_io_fast(fil_node, system, type);
 
 	ut_ad(fil_validate());
 
@@ -4499,6 +5246,11 @@ fil_flush(
 	fil_node_t*	node;
 	os_file_t	file;
 	ib_longlong	old_mod_counter;
+	mutex_t*	io_mutex;
+	ullint		start_us;
+	ullint		time_us;
+
+	io_mutex = fil_space_get_io_mutex(space_id);
 
 	mutex_enter(&(system->mutex));
 
@@ -4515,12 +5267,15 @@ fil_flush(
 	node = UT_LIST_GET_FIRST(space->chain);
 
 	while (node) {
-		if (node->modification_counter > node->flush_counter) {
+		mutex_enter(io_mutex);
+		old_mod_counter = node->modification_counter;
+		mutex_exit(io_mutex);
+
+		if (old_mod_counter > node->flush_counter) {
 			ut_a(node->open);
 
 			/* We want to flush the changes at least up to
 			old_mod_counter */
-			old_mod_counter = node->modification_counter;
 
 			if (space->purpose == FIL_TABLESPACE) {
 				fil_n_pending_tablespace_flushes++;
@@ -4564,15 +5319,29 @@ retry:
 			/* fprintf(stderr, "Flushing to file %s\n",
 			node->name); */
 
+			start_us = ut_time_us(NULL);
+
 			os_file_flush(file);
 
+			time_us = ut_time_us(NULL) - start_us;
+
 			mutex_enter(&(system->mutex));
 
 			node->n_pending_flushes--;
+
+			if (space->purpose == FIL_TABLESPACE
+			    && node->flush_counter < old_mod_counter) {
+				fil_n_flushed_writes += (ulint)
+					(old_mod_counter
+					 - node->flush_counter);
+				fil_flush_time_us += time_us;
+			}
 skip_flush:
 			if (node->flush_counter < old_mod_counter) {
 				node->flush_counter = old_mod_counter;
 
+				mutex_enter(io_mutex);
+
 				if (space->is_in_unflushed_spaces
 				    && fil_space_is_flushed(space)) {
 
@@ -4583,6 +5352,8 @@ skip_flush:
 						system->unflushed_spaces,
 						space);
 				}
+
+				mutex_exit(io_mutex);
 			}
 
 			if (space->purpose == FIL_TABLESPACE) {
@@ -4600,6 +5371,23 @@ skip_flush:
 	mutex_exit(&(system->mutex));
 }
 
+/**************************************************************************
+Gets the number of data file writes made durable by fil_flush() and the
+total duration of the fsyncs that did it. */
+UNIV_INTERN
+void
+fil_get_flush_time(
+/*===============*/
+	ulint*	n_writes,	/* out: number of flushed writes */
+	ullint*	time_us)	/* out: duration of their fsyncs in
+				microseconds */
+{
+	mutex_enter(&(fil_system->mutex));
+	*n_writes = fil_n_flushed_writes;
+	*time_us = fil_flush_time_us;
+	mutex_exit(&(fil_system->mutex));
+}
+
 /**************************************************************************
 Flushes to disk the writes in file spaces of the given type possibly cached by
 the OS. */
@@ -4702,7 +5490,6 @@ fil_validate(void)
 	fil_node = UT_LIST_GET_FIRST(system->LRU);
 
 	while (fil_node != NULL) {
-		ut_a(fil_node->n_pending == 0);
 		ut_a(fil_node->open);
 		ut_a(fil_node->space->purpose == FIL_TABLESPACE);
 		ut_a(fil_node->space->id != 0);
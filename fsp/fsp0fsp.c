@@ -309,7 +309,7 @@ fseg_alloc_free_page_low(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	mtr_t*		mtr);	/* in: mtr handle */
 
 
@@ -1142,6 +1142,13 @@ fsp_try_extend_data_file_with_pages(
 	/* actual_size now has the space size in pages; it may be less than
 	we wanted if we ran out of disk space */
 
+	if (UNIV_UNLIKELY(actual_size < size)) {
+		/* The file could not be accessed at all, and actual_size
+		is not the file size: leave the header alone */
+
+		return(FALSE);
+	}
+
 	mlog_write_ulint(header + FSP_SIZE, actual_size, MLOG_4BYTES, mtr);
 
 	return(success);
@@ -1153,7 +1160,9 @@ static
 ibool
 fsp_try_extend_data_file(
 /*=====================*/
-					/* out: FALSE if not auto-extending */
+					/* out: FALSE if not auto-extending
+					or if the file could not be
+					accessed */
 	ulint*		actual_increase,/* out: actual increase in pages, where
 					we measure the tablespace size from
 					what the header field says; it may be
@@ -1169,6 +1178,8 @@ fsp_try_extend_data_file(
 	ulint	old_size;
 	ulint	size_increase;
 	ulint	actual_size;
+	ulint	prealloc_size	= 0;
+	ulint	file_size;
 	ibool	success;
 
 	*actual_increase = 0;
@@ -1241,6 +1252,10 @@ fsp_try_extend_data_file(
 			that we add at most FSP_FREE_ADD extents at
 			a time */
 			size_increase = FSP_FREE_ADD * extent_size;
+
+			/* The space is growing: let the preallocation
+			thread keep some extents ready in the file */
+			prealloc_size = srv_preallocate_extents * extent_size;
 		}
 	}
 
@@ -1251,6 +1266,25 @@ fsp_try_extend_data_file(
 
 	success = fil_extend_space_to_desired_size(&actual_size, space,
 						   size + size_increase);
+
+	if (UNIV_UNLIKELY(actual_size < size)) {
+		/* The file could not be accessed at all, and actual_size
+		is not the file size: leave the header alone */
+
+		*actual_increase = size - old_size;
+
+		return(FALSE);
+	}
+
+	file_size = actual_size;
+
+	if (space != 0 && actual_size > size + size_increase) {
+		/* The file has been preallocated beyond what we need:
+		leave the rest for the following extensions */
+
+		actual_size = size + size_increase;
+	}
+
 	/* We ignore any fragments of a full megabyte when storing the size
 	to the space header */
 
@@ -1265,6 +1299,13 @@ fsp_try_extend_data_file(
 
 	*actual_increase = new_size - old_size;
 
+	if (prealloc_size > 0 && file_size < new_size + prealloc_size / 2) {
+		/* Less than half of the preallocated extents are left */
+
+		fil_space_request_preallocation(space,
+						new_size + prealloc_size);
+	}
+
 	return(TRUE);
 }
 
@@ -2484,7 +2525,7 @@ fseg_alloc_free_page_low(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	mtr_t*		mtr)	/* in: mtr handle */
 {
 	fsp_header_t*	space_header;
@@ -2501,7 +2542,7 @@ fseg_alloc_free_page_low(
 	ulint		n;
 
 	ut_ad(mtr);
-	ut_ad((direction >= FSP_UP) && (direction <= FSP_NO_DIR));
+	ut_ad((direction >= FSP_UP) && (direction <= FSP_APPEND));
 	ut_ad(mach_read_from_4(seg_inode + FSEG_MAGIC_N)
 	      == FSEG_MAGIC_N_VALUE);
 	seg_id = mtr_read_dulint(seg_inode + FSEG_ID, mtr);
@@ -2535,13 +2576,18 @@ fseg_alloc_free_page_low(
 		ret_page = hint;
 		/*-----------------------------------------------------------*/
 	} else if ((xdes_get_state(descr, mtr) == XDES_FREE)
-		   && ((reserved - used) < reserved / FSEG_FILLFACTOR)
+		   && ((direction == FSP_APPEND)
+		       || ((reserved - used) < reserved / FSEG_FILLFACTOR))
 		   && (used >= FSEG_FRAG_LIMIT)) {
 
 		/* 2. We allocate the free extent from space and can take
 		=========================================================
-		the hinted page
-		===============*/
+		the hinted page; for appends we do this even if the
+		===================================================
+		segment has unused pages elsewhere, so that the index
+		=====================================================
+		grows in contiguous extents
+		===========================*/
 		ret_descr = fsp_alloc_free_extent(space, zip_size, hint, mtr);
 
 		ut_a(ret_descr == descr);
@@ -2556,7 +2602,25 @@ fseg_alloc_free_page_low(
 				    hint + FSP_EXTENT_SIZE, mtr);
 		ret_page = hint;
 		/*-----------------------------------------------------------*/
-	} else if ((direction != FSP_NO_DIR)
+	} else if ((direction == FSP_APPEND)
+		   && (used >= FSEG_FRAG_LIMIT)
+		   && ((xdes_get_state(descr, mtr) != XDES_FSEG)
+		       || (0 != ut_dulint_cmp(mtr_read_dulint(descr + XDES_ID,
+							      mtr), seg_id))
+		       || xdes_is_full(descr, mtr))
+		   && (!!(ret_descr
+			  = fseg_alloc_free_extent(seg_inode,
+						   space, zip_size, mtr)))) {
+
+		/* 3a. The hinted extent cannot be continued: start a whole
+		===========================================================
+		free extent of the segment, rather than picking up single
+		=========================================================
+		unused pages scattered in the segment
+		=====================================*/
+		ret_page = xdes_get_offset(ret_descr);
+		/*-----------------------------------------------------------*/
+	} else if (((direction == FSP_UP) || (direction == FSP_DOWN))
 		   && ((reserved - used) < reserved / FSEG_FILLFACTOR)
 		   && (used >= FSEG_FRAG_LIMIT)
 		   && (!!(ret_descr
@@ -2730,7 +2794,7 @@ fseg_alloc_free_page_general(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	ibool		has_done_reservation, /* in: TRUE if the caller has
 				already done the reservation for the page
 				with fsp_reserve_free_extents, then there
@@ -2799,7 +2863,7 @@ fseg_alloc_free_page(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	mtr_t*		mtr)	/* in: mtr handle */
 {
 	return(fseg_alloc_free_page_general(seg_header, hint, direction,
@@ -59,6 +59,7 @@ extern "C" {
 #include "../storage/innobase/include/fsp0fsp.h"
 #include "../storage/innobase/include/sync0sync.h"
 #include "../storage/innobase/include/fil0fil.h"
+#include "../storage/innobase/include/ibuf0ibuf.h"
 #include "../storage/innobase/include/trx0xa.h"
 #include "../storage/innobase/include/row0merge.h"
 #include "../storage/innobase/include/thr0loc.h"
@@ -137,13 +138,17 @@ static my_bool	innobase_log_archive			= FALSE;
 static char*	innobase_log_arch_dir			= NULL;
 #endif /* UNIV_LOG_ARCHIVE */
 static my_bool	innobase_use_doublewrite		= TRUE;
+static my_bool	innobase_use_atomic_writes		= FALSE;
 static my_bool	innobase_use_checksums			= TRUE;
 static my_bool	innobase_file_per_table			= FALSE;
+static my_bool	innobase_lazy_open_tablespaces		= FALSE;
 static my_bool	innobase_locks_unsafe_for_binlog	= FALSE;
 static my_bool	innobase_rollback_on_timeout		= FALSE;
 static my_bool	innobase_create_status_file		= FALSE;
 static my_bool innobase_stats_on_metadata		= TRUE;
 static my_bool	innobase_adaptive_hash_index		= TRUE;
+static my_bool	innobase_deadlock_detect_background	= FALSE;
+static my_bool	innobase_latch_profiling		= FALSE;
 
 static char*	internal_innobase_data_file_path	= NULL;
 
@@ -353,6 +358,8 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_buffer_pool_pages_dirty,	  SHOW_LONG},
   {"buffer_pool_pages_flushed",
   (char*) &export_vars.innodb_buffer_pool_pages_flushed,  SHOW_LONG},
+  {"buffer_pool_pages_flushed_neighbors",
+  (char*) &export_vars.innodb_buffer_pool_pages_flushed_neighbors, SHOW_LONG},
   {"buffer_pool_pages_free",
   (char*) &export_vars.innodb_buffer_pool_pages_free,	  SHOW_LONG},
   {"buffer_pool_pages_latched",
@@ -373,6 +380,16 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_buffer_pool_wait_free,	  SHOW_LONG},
   {"buffer_pool_write_requests",
   (char*) &export_vars.innodb_buffer_pool_write_requests, SHOW_LONG},
+  {"conc_prio_admissions",
+  (char*) &export_vars.innodb_conc_prio_admissions,	  SHOW_LONG},
+  {"conc_queue_length",
+  (char*) &export_vars.innodb_conc_queue_length,	  SHOW_LONG},
+  {"conc_queue_length_max",
+  (char*) &export_vars.innodb_conc_queue_length_max,	  SHOW_LONG},
+  {"conc_wait_time",
+  (char*) &export_vars.innodb_conc_wait_time,		  SHOW_LONGLONG},
+  {"conc_waits",
+  (char*) &export_vars.innodb_conc_waits,		  SHOW_LONG},
   {"data_fsyncs",
   (char*) &export_vars.innodb_data_fsyncs,		  SHOW_LONG},
   {"data_pending_fsyncs",
@@ -389,10 +406,34 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_data_writes,		  SHOW_LONG},
   {"data_written",
   (char*) &export_vars.innodb_data_written,		  SHOW_LONG},
+  {"dblwr_pages_skipped",
+  (char*) &export_vars.innodb_dblwr_pages_skipped,	  SHOW_LONG},
   {"dblwr_pages_written",
   (char*) &export_vars.innodb_dblwr_pages_written,	  SHOW_LONG},
   {"dblwr_writes",
   (char*) &export_vars.innodb_dblwr_writes,		  SHOW_LONG},
+  {"deadlock_checks",
+  (char*) &export_vars.innodb_deadlock_checks,		  SHOW_LONG},
+  {"deadlock_checks_deferred",
+  (char*) &export_vars.innodb_deadlock_checks_deferred,	  SHOW_LONG},
+  {"deadlock_steps",
+  (char*) &export_vars.innodb_deadlock_steps,		  SHOW_LONG},
+  {"deadlocks",
+  (char*) &export_vars.innodb_deadlocks,		  SHOW_LONG},
+  {"dict_tables_evicted",
+  (char*) &export_vars.innodb_dict_tables_evicted,	  SHOW_LONG},
+  {"dict_tables_reloaded",
+  (char*) &export_vars.innodb_dict_tables_reloaded,	  SHOW_LONG},
+  {"ibuf_inserts",
+  (char*) &export_vars.innodb_ibuf_inserts,		  SHOW_LONG},
+  {"ibuf_max_size",
+  (char*) &export_vars.innodb_ibuf_max_size,		  SHOW_LONG},
+  {"ibuf_merged_recs",
+  (char*) &export_vars.innodb_ibuf_merged_recs,		  SHOW_LONG},
+  {"ibuf_merges",
+  (char*) &export_vars.innodb_ibuf_merges,		  SHOW_LONG},
+  {"ibuf_size",
+  (char*) &export_vars.innodb_ibuf_size,		  SHOW_LONG},
   {"log_waits",
   (char*) &export_vars.innodb_log_waits,		  SHOW_LONG},
   {"log_write_requests",
@@ -1705,7 +1746,9 @@ innobase_init(
 	srv_force_recovery = (ulint) innobase_force_recovery;
 
 	srv_use_doublewrite_buf = (ibool) innobase_use_doublewrite;
+	srv_use_atomic_writes = (ibool) innobase_use_atomic_writes;
 	srv_use_checksums = (ibool) innobase_use_checksums;
+	srv_lazy_open_tablespaces = (ibool) innobase_lazy_open_tablespaces;
 
 #ifdef HAVE_LARGE_PAGES
         if ((os_use_large_pages = (ibool) my_use_large_pages))
@@ -1716,6 +1759,9 @@ innobase_init(
 
 	srv_file_per_table = (ibool) innobase_file_per_table;
 	srv_locks_unsafe_for_binlog = (ibool) innobase_locks_unsafe_for_binlog;
+	srv_deadlock_detect_background
+		= (ibool) innobase_deadlock_detect_background;
+	srv_latch_profiling = (ibool) innobase_latch_profiling;
 
 	srv_max_n_open_files = (ulint) innobase_open_files;
 	srv_innodb_status = (ibool) innobase_create_status_file;
@@ -2736,6 +2782,50 @@ set_field_in_record_to_null(
 	record[null_offset] = record[null_offset] | field->null_bit;
 }
 
+/* Charsets used in comparisons, indexed by the charset number.  The MySQL
+function get_charset() acquires a global mutex on every call, which made
+it a point of contention in B-tree searches on character columns.  The
+entries are filled in on first use; concurrent threads may store the
+same pointer, which is harmless because charsets are never freed. */
+static CHARSET_INFO*	innobase_charsets[256];
+
+/*****************************************************************
+Looks up a charset by its number, caching it in innobase_charsets[]. */
+static
+CHARSET_INFO*
+innobase_get_charset_by_number(
+/*===========================*/
+				/* out: charset */
+	uint	charset_number)	/* in: number of the charset */
+{
+	CHARSET_INFO*	charset;
+
+	if (UNIV_LIKELY(charset_number < UT_ARR_SIZE(innobase_charsets))) {
+		charset = innobase_charsets[charset_number];
+
+		if (UNIV_LIKELY(charset != NULL)) {
+
+			return(charset);
+		}
+	}
+
+	charset = get_charset(charset_number, MYF(MY_WME));
+
+	if (charset == NULL) {
+		sql_print_error("InnoDB needs charset %lu for doing "
+				"a comparison, but MySQL cannot "
+				"find that charset.",
+				(ulong) charset_number);
+		ut_a(0);
+	}
+
+	if (charset_number < UT_ARR_SIZE(innobase_charsets)) {
+		innobase_charsets[charset_number] = charset;
+	}
+
+	return(charset);
+}
+
 /*****************************************************************
 InnoDB uses this function to compare two data fields for which the data type
 is such that we must use MySQL code to compare them. NOTE that the prototype
@@ -2776,25 +2866,9 @@ innobase_mysql_cmp(
 	case MYSQL_TYPE_LONG_BLOB:
 	case MYSQL_TYPE_VARCHAR:
 		/* Use the charset number to pick the right charset struct for
-		the comparison. Since the MySQL function get_charset may be
-		slow before Bar removes the mutex operation there, we first
-		look at 2 common charsets directly. */
-
-		if (charset_number == default_charset_info->number) {
-			charset = default_charset_info;
-		} else if (charset_number == my_charset_latin1.number) {
-			charset = &my_charset_latin1;
-		} else {
-			charset = get_charset(charset_number, MYF(MY_WME));
-
-			if (charset == NULL) {
-			  sql_print_error("InnoDB needs charset %lu for doing "
-					  "a comparison, but MySQL cannot "
-					  "find that charset.",
-					  (ulong) charset_number);
-				ut_a(0);
-			}
-		}
+		the comparison. */
+
+		charset = innobase_get_charset_by_number(charset_number);
 
 		/* Starting from 4.1.3, we use strnncollsp() in comparisons of
 		non-latin1_swedish_ci strings. NOTE that the collation order
@@ -5341,7 +5415,10 @@ ha_innobase::create(
 
 	log_buffer_flush_to_disk();
 
-	innobase_table = dict_table_get(norm_name, FALSE);
+	/* Increment the handle count, so that the table cannot be
+	evicted from the dictionary cache while we use it below */
+
+	innobase_table = dict_table_get(norm_name, TRUE);
 
 	DBUG_ASSERT(innobase_table != 0);
 
@@ -5358,10 +5435,13 @@ ha_innobase::create(
 		auto_inc_value = create_info->auto_increment_value;
 
 		dict_table_autoinc_lock(innobase_table);
-		dict_table_autoinc_initialize(innobase_table, auto_inc_value);
+		dict_table_autoinc_initialize_pinned(innobase_table,
+						     auto_inc_value);
 		dict_table_autoinc_unlock(innobase_table);
 	}
 
+	dict_table_decrement_handle_count(innobase_table, FALSE);
+
 	/* Tell the InnoDB server that there might be work for
 	utility threads: */
 
@@ -7124,93 +7204,52 @@ innodb_mutex_show_status(
 	stat_print_fn*	stat_print)
 {
 	char buf1[IO_SIZE], buf2[IO_SIZE];
-	mutex_t*  mutex;
-#ifdef UNIV_DEBUG
-	ulint	  rw_lock_count= 0;
-	ulint	  rw_lock_count_spin_loop= 0;
-	ulint	  rw_lock_count_spin_rounds= 0;
-	ulint	  rw_lock_count_os_wait= 0;
-	ulint	  rw_lock_count_os_yield= 0;
-	ulonglong rw_lock_wait_time= 0;
-#endif /* UNIV_DEBUG */
+	sync_latch_class_t*	classes;
+	ulint			n_classes;
+	ulint			i;
+	bool			ret	= FALSE;
 	uint	  hton_name_len= strlen(innobase_hton_name), buf1len, buf2len;
 	DBUG_ENTER("innodb_mutex_show_status");
 	DBUG_ASSERT(hton == innodb_hton_ptr);
 
-	mutex_enter(&mutex_list_mutex);
+	/* The latches are grouped by the place where they were created,
+	so that e.g. the mutexes of all buffer pool blocks show up as one
+	row. The latch lists are not latched while the rows are sent. */
 
-	mutex = UT_LIST_GET_FIRST(mutex_list);
+	classes = sync_latch_classes_collect(&n_classes);
+
+	for (i = 0; i < n_classes; i++) {
+		const sync_latch_class_t*	latch_class = &classes[i];
 
-	while (mutex != NULL) {
-#ifdef UNIV_DEBUG
-		if (mutex->mutex_type != 1) {
-			if (mutex->count_using > 0) {
-				buf1len= my_snprintf(buf1, sizeof(buf1),
-					"%s:%s",
-					mutex->cmutex_name, mutex->cfile_name);
-				buf2len= my_snprintf(buf2, sizeof(buf2),
-					"count=%lu, spin_waits=%lu,"
-					" spin_rounds=%lu, "
-					"os_waits=%lu, os_yields=%lu,"
-					" os_wait_times=%lu",
-					mutex->count_using,
-					mutex->count_spin_loop,
-					mutex->count_spin_rounds,
-					mutex->count_os_wait,
-					mutex->count_os_yield,
-					(ulong) (mutex->lspent_time/1000));
-
-				if (stat_print(thd, innobase_hton_name,
-						hton_name_len, buf1, buf1len,
-						buf2, buf2len)) {
-					mutex_exit(&mutex_list_mutex);
-					DBUG_RETURN(1);
-				}
-			}
-		}
-		else {
-			rw_lock_count += mutex->count_using;
-			rw_lock_count_spin_loop += mutex->count_spin_loop;
-			rw_lock_count_spin_rounds += mutex->count_spin_rounds;
-			rw_lock_count_os_wait += mutex->count_os_wait;
-			rw_lock_count_os_yield += mutex->count_os_yield;
-			rw_lock_wait_time += mutex->lspent_time;
-		}
-#else /* UNIV_DEBUG */
 		buf1len= my_snprintf(buf1, sizeof(buf1), "%s:%lu",
-				     mutex->cfile_name, (ulong) mutex->cline);
-		buf2len= my_snprintf(buf2, sizeof(buf2), "os_waits=%lu",
-				     mutex->count_os_wait);
+				     latch_class->cfile_name,
+				     (ulong) latch_class->cline);
+		buf2len= my_snprintf(buf2, sizeof(buf2),
+				     "type=%s, latches=%lu, spin_waits=%lu,"
+				     " spin_rounds=%lu, os_waits=%lu,"
+				     " os_wait_time_ms=%lu",
+				     latch_class->is_rw_lock
+				     ? "rw_lock" : "mutex",
+				     (ulong) latch_class->n_latches,
+				     (ulong) latch_class->spin_waits,
+				     (ulong) latch_class->spin_rounds,
+				     (ulong) latch_class->os_waits,
+				     (ulong) (latch_class->os_wait_time
+					      / 1000));
 
 		if (stat_print(thd, innobase_hton_name,
 			       hton_name_len, buf1, buf1len,
 			       buf2, buf2len)) {
-			mutex_exit(&mutex_list_mutex);
-			DBUG_RETURN(1);
+			ret = TRUE;
+			break;
 		}
-#endif /* UNIV_DEBUG */
-
-		mutex = UT_LIST_GET_NEXT(list, mutex);
 	}
 
-	mutex_exit(&mutex_list_mutex);
-
-#ifdef UNIV_DEBUG
-	buf2len= my_snprintf(buf2, sizeof(buf2),
-		"count=%lu, spin_waits=%lu, spin_rounds=%lu, "
-		"os_waits=%lu, os_yields=%lu, os_wait_times=%lu",
-		rw_lock_count, rw_lock_count_spin_loop,
-		rw_lock_count_spin_rounds,
-		rw_lock_count_os_wait, rw_lock_count_os_yield,
-		(ulong) (rw_lock_wait_time/1000));
-
-	if (stat_print(thd, innobase_hton_name, hton_name_len,
-			STRING_WITH_LEN("rw_lock_mutexes"), buf2, buf2len)) {
-		DBUG_RETURN(1);
+	if (classes != NULL) {
+		ut_free(classes);
 	}
-#endif /* UNIV_DEBUG */
 
-	DBUG_RETURN(FALSE);
+	DBUG_RETURN(ret);
 }
 
 static
@@ -7935,9 +7974,8 @@ innobase_get_at_most_n_mbchars(
 	ulint n_chars;		/* number of characters in prefix */
 	CHARSET_INFO* charset;	/* charset used in the field */
 
-	charset = get_charset((uint) charset_id, MYF(MY_WME));
+	charset = innobase_get_charset_by_number((uint) charset_id);
 
-	ut_ad(charset);
 	ut_ad(charset->mbmaxlen);
 
 	/* Calculate how many characters at most the prefix index contains */
@@ -8253,6 +8291,85 @@ static SHOW_VAR innodb_status_variables_export[]= {
 static struct st_mysql_storage_engine innobase_storage_engine=
 { MYSQL_HANDLERTON_INTERFACE_VERSION };
 
+/*****************************************************************
+Update the system variable innodb_ibuf_max_size_pct. */
+static
+void
+innodb_ibuf_max_size_pct_update(
+/*============================*/
+	THD*				thd,	/* in: thread handle */
+	struct st_mysql_sys_var*	var,	/* in: pointer to
+						system variable */
+	void*				var_ptr,/* out: where the
+						formal string goes */
+	const void*			save)	/* in: immediate result
+						from check function */
+{
+	*static_cast<ulong*>(var_ptr) = *static_cast<const ulong*>(save);
+
+	ibuf_max_size_update(*static_cast<const ulong*>(save));
+}
+
+/*****************************************************************
+Update the system variable innodb_deadlock_detect_background. */
+static
+void
+innodb_deadlock_detect_background_update(
+/*=====================================*/
+	THD*				thd,	/* in: thread handle */
+	struct st_mysql_sys_var*	var,	/* in: pointer to
+						system variable */
+	void*				var_ptr,/* out: where the
+						formal string goes */
+	const void*			save)	/* in: immediate result
+						from check function */
+{
+	*static_cast<my_bool*>(var_ptr) = *static_cast<const my_bool*>(save);
+
+	srv_deadlock_detect_background
+		= (ibool) *static_cast<const my_bool*>(save);
+}
+
+/*****************************************************************
+Update the system variable innodb_latch_profiling. */
+static
+void
+innodb_latch_profiling_update(
+/*==========================*/
+	THD*				thd,	/* in: thread handle */
+	struct st_mysql_sys_var*	var,	/* in: pointer to
+						system variable */
+	void*				var_ptr,/* out: where the
+						formal string goes */
+	const void*			save)	/* in: immediate result
+						from check function */
+{
+	*static_cast<my_bool*>(var_ptr) = *static_cast<const my_bool*>(save);
+
+	srv_latch_profiling = (ibool) *static_cast<const my_bool*>(save);
+}
+
+/*****************************************************************
+Update the system variable innodb_thread_concurrency. */
+static
+void
+innodb_thread_concurrency_update(
+/*=============================*/
+	THD*				thd,	/* in: thread handle */
+	struct st_mysql_sys_var*	var,	/* in: pointer to
+						system variable */
+	void*				var_ptr,/* out: where the
+						formal string goes */
+	const void*			save)	/* in: immediate result
+						from check function */
+{
+	*static_cast<ulong*>(var_ptr) = *static_cast<const ulong*>(save);
+
+	/* Let the waiting threads check if they are admitted under the
+	new limit */
+	srv_conc_wake_all();
+}
+
 /* plugin options */
 static MYSQL_SYSVAR_BOOL(checksums, innobase_use_checksums,
   PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
@@ -8265,12 +8382,32 @@ static MYSQL_SYSVAR_STR(data_home_dir, innobase_data_home_dir,
   "The common part for InnoDB table spaces.",
   NULL, NULL, NULL);
 
+static MYSQL_SYSVAR_ULONG(deadlock_check_budget, srv_deadlock_check_budget_usec,
+  PLUGIN_VAR_RQCMDARG,
+  "Time budget in microseconds of the deadlock check done when a lock wait starts (0 = no time limit).",
+  NULL, NULL, 0, 0, ~0L, 0);
+
+static MYSQL_SYSVAR_BOOL(deadlock_detect_background, innobase_deadlock_detect_background,
+  PLUGIN_VAR_OPCMDARG,
+  "Let the lock timeout thread finish the deadlock checks which exceed their budget, instead of rolling back the waiting transaction (disabled by default).",
+  NULL, innodb_deadlock_detect_background_update, FALSE);
+
+static MYSQL_SYSVAR_BOOL(latch_profiling, innobase_latch_profiling,
+  PLUGIN_VAR_OPCMDARG,
+  "Count the spin loops and time the waits of InnoDB mutexes and rw-locks for SHOW ENGINE INNODB MUTEX (disabled by default).",
+  NULL, innodb_latch_profiling_update, FALSE);
+
 static MYSQL_SYSVAR_BOOL(doublewrite, innobase_use_doublewrite,
   PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
   "Enable InnoDB doublewrite buffer (enabled by default). "
   "Disable with --skip-innodb-doublewrite.",
   NULL, NULL, TRUE);
 
+static MYSQL_SYSVAR_BOOL(use_atomic_writes, innobase_use_atomic_writes,
+  PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
+  "Declare that the storage of the data files never tears a page write. Pages of tablespaces whose files are opened with O_DIRECT (innodb_flush_method=O_DIRECT or ALL_O_DIRECT) are then written without the doublewrite buffer (disabled by default).",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_ULONG(fast_shutdown, innobase_fast_shutdown,
   PLUGIN_VAR_OPCMDARG,
   "Speeds up the shutdown process of the InnoDB storage engine. Possible "
@@ -8288,6 +8425,11 @@ static MYSQL_SYSVAR_BOOL(file_per_table, innobase_file_per_table,
   "Stores each InnoDB table to an .ibd file in the database dir.",
   NULL, NULL, FALSE);
 
+static MYSQL_SYSVAR_BOOL(lazy_open_tablespaces, innobase_lazy_open_tablespaces,
+  PLUGIN_VAR_NOCMDARG | PLUGIN_VAR_READONLY,
+  "At a normal startup, create the tablespace objects from the data dictionary without opening the .ibd files; each file is opened when its table is first used.",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_ULONG(flush_log_at_trx_commit, srv_flush_log_at_trx_commit,
   PLUGIN_VAR_OPCMDARG,
   "Set to 0 (write and flush once per second),"
@@ -8304,6 +8446,11 @@ static MYSQL_SYSVAR_BOOL(locks_unsafe_for_binlog, innobase_locks_unsafe_for_binl
   "Force InnoDB to not use next-key locking, to use only row-level locking.",
   NULL, NULL, FALSE);
 
+static MYSQL_SYSVAR_ULONG(lock_schedule, srv_lock_schedule,
+  PLUGIN_VAR_RQCMDARG,
+  "Order in which waiting row lock requests are granted: 0 = in request order (default), 1 = oldest transaction first, 2 = heaviest transaction first.",
+  NULL, NULL, 0, 0, 2, 0);
+
 #ifdef UNIV_LOG_ARCHIVE
 static MYSQL_SYSVAR_STR(log_arch_dir, innobase_log_arch_dir,
   PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
@@ -8318,11 +8465,46 @@ static MYSQL_SYSVAR_STR(log_group_home_dir, innobase_log_group_home_dir,
   PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
   "Path to InnoDB log files.", NULL, NULL, NULL);
 
+static MYSQL_SYSVAR_ULONG(ibuf_max_size_pct, srv_ibuf_max_size_pct,
+  PLUGIN_VAR_RQCMDARG,
+  "Maximum size of the insert buffer as a percentage of the buffer pool.",
+  NULL, innodb_ibuf_max_size_pct_update, 50, 0, 50, 0);
+
+static MYSQL_SYSVAR_ULONG(io_capacity, srv_io_capacity,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of I/O operations per second the server can do. Tunes the background I/O rate, such as the insert buffer merge.",
+  NULL, NULL, 200, 100, ~0L, 0);
+
 static MYSQL_SYSVAR_ULONG(max_dirty_pages_pct, srv_max_buf_pool_modified_pct,
   PLUGIN_VAR_RQCMDARG,
   "Percentage of dirty pages allowed in bufferpool.",
   NULL, NULL, 90, 0, 100, 0);
 
+static MYSQL_SYSVAR_ULONG(flush_neighbors, srv_flush_neighbors,
+  PLUGIN_VAR_RQCMDARG,
+  "Which dirty neighbors of a page are flushed with it: 0 (none, for solid state storage), 1 (all in the flush area, the default, for rotational disks), 2 (only the contiguous ones) or 3 (1 or 0 depending on the measured write latency).",
+  NULL, NULL, 1, 0, 3, 0);
+
+static MYSQL_SYSVAR_ULONG(lru_scan_depth, srv_LRU_scan_depth,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of free or replaceable pages that a background thread keeps at the end of the LRU list of the buffer pool, so that user threads seldom flush pages themselves (0 = leave the flushing to the user threads).",
+  NULL, NULL, 1024, 0, ~0L, 0);
+
+static MYSQL_SYSVAR_ULONG(preallocate_extents, srv_preallocate_extents,
+  PLUGIN_VAR_RQCMDARG,
+  "Number of extents by which a background thread extends the .ibd file of a growing table ahead of its use (0 = extend only when needed).",
+  NULL, NULL, 0, 0, 1024, 0);
+
+static MYSQL_SYSVAR_ULONG(fill_factor, srv_fill_factor,
+  PLUGIN_VAR_RQCMDARG,
+  "Percentage of each leaf page that is filled when an index is created, or grows by appends to its end, such as an index on an auto-increment or timestamp column; the rest is left free for updates.",
+  NULL, NULL, 100, 10, 100, 0);
+
+static MYSQL_SYSVAR_ULONG(dict_size_limit, srv_dict_size_limit,
+  PLUGIN_VAR_RQCMDARG,
+  "Size limit in bytes of the InnoDB data dictionary cache; unused tables are evicted when it is exceeded (0 = no limit).",
+  NULL, NULL, 0, 0, ~0L, 0);
+
 static MYSQL_SYSVAR_ULONG(max_purge_lag, srv_max_purge_lag,
   PLUGIN_VAR_RQCMDARG,
   "Desired maximum length of the purge queue (0 = no limit)",
@@ -8390,6 +8572,11 @@ static MYSQL_SYSVAR_LONG(force_recovery, innobase_force_recovery,
   "Helps to save your data in case the disk image of the database becomes corrupt.",
   NULL, NULL, 0, 0, 6, 0);
 
+static MYSQL_SYSVAR_ULONG(recovery_threads, srv_n_recv_threads,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of threads applying redo log records in crash recovery. Each thread applies the records of its own share of the pages. Value 1 applies them in the startup thread and the I/O threads.",
+  NULL, NULL, 4L, 1L, 64L, 0);
+
 static MYSQL_SYSVAR_LONG(lock_wait_timeout, innobase_lock_wait_timeout,
   PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
   "Timeout in seconds an InnoDB transaction may wait for a lock before being rolled back.",
@@ -8425,10 +8612,20 @@ static MYSQL_SYSVAR_ULONG(sync_spin_loops, srv_n_spin_wait_rounds,
   "Count of spin-loop rounds in InnoDB mutexes",
   NULL, NULL, 20L, 0L, ~0L, 0);
 
+static MYSQL_SYSVAR_ULONG(sync_array_size, srv_sync_array_size,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of wait arrays in which threads waiting for InnoDB mutexes and rw-locks are queued. Raise it on systems with many threads contending for latches.",
+  NULL, NULL, 1L, 1L, 1024L, 0);
+
 static MYSQL_SYSVAR_ULONG(thread_concurrency, srv_thread_concurrency,
   PLUGIN_VAR_RQCMDARG,
   "Helps in performance tuning in heavily concurrent environments. Sets the maximum number of threads allowed inside InnoDB. Value 0 will disable the thread throttling.",
-  NULL, NULL, 8, 0, 1000, 0);
+  NULL, innodb_thread_concurrency_update, 8, 0, 1000, 0);
+
+static MYSQL_SYSVAR_ULONG(thread_concurrency_policy, srv_conc_policy,
+  PLUGIN_VAR_RQCMDARG,
+  "Order in which threads are admitted when innodb_thread_concurrency threads are inside InnoDB: 0 = in order of arrival (default), 1 = threads of started transactions or transactions holding locks first.",
+  NULL, NULL, 0, 0, 1, 0);
 
 static MYSQL_SYSVAR_ULONG(thread_sleep_delay, srv_thread_sleep_delay,
   PLUGIN_VAR_RQCMDARG,
@@ -8461,14 +8658,23 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(concurrency_tickets),
   MYSQL_SYSVAR(data_file_path),
   MYSQL_SYSVAR(data_home_dir),
+  MYSQL_SYSVAR(deadlock_check_budget),
+  MYSQL_SYSVAR(deadlock_detect_background),
+  MYSQL_SYSVAR(latch_profiling),
   MYSQL_SYSVAR(doublewrite),
+  MYSQL_SYSVAR(use_atomic_writes),
   MYSQL_SYSVAR(fast_shutdown),
   MYSQL_SYSVAR(file_io_threads),
   MYSQL_SYSVAR(file_per_table),
+  MYSQL_SYSVAR(lazy_open_tablespaces),
   MYSQL_SYSVAR(flush_log_at_trx_commit),
   MYSQL_SYSVAR(flush_method),
   MYSQL_SYSVAR(force_recovery),
+  MYSQL_SYSVAR(recovery_threads),
+  MYSQL_SYSVAR(ibuf_max_size_pct),
+  MYSQL_SYSVAR(io_capacity),
   MYSQL_SYSVAR(locks_unsafe_for_binlog),
+  MYSQL_SYSVAR(lock_schedule),
   MYSQL_SYSVAR(lock_wait_timeout),
 #ifdef UNIV_LOG_ARCHIVE
   MYSQL_SYSVAR(log_arch_dir),
@@ -8479,6 +8685,11 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(log_files_in_group),
   MYSQL_SYSVAR(log_group_home_dir),
   MYSQL_SYSVAR(max_dirty_pages_pct),
+  MYSQL_SYSVAR(dict_size_limit),
+  MYSQL_SYSVAR(flush_neighbors),
+  MYSQL_SYSVAR(lru_scan_depth),
+  MYSQL_SYSVAR(preallocate_extents),
+  MYSQL_SYSVAR(fill_factor),
   MYSQL_SYSVAR(max_purge_lag),
   MYSQL_SYSVAR(mirrored_log_groups),
   MYSQL_SYSVAR(open_files),
@@ -8488,9 +8699,11 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(replication_delay),
   MYSQL_SYSVAR(status_file),
   MYSQL_SYSVAR(support_xa),
+  MYSQL_SYSVAR(sync_array_size),
   MYSQL_SYSVAR(sync_spin_loops),
   MYSQL_SYSVAR(table_locks),
   MYSQL_SYSVAR(thread_concurrency),
+  MYSQL_SYSVAR(thread_concurrency_policy),
   MYSQL_SYSVAR(thread_sleep_delay),
   MYSQL_SYSVAR(autoinc_lock_mode),
   NULL
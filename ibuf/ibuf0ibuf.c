@@ -28,6 +28,7 @@ Created 7/19/1997 Heikki Tuuri
 #include "lock0lock.h"
 #include "log0recv.h"
 #include "que0que.h"
+#include "srv0srv.h"
 
 /*	STRUCTURE OF AN INSERT BUFFER RECORD
 
@@ -134,8 +135,12 @@ level 2 i/o. However, if an OS thread does the i/o handling for itself, i.e.,
 it uses synchronous aio, it can access any pages, as long as it obeys the
 access order rules. */
 
-/* Buffer pool size per the maximum insert buffer size */
-#define IBUF_POOL_SIZE_PER_MAX_SIZE	2
+/* Number of cells in the hash table of per-tablespace insert buffer
+statistics */
+#define IBUF_SPACE_HASH_SIZE		1024
+
+/* Maximum number of tablespaces listed by ibuf_print() */
+#define IBUF_PRINT_MAX_SPACES		20
 
 /* The insert buffer control structure */
 UNIV_INTERN ibuf_t*	ibuf			= NULL;
@@ -388,12 +393,18 @@ ibuf_init_at_db_start(void)
 	change */
 
 	ibuf->max_size = buf_pool_get_curr_size() / UNIV_PAGE_SIZE
-		/ IBUF_POOL_SIZE_PER_MAX_SIZE;
+		* srv_ibuf_max_size_pct / 100;
 
 	UT_LIST_INIT(ibuf->data_list);
 
 	ibuf->size = 0;
 
+	ibuf->space_hash = hash_create(IBUF_SPACE_HASH_SIZE);
+
+	ibuf->n_merges_old = 0;
+	ibuf->n_merged_recs_old = 0;
+	ibuf->last_printout_time = time(NULL);
+
 	mutex_create(&ibuf_pessimistic_insert_mutex,
 		     SYNC_IBUF_PESS_INSERT_MUTEX);
 
@@ -404,6 +415,72 @@ ibuf_init_at_db_start(void)
 	fil_ibuf_init_at_db_start();
 }
 
+/**********************************************************************
+Sets the maximum size of the insert buffer to the given percentage of the
+buffer pool. If the insert buffer is bigger than that, it is contracted
+by the master thread and by subsequent buffered inserts. */
+UNIV_INTERN
+void
+ibuf_max_size_update(
+/*=================*/
+	ulint	new_pct)/* in: maximum size of the insert buffer as a
+			percentage of the buffer pool size */
+{
+	mutex_enter(&ibuf_mutex);
+
+	ibuf->max_size = buf_pool_get_curr_size() / UNIV_PAGE_SIZE
+		* new_pct / 100;
+
+	mutex_exit(&ibuf_mutex);
+}
+
+/**********************************************************************
+Adjusts the count of insert buffer entries waiting to be merged to the
+pages of a tablespace. Entries that were buffered before the database was
+started are not counted, and removing them leaves the count at zero. */
+static
+void
+ibuf_space_pending_update(
+/*======================*/
+	ulint	space,		/* in: space id */
+	ulint	n_added,	/* in: number of entries buffered */
+	ulint	n_removed)	/* in: number of entries merged or
+				discarded */
+{
+	ibuf_space_t*	ibuf_space;
+
+	ut_ad(mutex_own(&ibuf_mutex));
+
+	HASH_SEARCH(hash, ibuf->space_hash, space,
+		    ibuf_space_t*, ibuf_space, ibuf_space->space == space);
+
+	if (ibuf_space == NULL) {
+		if (n_added <= n_removed) {
+
+			return;
+		}
+
+		ibuf_space = mem_alloc(sizeof(ibuf_space_t));
+		ibuf_space->space = space;
+		ibuf_space->n_pending = 0;
+
+		HASH_INSERT(ibuf_space_t, hash, ibuf->space_hash, space,
+			    ibuf_space);
+	}
+
+	ibuf_space->n_pending += n_added;
+
+	if (ibuf_space->n_pending > n_removed) {
+		ibuf_space->n_pending -= n_removed;
+
+		return;
+	}
+
+	HASH_DELETE(ibuf_space_t, hash, ibuf->space_hash, space, ibuf_space);
+
+	mem_free(ibuf_space);
+}
+
 /**********************************************************************
 Updates the size information in an ibuf data, assuming the segment size has
 not changed. */
@@ -2831,6 +2908,8 @@ function_exit:
 	if (err == DB_SUCCESS) {
 		ibuf_data->empty = FALSE;
 		ibuf_data->n_inserts++;
+
+		ibuf_space_pending_update(space, 1, 0);
 	}
 
 	mutex_exit(&ibuf_mutex);
@@ -3462,6 +3541,8 @@ reset_bit:
 	ibuf_data->n_merges++;
 	ibuf_data->n_merged_recs += n_inserts;
 
+	ibuf_space_pending_update(space, 0, n_inserts);
+
 	mutex_exit(&ibuf_mutex);
 
 	if (update_ibuf_bitmap && !tablespace_being_deleted) {
@@ -3571,6 +3652,8 @@ leave_loop:
 	ibuf_data->n_merges++;
 	ibuf_data->n_merged_recs += n_inserts;
 
+	ibuf_space_pending_update(space, 0, n_inserts);
+
 	mutex_exit(&ibuf_mutex);
 	/*
 	fprintf(stderr,
@@ -3664,6 +3747,41 @@ ibuf_is_empty(void)
 	return(is_empty);
 }
 
+/**********************************************************************
+Gets the current size and the operation counts of the insert buffer. */
+UNIV_INTERN
+void
+ibuf_get_stats(
+/*===========*/
+	ulint*	size,		/* out: size of the insert buffer in pages */
+	ulint*	max_size,	/* out: maximum size of the insert buffer
+				in pages */
+	ulint*	n_inserts,	/* out: number of entries buffered */
+	ulint*	n_merges,	/* out: number of pages merged */
+	ulint*	n_merged_recs)	/* out: number of entries merged */
+{
+	ibuf_data_t*	data;
+
+	*n_inserts = 0;
+	*n_merges = 0;
+	*n_merged_recs = 0;
+
+	mutex_enter(&ibuf_mutex);
+
+	*size = ibuf->size;
+	*max_size = ibuf->max_size;
+
+	for (data = UT_LIST_GET_FIRST(ibuf->data_list); data;
+	     data = UT_LIST_GET_NEXT(data_list, data)) {
+
+		*n_inserts += data->n_inserts;
+		*n_merges += data->n_merges;
+		*n_merged_recs += data->n_merged_recs;
+	}
+
+	mutex_exit(&ibuf_mutex);
+}
+
 /**********************************************************************
 Prints info of ibuf. */
 UNIV_INTERN
@@ -3673,12 +3791,30 @@ ibuf_print(
 	FILE*	file)	/* in: file where to print */
 {
 	ibuf_data_t*	data;
-#ifdef UNIV_IBUF_COUNT_DEBUG
+	ibuf_space_t*	ibuf_space;
+	time_t		current_time;
+	double		time_elapsed;
+	ulint		n_merges	= 0;
+	ulint		n_merged_recs	= 0;
+	ulint		n_spaces	= 0;
 	ulint		i;
+#ifdef UNIV_IBUF_COUNT_DEBUG
+	ulint		j;
 #endif
 
 	mutex_enter(&ibuf_mutex);
 
+	current_time = time(NULL);
+	time_elapsed = 0.001 + difftime(current_time,
+					ibuf->last_printout_time);
+	ibuf->last_printout_time = current_time;
+
+	fprintf(file,
+		"Ibuf: total size %lu, max size %lu (%lu%% of buffer pool)\n",
+		(ulong) ibuf->size,
+		(ulong) ibuf->max_size,
+		(ulong) srv_ibuf_max_size_pct);
+
 	data = UT_LIST_GET_FIRST(ibuf->data_list);
 
 	while (data) {
@@ -3692,19 +3828,53 @@ ibuf_print(
 			(ulong) data->n_merged_recs,
 			(ulong) data->n_merges);
 #ifdef UNIV_IBUF_COUNT_DEBUG
-		for (i = 0; i < IBUF_COUNT_N_PAGES; i++) {
-			if (ibuf_count_get(data->space, i) > 0) {
+		for (j = 0; j < IBUF_COUNT_N_PAGES; j++) {
+			if (ibuf_count_get(data->space, j) > 0) {
 
 				fprintf(stderr,
 					"Ibuf count for page %lu is %lu\n",
-					(ulong) i,
+					(ulong) j,
 					(ulong)
-					ibuf_count_get(data->space, i));
+					ibuf_count_get(data->space, j));
 			}
 		}
 #endif
+		n_merges += data->n_merges;
+		n_merged_recs += data->n_merged_recs;
+
 		data = UT_LIST_GET_NEXT(data_list, data);
 	}
 
+	fprintf(file,
+		"%.2f merges/s, %.2f merged recs/s\n",
+		(n_merges - ibuf->n_merges_old) / time_elapsed,
+		(n_merged_recs - ibuf->n_merged_recs_old) / time_elapsed);
+
+	ibuf->n_merges_old = n_merges;
+	ibuf->n_merged_recs_old = n_merged_recs;
+
+	for (i = 0; i < hash_get_n_cells(ibuf->space_hash); i++) {
+		for (ibuf_space = HASH_GET_FIRST(ibuf->space_hash, i);
+		     ibuf_space != NULL;
+		     ibuf_space = HASH_GET_NEXT(hash, ibuf_space)) {
+
+			if (n_spaces < IBUF_PRINT_MAX_SPACES) {
+				fprintf(file,
+					"space %lu: %lu entries"
+					" pending merge\n",
+					(ulong) ibuf_space->space,
+					(ulong) ibuf_space->n_pending);
+			}
+
+			n_spaces++;
+		}
+	}
+
+	if (n_spaces > IBUF_PRINT_MAX_SPACES) {
+		fprintf(file,
+			"... and %lu more spaces with entries pending merge\n",
+			(ulong) (n_spaces - IBUF_PRINT_MAX_SPACES));
+	}
+
 	mutex_exit(&ibuf_mutex);
 }
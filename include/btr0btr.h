@@ -356,6 +356,41 @@ btr_discard_page(
 	btr_cur_t*	cursor,	/* in: cursor on the page to discard: not on
 				the root page */
 	mtr_t*		mtr);	/* in: mtr */
+/******************************************************************
+Starts a bulk load of records into an empty index tree. The records
+must be inserted in ascending order, and no other thread may access the
+index until btr_bulk_finish() has been called. */
+UNIV_INTERN
+btr_bulk_t*
+btr_bulk_create(
+/*============*/
+				/* out, own: bulk load */
+	dict_index_t*	index,	/* in: index whose tree is empty */
+	dulint		trx_id);/* in: id of the transaction building the
+				index */
+/******************************************************************
+Appends a record to the leaf level of a bulk load. */
+UNIV_INTERN
+ulint
+btr_bulk_insert(
+/*============*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in/out: bulk load */
+	const dtuple_t*	tuple);	/* in: index entry, not smaller than the
+				previous one; it must not need externally
+				stored fields */
+/******************************************************************
+Completes a bulk load: completes the last page of each level, and copies
+the only page of the top level to the root page of the index. Frees the
+bulk load. */
+UNIV_INTERN
+ulint
+btr_bulk_finish(
+/*============*/
+				/* out: DB_SUCCESS or error code */
+	btr_bulk_t*	bulk,	/* in, own: bulk load */
+	ulint		err);	/* in: DB_SUCCESS, or the error that
+				aborted the load */
 /********************************************************************
 Parses the redo log record for setting an index record as the predefined
 minimum record. */
@@ -54,6 +54,15 @@ btr_search_info_create(
 /*===================*/
 				/* out, own: search info struct */
 	mem_heap_t*	heap);	/* in: heap where created */
+/*********************************************************************
+Returns the number of buffer pool blocks that have an adaptive hash
+index built on the index of the search info. */
+UNIV_INTERN
+ulint
+btr_search_info_get_ref_count(
+/*==========================*/
+				/* out: number of blocks */
+	btr_search_t*	info);	/* in: search info */
 /*************************************************************************
 Updates the search info. */
 UNIV_INLINE
@@ -162,6 +171,10 @@ extern ibool btr_search_disabled;
 /* The search info struct in an index */
 
 struct btr_search_struct{
+	ulint	ref_count;	/* number of blocks in the buffer pool
+				that have an adaptive hash index built
+				on this index; protected by
+				btr_search_latch */
 	/* The following fields are not protected by any latch.
 	Unfortunately, this means that they must be aligned to
 	the machine word, i.e., they cannot be turned into bit-fields. */
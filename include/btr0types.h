@@ -17,6 +17,7 @@ Created 2/17/1996 Heikki Tuuri
 typedef struct btr_pcur_struct		btr_pcur_t;
 typedef struct btr_cur_struct		btr_cur_t;
 typedef struct btr_search_struct	btr_search_t;
+typedef struct btr_bulk_struct		btr_bulk_t;
 
 /* The size of a reference to data stored on a different page.
 The reference is stored at the end of the prefix of the field
@@ -37,11 +37,33 @@ buf_flush_write_complete(
 	buf_page_t*	bpage);	/* in: pointer to the block in question */
 /*************************************************************************
 Flushes pages from the end of the LRU list if there is too small
-a margin of replaceable pages there. */
+a margin of replaceable pages there, without leaving the work to the
+LRU flusher thread. */
+UNIV_INTERN
+void
+buf_flush_free_margin_low(void);
+/*===========================*/
+/*************************************************************************
+Flushes pages from the end of the LRU list if there is too small
+a margin of replaceable pages there. If the LRU flusher thread is
+running, it is only woken up to do the flushing. */
 UNIV_INTERN
 void
 buf_flush_free_margin(void);
 /*=======================*/
+/*************************************************************************
+Flushes pages from the end of the LRU list so that the free list and the
+last pages of the LRU list contain a reserve of replaceable blocks. This is
+called by the LRU flusher thread, which owns no page latches. */
+UNIV_INTERN
+ibool
+buf_flush_LRU_reserve(
+/*==================*/
+				/* out: TRUE if pages were flushed, or
+				another LRU flush batch was running, so
+				that the reserve may still be short */
+	ulint	n_reserve);	/* in: wished number of free and
+				replaceable blocks */
 /************************************************************************
 Initializes a page for writing to the tablespace. */
 UNIV_INTERN
@@ -134,6 +156,19 @@ sweep). */
 #define BUF_FLUSH_FREE_BLOCK_MARGIN	(5 + BUF_READ_AHEAD_AREA)
 #define BUF_FLUSH_EXTRA_MARGIN		(BUF_FLUSH_FREE_BLOCK_MARGIN / 4 + 100)
 
+/* Values of innodb_flush_neighbors (srv_flush_neighbors): which dirty
+neighbors of a page are flushed along with it */
+#define BUF_FLUSH_NEIGHBORS_OFF		0	/* none */
+#define BUF_FLUSH_NEIGHBORS_AREA	1	/* all flushable pages in
+						the flush area of the page;
+						this is the default */
+#define BUF_FLUSH_NEIGHBORS_CONTIGUOUS	2	/* the flushable pages
+						adjacent to the page, up to
+						the first gap */
+#define BUF_FLUSH_NEIGHBORS_AUTO	3	/* area or off, depending
+						on the measured latency of
+						data file writes */
+
 #ifndef UNIV_NONINL
 #include "buf0flu.ic"
 #endif
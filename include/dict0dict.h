@@ -181,6 +181,16 @@ dict_table_autoinc_initialize(
 	dict_table_t*	table,	/* in/out: table */
 	ib_longlong	value);	/* in: next value to assign to a row */
 /************************************************************************
+Initializes the autoinc counter to a value that cannot be found from the
+rows of the table, as in CREATE TABLE ... AUTO_INCREMENT=N. The table is
+kept in the dictionary cache until the counter is next advanced. */
+UNIV_INTERN
+void
+dict_table_autoinc_initialize_pinned(
+/*=================================*/
+	dict_table_t*	table,	/* in/out: table */
+	ib_longlong	value);	/* in: next value to assign to a row */
+/************************************************************************
 Reads the next autoinc value (== autoinc counter value), 0 if not yet
 initialized. */
 UNIV_INTERN
@@ -230,6 +240,18 @@ dict_table_remove_from_cache(
 /*=========================*/
 	dict_table_t*	table);	/* in, own: table */
 /**************************************************************************
+Evicts unused tables from the tail of the dictionary cache LRU list until
+the cache occupies at most the given number of bytes. A table is evicted
+only if MySQL has no handles open to it, it has no locks, no foreign key
+constraints and no adaptive hash index pages in the buffer pool. Does
+nothing if a table create, drop, etc. is in progress. */
+UNIV_INTERN
+ulint
+dict_table_LRU_trim(
+/*================*/
+				/* out: number of tables evicted */
+	ulint	max_size);	/* in: size limit of the cache in bytes */
+/**************************************************************************
 Renames a table object. */
 UNIV_INTERN
 ibool
@@ -1120,6 +1142,14 @@ struct dict_sys_struct{
 	ulint		size;		/* varying space in bytes occupied
 					by the data dictionary table and
 					index objects */
+	hash_table_t*	evicted_hash;	/* hash table of the ids of the
+					tables evicted from the cache by
+					dict_table_LRU_trim() and not loaded
+					back since */
+	ulint		n_evicted;	/* number of tables evicted from
+					the cache by dict_table_LRU_trim() */
+	ulint		n_reloaded;	/* number of evicted tables loaded
+					back to the cache */
 	dict_table_t*	sys_tables;	/* SYS_TABLES table */
 	dict_table_t*	sys_columns;	/* SYS_COLUMNS table */
 	dict_table_t*	sys_indexes;	/* SYS_INDEXES table */
@@ -215,6 +215,11 @@ struct dict_index_struct{
 	unsigned	n_def:10;/* number of fields defined so far */
 	unsigned	n_fields:10;/* number of fields in the index */
 	unsigned	n_nullable:10;/* number of nullable fields */
+	unsigned	n_fixed_prefix:10;
+				/* number of fields from the beginning
+				that are fixed-length and NOT NULL; in
+				ROW_FORMAT=COMPACT their end offsets are
+				the same in every record of the index */
 	unsigned	cached:1;/* TRUE if the index object is in the
 				dictionary cache */
 	unsigned	to_be_dropped:1;
@@ -222,6 +227,11 @@ struct dict_index_struct{
 				dropped in ha_innobase::prepare_drop_index(),
 				otherwise FALSE */
 	dict_field_t*	fields;	/* array of field descriptions */
+	const ulint*	fixed_offs;/* end offsets of the first
+				n_fixed_prefix fields, as stored by
+				rec_get_offsets() in
+				rec_offs_base(offsets)[1..n_fixed_prefix],
+				or NULL */
 	UT_LIST_NODE_T(dict_index_t)
 			indexes;/* list of indexes of the table */
 	btr_search_t*	search_info; /* info used in optimistic searches */
@@ -238,6 +248,11 @@ struct dict_index_struct{
 				index tree */
 	rw_lock_t	lock;	/* read-write lock protecting the upper levels
 				of the index tree */
+	ulint		n_append_splits;
+				/* number of consecutive page splits of
+				the rightmost page of a tree level, used
+				for detecting append-only inserts;
+				protected by lock */
 #ifdef ROW_MERGE_IS_INDEX_USABLE
 	dulint		trx_id; /* id of the transaction that created this
 				index, or ut_dulint_zero if the index existed
@@ -425,6 +440,12 @@ struct dict_table_struct{
 				/* TRUE if the autoinc counter has been
 				inited; MySQL gets the init value by executing
 				SELECT MAX(auto inc column) */
+	ibool		autoinc_pinned;
+				/* TRUE if the autoinc counter was set by
+				CREATE TABLE ... AUTO_INCREMENT=N and has not
+				been advanced since; the value cannot be
+				rebuilt from the rows, and the table must
+				not be evicted from the dictionary cache */
 	ib_longlong	autoinc;/* autoinc counter value to give to the
 				next inserted row */
 	ib_longlong	autoinc_increment;
@@ -232,6 +232,18 @@ fil_space_get_zip_size(
 			if space not found */
 	ulint	id);	/* in: space id */
 /***********************************************************************
+Checks if the pages of a tablespace are written without the doublewrite
+buffer. This only needs the i/o mutex of the space, not the fil_system
+mutex. */
+UNIV_INTERN
+ibool
+fil_space_get_atomic_writes(
+/*========================*/
+			/* out: TRUE if the space is in the atomic-write
+			mode; FALSE if not, or if the space is not found
+			or none of its files has been opened yet */
+	ulint	id);	/* in: space id */
+/***********************************************************************
 Checks if the pair space, page_no refers to an existing page in a tablespace
 file space. The tablespace must be cached in the memory cache. */
 UNIV_INTERN
@@ -445,6 +457,33 @@ fil_open_single_table_tablespace(
 	const char*	name);		/* in: table name in the
 					databasename/tablename format */
 /************************************************************************
+Creates the memory objects of a single-table tablespace without opening
+its .ibd file. The file is opened, and the space id and the size in it are
+checked, when the first i/o is done to the tablespace. */
+UNIV_INTERN
+ibool
+fil_space_create_unopened(
+/*======================*/
+					/* out: TRUE if success */
+	ulint		id,		/* in: space id */
+	ulint		zip_size,	/* in: compressed page size,
+					or 0 if uncompressed tablespace */
+	const char*	name);		/* in: table name in the
+					databasename/tablename format */
+/************************************************************************
+Checks the .ibd file of a tablespace created with
+fil_space_create_unopened(), if no i/o has been done to the tablespace
+yet: the space id and the compressed page size in its header must match
+the data dictionary. If the check fails, frees the memory objects of the
+tablespace. */
+UNIV_INTERN
+ibool
+fil_space_check_unopened(
+/*=====================*/
+				/* out: TRUE if the tablespace exists
+				and its file matches the data dictionary */
+	ulint	id);		/* in: space id */
+/************************************************************************
 It is possible, though very improbable, that the lsn's in the tablespace to be
 imported have risen above the current system lsn, if a lengthy purge, ibuf
 merge, or rollback was performed on a backup taken with ibbackup. If that is
@@ -549,6 +588,27 @@ fil_extend_space_to_desired_size(
 	ulint	size_after_extend);/* in: desired size in pages after the
 				extension; if the current space size is bigger
 				than this already, the function does nothing */
+#ifndef UNIV_HOTBACKUP
+/**************************************************************************
+Asks the preallocation thread to extend a single-table tablespace in the
+background, so that later extensions of the space find the file big
+enough already and do not have to write to it. */
+UNIV_INTERN
+void
+fil_space_request_preallocation(
+/*============================*/
+	ulint	id,	/* in: space id */
+	ulint	size);	/* in: desired size of the space in pages */
+/**************************************************************************
+Extends the first tablespace waiting in the preallocation list to the
+requested size. Called by the preallocation thread. */
+UNIV_INTERN
+ibool
+fil_preallocate_next_space(void);
+/*============================*/
+				/* out: TRUE if a space was extended,
+				FALSE if the list was empty */
+#endif /* !UNIV_HOTBACKUP */
 #ifdef UNIV_HOTBACKUP
 /************************************************************************
 Extends all tablespaces to the size stored in the space header. During the
@@ -641,6 +701,16 @@ fil_flush(
 	ulint	space_id);	/* in: file space id (this can be a group of
 				log files or a tablespace of the database) */
 /**************************************************************************
+Gets the number of data file writes made durable by fil_flush() and the
+total duration of the fsyncs that did it. */
+UNIV_INTERN
+void
+fil_get_flush_time(
+/*===============*/
+	ulint*	n_writes,	/* out: number of flushed writes */
+	ullint*	time_us);	/* out: duration of their fsyncs in
+				microseconds */
+/**************************************************************************
 Flushes to disk writes in file spaces of the given type possibly cached by
 the OS. */
 UNIV_INTERN
@@ -648,6 +718,14 @@ void
 fil_flush_file_spaces(
 /*==================*/
 	ulint	purpose);	/* in: FIL_TABLESPACE, FIL_LOG */
+/************************************************************************
+Closes files from the end of the LRU list until there are at most 90 % of
+innodb_open_files open, so that an i/o seldom has to close a file before it
+can open another one. */
+UNIV_INTERN
+void
+fil_close_files_in_LRU(void);
+/*========================*/
 /**********************************************************************
 Checks the consistency of the tablespace cache. */
 UNIV_INTERN
@@ -23,6 +23,9 @@ fseg_alloc_free_page): */
 #define	FSP_UP		((byte)111)	/* alphabetically upwards */
 #define	FSP_DOWN	((byte)112)	/* alphabetically downwards */
 #define	FSP_NO_DIR	((byte)113)	/* no order */
+#define	FSP_APPEND	((byte)114)	/* sustained inserts to the right end
+					of an index level: grow the segment
+					in whole contiguous extents */
 
 /* File space extent size (one megabyte) in pages */
 #define	FSP_EXTENT_SIZE		(1 << (20 - UNIV_PAGE_SIZE_SHIFT))
@@ -189,7 +192,7 @@ fseg_alloc_free_page(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	mtr_t*		mtr);	/* in: mtr handle */
 /**************************************************************************
 Allocates a single free page from a segment. This function implements
@@ -207,7 +210,7 @@ fseg_alloc_free_page_general(
 				of an index page split, and records are
 				inserted there in order, into which
 				direction they go alphabetically: FSP_DOWN,
-				FSP_UP, FSP_NO_DIR */
+				FSP_UP, FSP_NO_DIR, FSP_APPEND */
 	ibool		has_done_reservation, /* in: TRUE if the caller has
 				already done the reservation for the page
 				with fsp_reserve_free_extents, then there
@@ -17,6 +17,7 @@ Created 7/19/1997 Heikki Tuuri
 #include "que0types.h"
 #include "ibuf0types.h"
 #include "fsp0fsp.h"
+#include "hash0hash.h"
 
 extern ibuf_t*	ibuf;
 
@@ -39,6 +40,16 @@ UNIV_INTERN
 void
 ibuf_init_at_db_start(void);
 /*=======================*/
+/**********************************************************************
+Sets the maximum size of the insert buffer to the given percentage of the
+buffer pool. If the insert buffer is bigger than that, it is contracted
+by the master thread and by subsequent buffered inserts. */
+UNIV_INTERN
+void
+ibuf_max_size_update(
+/*=================*/
+	ulint	new_pct);/* in: maximum size of the insert buffer as a
+			percentage of the buffer pool size */
 /*************************************************************************
 Reads the biggest tablespace id from the high end of the insert buffer
 tree and updates the counter in fil_system. */
@@ -294,6 +305,18 @@ ibuf_is_empty(void);
 /*===============*/
 			/* out: TRUE if empty */
 /**********************************************************************
+Gets the current size and the operation counts of the insert buffer. */
+UNIV_INTERN
+void
+ibuf_get_stats(
+/*===========*/
+	ulint*	size,		/* out: size of the insert buffer in pages */
+	ulint*	max_size,	/* out: maximum size of the insert buffer
+				in pages */
+	ulint*	n_inserts,	/* out: number of entries buffered */
+	ulint*	n_merges,	/* out: number of pages merged */
+	ulint*	n_merged_recs);	/* out: number of entries merged */
+/**********************************************************************
 Prints info of ibuf. */
 UNIV_INTERN
 void
@@ -11,5 +11,6 @@ Created 7/29/1997 Heikki Tuuri
 
 typedef struct ibuf_data_struct	ibuf_data_t;
 typedef	struct ibuf_struct	ibuf_t;
+typedef struct ibuf_space_struct ibuf_space_t;
 
 #endif
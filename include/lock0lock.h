@@ -24,6 +24,12 @@ extern ibool	lock_print_waits;
 #endif /* UNIV_DEBUG */
 /* Buffer for storing information about the most recent deadlock error */
 extern FILE*	lock_latest_err_file;
+/* Number of deadlock checks, their total number of search steps, the
+deadlocks found, and the checks deferred to the lock timeout thread */
+extern ulint	lock_deadlock_n_checks;
+extern ulint	lock_deadlock_n_steps;
+extern ulint	lock_deadlock_n_found;
+extern ulint	lock_deadlock_n_deferred;
 
 /*************************************************************************
 Gets the size of a lock struct. */
@@ -513,6 +519,14 @@ void
 lock_cancel_waiting_and_release(
 /*============================*/
 	lock_t*	lock);	/* in: waiting lock request */
+/************************************************************************
+Finishes the deadlock checks which were deferred because they ran out of
+their budget when the lock wait started. A transaction chosen as a victim
+has its lock wait cancelled. */
+UNIV_INTERN
+void
+lock_deadlock_check_deferred(void);
+/*==============================*/
 /*************************************************************************
 Resets all locks, both table and record locks, on a table to be dropped.
 No lock is allowed to be a wait lock. */
@@ -789,6 +803,13 @@ lock_rec_get_page_no(
 #define LOCK_RELEASE_WAIT	1
 #define LOCK_NOT_RELEASE_WAIT	2
 
+/* Orders in which waiting record lock requests are granted, see
+srv_lock_schedule */
+#define LOCK_SCHEDULE_FIFO	0	/* in the order of the requests */
+#define LOCK_SCHEDULE_AGE	1	/* oldest transaction first */
+#define LOCK_SCHEDULE_WEIGHT	2	/* heaviest transaction first, as
+					measured by trx_weight_cmp() */
+
 /* Lock operation struct */
 typedef struct lock_op_struct	lock_op_t;
 struct lock_op_struct{
@@ -801,7 +822,12 @@ struct lock_op_struct{
 
 /* The lock system struct */
 struct lock_sys_struct{
-	hash_table_t*	rec_hash;	/* hash table of the record locks */
+	hash_table_t*	rec_hash;	/* hash table of the record lock
+					queues of pages */
+	lock_rec_queue_t* free_queues;	/* singly linked list of unused
+					record lock queues, chained by
+					their hash field */
+	ulint		n_free_queues;	/* length of free_queues */
 };
 
 /* The lock system */
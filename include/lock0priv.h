@@ -41,8 +41,61 @@ struct lock_rec_struct {
 					bitmap; NOTE: the lock bitmap is
 					placed immediately after the
 					lock struct */
+	lock_rec_queue_t*
+		queue;			/* queue of the page, or NULL
+					if the lock has been removed
+					from the queue */
+	UT_LIST_NODE_T(lock_t)
+		locks;			/* list of locks on the same
+					page */
+	ulint	seq;			/* position in the queue: a lock
+					ahead of another one has a
+					smaller seq */
+	ulint	wait_heap_no;		/* heap number of the record
+					of a waiting lock request */
+	UT_LIST_NODE_T(lock_t)
+		state_list;		/* list of the granted locks of
+					the queue, or of the waiting
+					requests in the same cell of
+					the queue */
 };
 
+/* Number of cells in the index of the waiting lock requests of a
+record lock queue */
+#define LOCK_REC_QUEUE_N_CELLS	8
+
+/* Record lock queue of a page. The queues are kept in lock_sys->rec_hash,
+so that the locks of a page can be found without walking past the locks
+of other pages that happen to hash to the same cell. The granted locks and
+the waiting requests are also kept in separate lists, the latter by the
+heap number of their record, so that a conflict check or a grant for one
+record need not walk past the waiting requests for the other records. */
+struct lock_rec_queue_struct {
+	ulint		space;		/* space id */
+	ulint		page_no;	/* page number */
+	ulint		n_waiting;	/* number of waiting lock requests
+					in the queue */
+	ulint		next_seq;	/* seq of the next lock appended
+					to the queue */
+	UT_LIST_BASE_NODE_T(lock_t)
+			locks;		/* record locks on the page, in
+					the order they were enqueued */
+	UT_LIST_BASE_NODE_T(lock_t)
+			granted;	/* granted locks on the page, in
+					no particular order */
+	UT_LIST_BASE_NODE_T(lock_t)
+			waiting[LOCK_REC_QUEUE_N_CELLS];
+					/* waiting lock requests in queue
+					order, by the heap number of their
+					record modulo
+					LOCK_REC_QUEUE_N_CELLS */
+	hash_node_t	hash;		/* hash chain node */
+};
+
+/* The cell of the waiting lock requests for a record in a queue */
+#define LOCK_REC_QUEUE_CELL(queue, heap_no)				\
+	((queue)->waiting[(heap_no) % LOCK_REC_QUEUE_N_CELLS])
+
 /* Lock struct */
 struct lock_struct {
 	trx_t*		trx;		/* transaction owning the
@@ -54,8 +107,6 @@ struct lock_struct {
 					LOCK_REC_NOT_GAP,
 					LOCK_INSERT_INTENTION,
 					wait flag, ORed */
-	hash_node_t	hash;		/* hash chain node for a record
-					lock */
 	dict_index_t*	index;		/* index for a record lock */
 	union {
 		lock_table_t	tab_lock;/* table lock */
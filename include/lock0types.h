@@ -12,6 +12,7 @@ Created 5/7/1996 Heikki Tuuri
 #define lock_t ib_lock_t
 typedef struct lock_struct	lock_t;
 typedef struct lock_sys_struct	lock_sys_t;
+typedef struct lock_rec_queue_struct	lock_rec_queue_t;
 
 /* Basic lock modes */
 enum lock_mode {
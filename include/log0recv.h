@@ -329,6 +329,11 @@ struct recv_sys_struct{
 	hash_table_t*	addr_hash;/* hash table of file addresses of pages */
 	ulint		n_addrs;/* number of not processed hashed file
 				addresses in the hash table */
+	ulint		n_apply_threads;
+				/* number of recovery threads that are
+				applying the current batch of log records,
+				or 0 if the batch is applied by the calling
+				thread and the i/o-handler threads */
 };
 
 extern recv_sys_t*	recv_sys;
@@ -358,6 +363,9 @@ roll-forward */
 
 extern ulint	recv_n_pool_free_frames;
 
+/* Maximum number of threads applying log records in parallel */
+#define RECV_MAX_N_THREADS	64
+
 #ifndef UNIV_NONINL
 #include "log0recv.ic"
 #endif
@@ -64,6 +64,13 @@ void
 mem_init(
 /*=====*/
 	ulint	size);	/* in: common pool size in bytes */
+/**********************************************************************
+Frees the area caches of the common memory pool. Its memory is freed by
+ut_free_all_mem(). */
+UNIV_INTERN
+void
+mem_close(void);
+/*===========*/
 /******************************************************************
 Use this macro instead of the corresponding function! Macro for memory
 heap creation. */
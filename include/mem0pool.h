@@ -43,6 +43,14 @@ mem_pool_create(
 			/* out: memory pool */
 	ulint	size);	/* in: pool size in bytes */
 /************************************************************************
+Returns the areas held in the caches of a pool to the pool and frees the
+caches. */
+UNIV_INTERN
+void
+mem_pool_free_caches(
+/*=================*/
+	mem_pool_t*	pool);	/* in: memory pool */
+/************************************************************************
 Allocates memory from a pool. NOTE: This low-level function should only be
 used in mem0mem.*! */
 UNIV_INTERN
@@ -71,7 +79,8 @@ UNIV_INTERN
 ulint
 mem_pool_get_reserved(
 /*==================*/
-				/* out: reserved mmeory in bytes */
+				/* out: reserved memory in bytes,
+				excluding the cached areas */
 	mem_pool_t*	pool);	/* in: memory pool */
 /************************************************************************
 Reserves the mem pool mutex. */
@@ -382,6 +382,33 @@ os_file_get_size_as_iblonglong(
 				/* out: size in bytes, -1 if error */
 	os_file_t	file);	/* in: handle to a file */
 /***************************************************************************
+Checks if writes to a file bypass the file cache of the operating system,
+that is, if the file was opened with O_DIRECT or FILE_FLAG_NO_BUFFERING. */
+UNIV_INTERN
+ibool
+os_file_is_unbuffered(
+/*==================*/
+				/* out: TRUE if the file is known to be
+				unbuffered */
+	os_file_t	file);	/* in: handle to a file */
+/***************************************************************************
+Reserves disk space for a region of a file with posix_fallocate(), without
+writing to it; the region reads as zeros. */
+UNIV_INTERN
+ibool
+os_file_allocate(
+/*=============*/
+				/* out: TRUE if success; FALSE if the
+				operating system or file system cannot do
+				this or there is no space: the caller should
+				then write zeros to the file */
+	os_file_t	file,	/* in: handle to a file */
+	ulint		offset,	/* in: least significant 32 bits of the
+				file offset where the region starts */
+	ulint		offset_high,/* in: most significant 32 bits of
+				offset */
+	ulint		len);	/* in: length of the region in bytes */
+/***************************************************************************
 Write the specified number of zeros to a newly created file. */
 UNIV_INTERN
 ibool
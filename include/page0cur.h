@@ -216,6 +216,20 @@ page_copy_rec_list_end_to_created_page(
 	rec_t*		rec,		/* in: first record to copy */
 	dict_index_t*	index,		/* in: record descriptor */
 	mtr_t*		mtr);		/* in: mtr */
+/*****************************************************************
+Writes the log for the records of a newly created page that were appended
+to it one by one with page_cur_insert_rec_low() while logging was switched
+off. The log is that of page_copy_rec_list_end_to_created_page(): in
+recovery the records are appended to the created page in the same order,
+which rebuilds the page exactly, and PAGE_LAST_INSERT, PAGE_DIRECTION and
+PAGE_N_DIRECTION are reset; the caller must reset them on the page. */
+UNIV_INTERN
+void
+page_cur_log_appended_recs(
+/*=======================*/
+	page_t*		page,	/* in: index page */
+	dict_index_t*	index,	/* in: record descriptor */
+	mtr_t*		mtr);	/* in: mtr */
 /***************************************************************
 Deletes a record at the page cursor. The cursor is moved to the
 next record after the deleted one. */
@@ -62,6 +62,15 @@ offsets[] array, first passed to rec_get_offsets() */
 #define REC_OFFS_NORMAL_SIZE	100
 #define REC_OFFS_SMALL_SIZE	10
 
+/* Number of fields that an offsets[] array of REC_OFFS_NORMAL_SIZE
+elements can describe; rec_get_offsets() will not allocate from the
+heap for records with at most this many fields */
+#define REC_OFFS_NORMAL_N_FIELDS (REC_OFFS_NORMAL_SIZE - 1		\
+				  - REC_OFFS_HEADER_SIZE)
+#if REC_OFFS_NORMAL_N_FIELDS < 64
+# error "REC_OFFS_NORMAL_N_FIELDS < 64"
+#endif
+
 /**********************************************************
 The following function is used to get the pointer of the next chained record
 on the same page. */
@@ -25,6 +25,13 @@ extern const char	srv_mysql50_table_name_prefix[9];
 thread starts running */
 extern os_event_t	srv_lock_timeout_thread_event;
 
+/* The LRU flusher thread waits for this event between its batches */
+extern os_event_t	srv_LRU_flusher_event;
+
+/* The preallocation thread waits for this event when no tablespace needs
+to be extended */
+extern os_event_t	srv_preallocate_event;
+
 /* If the last data file is auto-extended, we add this many pages to it
 at a time */
 #define SRV_AUTO_EXTEND_INCREMENT	\
@@ -92,6 +99,7 @@ extern ulint	srv_mem_pool_size;
 extern ulint	srv_lock_table_size;
 
 extern ulint	srv_n_file_io_threads;
+extern ulong	srv_n_recv_threads;
 
 #ifdef UNIV_LOG_ARCHIVE
 extern ibool	srv_log_archive_on;
@@ -100,6 +108,10 @@ extern dulint	srv_archive_recovery_limit_lsn;
 #endif /* UNIV_LOG_ARCHIVE */
 
 extern ulint	srv_lock_wait_timeout;
+extern ulong	srv_deadlock_check_budget_usec;
+extern ibool	srv_deadlock_detect_background;
+extern ulong	srv_lock_schedule;
+extern ibool	srv_latch_profiling;
 
 extern char*	srv_file_flush_method_str;
 extern ulint	srv_unix_file_flush_method;
@@ -115,7 +127,8 @@ extern ulong	srv_commit_concurrency;
 
 extern ulint	srv_max_n_threads;
 
-extern lint	srv_conc_n_threads;
+extern volatile lint	srv_conc_n_threads;
+extern ulong	srv_conc_policy;
 
 extern ulint	srv_fast_shutdown;	 /* If this is 1, do not do a
 					 purge and index buffer merge.
@@ -130,13 +143,26 @@ extern ibool	srv_stats_on_metadata;
 
 extern ibool	srv_use_doublewrite_buf;
 extern ibool	srv_use_checksums;
+extern ibool	srv_use_atomic_writes;
+extern ibool	srv_lazy_open_tablespaces;
 
 extern ibool	srv_set_thread_priorities;
 extern int	srv_query_thread_priority;
 
 extern ulong	srv_max_buf_pool_modified_pct;
+extern ulong	srv_dict_size_limit;
+extern ulong	srv_flush_neighbors;
+extern ulong	srv_LRU_scan_depth;
+extern ulong	srv_preallocate_extents;
+extern ulong	srv_fill_factor;
 extern ulong	srv_max_purge_lag;
 
+extern ulong	srv_io_capacity;
+extern ulong	srv_ibuf_max_size_pct;
+
+/* The number of I/O operations that make up p percent of srv_io_capacity */
+#define PCT_IO(p)	((ulong) (srv_io_capacity * ((double) (p) / 100.0)))
+
 extern ulint	srv_replication_delay;
 /*-------------------------------------------*/
 
@@ -153,11 +179,14 @@ extern ibool	srv_print_innodb_table_monitor;
 
 extern ibool	srv_lock_timeout_and_monitor_active;
 extern ibool	srv_error_monitor_active;
+extern ibool	srv_LRU_flusher_active;
+extern ibool	srv_preallocate_active;
 
 extern ulong	srv_n_spin_wait_rounds;
 extern ulong	srv_n_free_tickets_to_enter;
 extern ulong	srv_thread_sleep_delay;
 extern ulint	srv_spin_wait_delay;
+extern ulong	srv_sync_array_size;
 extern ibool	srv_priority_boost;
 
 extern	ulint	srv_mem_pool_size;
@@ -224,6 +253,10 @@ extern ulint srv_dblwr_writes;
 doublewrite buffer */
 extern ulint srv_dblwr_pages_written;
 
+/* here we store the number of pages of tablespaces in the atomic-write
+mode that were written without the doublewrite buffer */
+extern ulint srv_dblwr_pages_skipped;
+
 /* in this variable we store the number of write requests issued */
 extern ulint srv_buf_pool_write_requests;
 
@@ -236,6 +269,10 @@ extern ulint srv_buf_pool_wait_free;
 buffer pool to disk */
 extern ulint srv_buf_pool_flushed;
 
+/* variable to count the pages that were flushed because they were
+neighbors of a page picked for flushing */
+extern ulint srv_buf_pool_flushed_neighbors;
+
 /* variable to count the number of buffer pool reads that led to the
 reading of a disk page */
 extern ulint srv_buf_pool_reads;
@@ -267,11 +304,21 @@ about what these mean */
 #define SRV_UNIX_LITTLESYNC	3
 #define SRV_UNIX_NOSYNC		4
 #define SRV_UNIX_O_DIRECT	5
+#define SRV_UNIX_ALL_O_DIRECT	6	/* like SRV_UNIX_O_DIRECT, but
+					also the log files are opened with
+					O_DIRECT; the log is still flushed
+					with fsync() after writes */
 
 /* Alternatives for file i/o in Windows */
 #define SRV_WIN_IO_NORMAL		1
 #define SRV_WIN_IO_UNBUFFERED		2	/* This is the default */
 
+/* Alternatives for srv_conc_policy, the order in which threads are
+admitted to InnoDB when srv_thread_concurrency threads are inside */
+#define SRV_CONC_POLICY_FIFO	0	/* in the order of arrival */
+#define SRV_CONC_POLICY_TRX	1	/* threads whose transaction has
+					started or holds locks first */
+
 /* Alternatives for srv_force_recovery. Non-zero values are intended
 to help the user get a damaged database up so that he can dump intact
 tables and rows with SELECT INTO OUTFILE. The database must not otherwise
@@ -398,8 +445,18 @@ void
 srv_wake_master_thread(void);
 /*========================*/
 /*************************************************************************
+Wakes up all threads waiting for admission to InnoDB, so that they check
+their admission again. This must be called when srv_thread_concurrency
+is changed. */
+UNIV_INTERN
+void
+srv_conc_wake_all(void);
+/*===================*/
+/*************************************************************************
 Puts an OS thread to wait if there are too many concurrent threads
-(>= srv_thread_concurrency) inside InnoDB. The threads wait in a FIFO queue. */
+(>= srv_thread_concurrency) inside InnoDB. The threads are admitted in the
+order in which they draw tickets; with SRV_CONC_POLICY_TRX the threads of
+started transactions are admitted first. */
 UNIV_INTERN
 void
 srv_conc_enter_innodb(
@@ -473,6 +530,28 @@ srv_error_monitor_thread(
 			/* out: a dummy parameter */
 	void*	arg);	/* in: a dummy parameter required by
 			os_thread_create */
+/*************************************************************************
+A thread which keeps a reserve of replaceable blocks in the buffer pool by
+flushing pages from the end of the LRU list, so that the user threads
+needing a free block do not have to do the flushing themselves. */
+UNIV_INTERN
+os_thread_ret_t
+srv_LRU_flusher_thread(
+/*===================*/
+			/* out: a dummy parameter */
+	void*	arg);	/* in: a dummy parameter required by
+			os_thread_create */
+/*************************************************************************
+A thread which extends the files of growing tablespaces ahead of their
+use, so that the user threads allocating pages seldom have to wait for
+a file extension. */
+UNIV_INTERN
+os_thread_ret_t
+srv_preallocate_thread(
+/*===================*/
+			/* out: a dummy parameter */
+	void*	arg);	/* in: a dummy parameter required by
+			os_thread_create */
 /**********************************************************************
 Outputs to a file the output of the InnoDB Monitor. */
 UNIV_INTERN
@@ -518,11 +597,29 @@ struct export_var_struct{
 	ulint innodb_buffer_pool_reads;
 	ulint innodb_buffer_pool_wait_free;
 	ulint innodb_buffer_pool_pages_flushed;
+	ulint innodb_buffer_pool_pages_flushed_neighbors;
 	ulint innodb_buffer_pool_write_requests;
 	ulint innodb_buffer_pool_read_ahead_seq;
 	ulint innodb_buffer_pool_read_ahead_rnd;
+	ulint innodb_conc_queue_length;
+	ulint innodb_conc_queue_length_max;
+	ulint innodb_conc_waits;
+	ib_longlong innodb_conc_wait_time;
+	ulint innodb_conc_prio_admissions;
+	ulint innodb_dblwr_pages_skipped;
 	ulint innodb_dblwr_pages_written;
 	ulint innodb_dblwr_writes;
+	ulint innodb_deadlock_checks;
+	ulint innodb_deadlock_checks_deferred;
+	ulint innodb_deadlock_steps;
+	ulint innodb_deadlocks;
+	ulint innodb_dict_tables_evicted;
+	ulint innodb_dict_tables_reloaded;
+	ulint innodb_ibuf_inserts;
+	ulint innodb_ibuf_max_size;
+	ulint innodb_ibuf_merged_recs;
+	ulint innodb_ibuf_merges;
+	ulint innodb_ibuf_size;
 	ulint innodb_log_waits;
 	ulint innodb_log_write_requests;
 	ulint innodb_log_writes;
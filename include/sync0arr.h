@@ -20,6 +20,29 @@ typedef struct sync_array_struct	sync_array_t;
 #define SYNC_ARRAY_OS_MUTEX	1
 #define SYNC_ARRAY_MUTEX	2
 
+/* The wait arrays used by the database's own mutexes and rw-locks; a
+waiting thread reserves its cell in the array picked by its thread id,
+so that threads waiting for the same latch do not all contend for the
+mutex of one array */
+extern sync_array_t**	sync_wait_array;
+/* Number of arrays in sync_wait_array */
+extern ulint		sync_array_size;
+
+/***********************************************************************
+Creates the sync_array_size primary wait arrays. */
+UNIV_INTERN
+void
+sync_array_init(
+/*============*/
+	ulint	n_threads);	/* in: number of threads that can wait
+				at the same time */
+/***********************************************************************
+Frees the primary wait arrays. */
+UNIV_INTERN
+void
+sync_array_close(void);
+/*==================*/
+
 /***********************************************************************
 Creates a synchronization wait array. It is protected by a mutex
 which is automatically reserved when the functions operating on it
@@ -45,9 +68,11 @@ sync_array_free(
 Reserves a wait array cell for waiting for an object.
 The event of the cell is reset to nonsignalled state. */
 UNIV_INTERN
-void
+ibool
 sync_array_reserve_cell(
 /*====================*/
+				/* out: TRUE if a cell was reserved,
+				FALSE if the array is full */
 	sync_array_t*	arr,	/* in: wait array */
 	void*		object, /* in: pointer to the object to wait for */
 	ulint		type,	/* in: lock request type */
@@ -55,6 +80,23 @@ sync_array_reserve_cell(
 	ulint		line,	/* in: line where requested */
 	ulint*		index); /* out: index of the reserved cell */
 /**********************************************************************
+Reserves a cell for the current thread in one of the primary wait
+arrays. The array of the thread is tried first; if it is full, the
+following ones. */
+UNIV_INTERN
+sync_array_t*
+sync_array_get_and_reserve_cell(
+/*============================*/
+				/* out: the wait array where the cell
+				was reserved; pass it to
+				sync_array_wait_event() or
+				sync_array_free_cell() */
+	void*		object, /* in: pointer to the object to wait for */
+	ulint		type,	/* in: lock request type */
+	const char*	file,	/* in: file where requested */
+	ulint		line,	/* in: line where requested */
+	ulint*		index); /* out: index of the reserved cell */
+/**********************************************************************
 This function should be called when a thread starts to wait on
 a wait array cell. In the debug version this function checks
 if the wait for a semaphore will result in a deadlock, in which
@@ -78,9 +120,8 @@ sync_array_free_cell(
 Note that one of the wait objects was signalled. */
 UNIV_INTERN
 void
-sync_array_object_signalled(
-/*========================*/
-	sync_array_t*	arr);	/* in: wait array */
+sync_array_object_signalled(void);
+/*=============================*/
 /**************************************************************************
 If the wakeup algorithm does not work perfectly at semaphore relases,
 this function will do the waking (see the comment in mutex_exit). This
@@ -106,13 +147,12 @@ sync_array_validate(
 /*================*/
 	sync_array_t*	arr);	/* in: sync wait array */
 /**************************************************************************
-Prints info of the wait array. */
+Prints info of the primary wait arrays. */
 UNIV_INTERN
 void
 sync_array_print_info(
 /*==================*/
-	FILE*		file,	/* in: file where to print */
-	sync_array_t*	arr);	/* in: wait array */
+	FILE*		file);	/* in: file where to print */
 
 
 #ifndef UNIV_NONINL
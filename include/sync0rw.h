@@ -24,6 +24,19 @@ smaller than 30 and the order of the numerical values like below! */
 #define	RW_X_LATCH	2
 #define	RW_NO_LATCH	3
 
+/* If the compiler provides atomic operations, the lock word of an rw-lock
+is updated with them; otherwise each rw-lock has a mutex which protects
+the lock word */
+#ifdef HAVE_GCC_ATOMIC_BUILTINS
+# define INNODB_RW_LOCKS_USE_ATOMICS
+#endif
+
+/* The amount by which an x-lock decrements the lock word of an rw-lock;
+an s-lock decrements it by one. The lock word of an unlocked rw-lock is
+X_LOCK_DECR. This also limits the number of simultaneous s-lock holders
+to X_LOCK_DECR - 1. */
+#define X_LOCK_DECR	0x00100000
+
 typedef struct rw_lock_struct		rw_lock_t;
 #ifdef UNIV_SYNC_DEBUG
 typedef struct rw_lock_debug_struct	rw_lock_debug_t;
@@ -316,13 +329,13 @@ rw_lock_x_unlock_direct(
 /*====================*/
 	rw_lock_t*	lock);	/* in: rw-lock */
 /**********************************************************************
-Returns the value of writer_count for the lock. Does not reserve the lock
-mutex, so the caller must be sure it is not changed during the call. */
+Returns the number of x-locks the writer thread holds on the lock. The
+caller must be sure it is not changed during the call. */
 UNIV_INLINE
 ulint
 rw_lock_get_x_lock_count(
 /*=====================*/
-				/* out: value of writer_count */
+				/* out: number of recursive x-locks */
 	rw_lock_t*	lock);	/* in: rw-lock */
 /************************************************************************
 Accessor functions for rw lock. */
@@ -341,6 +354,33 @@ ulint
 rw_lock_get_reader_count(
 /*=====================*/
 	rw_lock_t*	lock);
+/**********************************************************************
+Decrements lock_word the specified amount if it is greater than 0.
+This is used by both s_lock and x_lock operations. */
+UNIV_INLINE
+ibool
+rw_lock_lock_word_decr(
+/*===================*/
+				/* out: TRUE if decr occurs */
+	rw_lock_t*	lock,	/* in: rw-lock */
+	ulint		amount);/* in: amount to decrement */
+/**********************************************************************
+Increments lock_word the specified amount and returns new value. */
+UNIV_INLINE
+lint
+rw_lock_lock_word_incr(
+/*===================*/
+				/* out: lock->lock_word after increment */
+	rw_lock_t*	lock,	/* in: rw-lock */
+	ulint		amount);/* in: amount to increment */
+/**********************************************************************
+This function sets the lock->writer_thread and lock->recursive fields. */
+UNIV_INLINE
+void
+rw_lock_set_writer_id_and_recursion_flag(
+/*=====================================*/
+	rw_lock_t*	lock,		/* in/out: lock to work on */
+	ibool		recursive);	/* in: TRUE if recursion allowed */
 #ifdef UNIV_SYNC_DEBUG
 /**********************************************************************
 Checks if the thread has locked the rw-lock in the specified mode, with
@@ -417,44 +457,56 @@ Do not use its fields directly! The structure used in the spin lock
 implementation of a read-write lock. Several threads may have a shared lock
 simultaneously in this lock, but only one writer may have an exclusive lock,
 in which case no shared locks are allowed. To prevent starving of a writer
-blocked by readers, a writer may queue for the lock by setting the writer
-field. Then no new readers are allowed in. */
+blocked by readers, a writer may queue for the lock by reserving it with an
+x-decrement of the lock word while readers still hold it. Then no new
+readers are allowed in.
+
+The state of the lock is kept in the single word lock_word:
+
+lock_word == X_LOCK_DECR:	unlocked
+0 < lock_word < X_LOCK_DECR:	s-locked by X_LOCK_DECR - lock_word
+				readers, no writer waiting
+lock_word == 0:			x-locked
+-X_LOCK_DECR < lock_word < 0:	s-locked by -lock_word readers, and a
+				writer is waiting for them to leave
+				(RW_LOCK_WAIT_EX)
+lock_word <= -X_LOCK_DECR:	x-locked recursively, each recursive
+				x-lock decrements lock_word by X_LOCK_DECR
+
+A lock is acquired by decrementing lock_word only if it is positive,
+released by incrementing it. The fast paths therefore need no mutex: with
+INNODB_RW_LOCKS_USE_ATOMICS they are a compare-and-swap or an atomic
+add. Threads which cannot get the lock by spinning wait in the sync
+array; a writer waiting for the readers to leave waits on wait_ex_event,
+everybody else on event. */
 
 struct rw_lock_struct {
+	volatile lint	lock_word;
+				/* Holds the state of the lock */
+	volatile ulint	waiters;/* 1: there are waiters in the sync
+				array for event */
+	volatile ibool	recursive;/* Default value FALSE which means the
+				lock is non-recursive. The value is set
+				to TRUE by the x-locking thread, making
+				the lock recursive for it, unless it
+				passes the lock to another thread to
+				unlock (pass != 0, asynchronous i/o).
+				This also tells if writer_thread is
+				valid. */
+	volatile os_thread_id_t	writer_thread;
+				/* Thread id of the writer thread; valid
+				only if recursive is TRUE */
 	os_event_t	event;	/* Used by sync0arr.c for thread queueing */
-
-#ifdef __WIN__
-	os_event_t	wait_ex_event;	/* This windows specific event is
-				used by the thread which has set the
-				lock state to RW_LOCK_WAIT_EX. The
+	os_event_t	wait_ex_event;
+				/* Event for the next-writer which waits
+				for the readers to leave the lock: the
 				rw_lock design guarantees that this
 				thread will be the next one to proceed
-				once the current the event gets
-				signalled. See LEMMA 2 in sync0sync.c */
-#endif
-
-	ulint	reader_count;	/* Number of readers who have locked this
-				lock in the shared mode */
-	ulint	writer;		/* This field is set to RW_LOCK_EX if there
-				is a writer owning the lock (in exclusive
-				mode), RW_LOCK_WAIT_EX if a writer is
-				queueing for the lock, and
-				RW_LOCK_NOT_LOCKED, otherwise. */
-	os_thread_id_t	writer_thread;
-				/* Thread id of a possible writer thread */
-	ulint	writer_count;	/* Number of times the same thread has
-				recursively locked the lock in the exclusive
-				mode */
-	mutex_t	mutex;		/* The mutex protecting rw_lock_struct */
-	ulint	pass;		/* Default value 0. This is set to some
-				value != 0 given by the caller of an x-lock
-				operation, if the x-lock is to be passed to
-				another thread to unlock (which happens in
-				asynchronous i/o). */
-	ulint	waiters;	/* This ulint is set to 1 if there are
-				waiters (readers or writers) in the global
-				wait array, waiting for this rw_lock.
-				Otherwise, == 0. */
+				once the current readers have left.
+				See LEMMA 2 in sync0sync.c */
+#ifndef INNODB_RW_LOCKS_USE_ATOMICS
+	mutex_t	mutex;		/* The mutex protecting lock_word */
+#endif /* INNODB_RW_LOCKS_USE_ATOMICS */
 	UT_LIST_NODE_T(rw_lock_t) list;
 				/* All allocated rw locks are put into a
 				list */
@@ -467,16 +519,17 @@ struct rw_lock_struct {
 	const char*	cfile_name;/* File name where lock created */
 	const char*	last_s_file_name;/* File name where last s-locked */
 	const char*	last_x_file_name;/* File name where last x-locked */
-	ibool		writer_is_wait_ex;
-				/* This is TRUE if the writer field is
-				RW_LOCK_WAIT_EX; this field is located far
-				from the memory update hotspot fields which
-				are at the start of this struct, thus we can
-				peek this field without causing much memory
-				bus traffic */
 	unsigned	cline:14;	/* Line where created */
 	unsigned	last_s_line:14;	/* Line number where last time s-locked */
 	unsigned	last_x_line:14;	/* Line number where last time x-locked */
+	ulong		count_os_wait;	/* count of OS waits for the lock */
+	ulong		count_spin_loop;/* count of spin loops; this and the
+				two fields below are only updated while
+				srv_latch_profiling is set */
+	ulong		count_spin_rounds;/* count of spin rounds */
+	ullint		lspent_time;	/* time spent waiting for the lock
+				after the first spin loop, in
+				microseconds */
 	ulint	magic_n;
 };
 
@@ -21,6 +21,8 @@ Created 9/5/1995 Heikki Tuuri
 extern my_bool	timed_mutexes;
 #endif /* UNIV_HOTBACKUP */
 
+typedef struct sync_latch_class_struct	sync_latch_class_t;
+
 /**********************************************************************
 Initializes the synchronization data structures. */
 UNIV_INTERN
@@ -139,6 +141,20 @@ UNIV_INTERN
 ibool
 sync_all_freed(void);
 /*================*/
+#ifndef UNIV_HOTBACKUP
+/**********************************************************************
+Sums up the contention counters of the mutexes and rw-locks by the
+place where they were created. Only the creation sites where some latch
+has been waited for are returned. */
+UNIV_INTERN
+sync_latch_class_t*
+sync_latch_classes_collect(
+/*=======================*/
+				/* out, own: array of latch classes, to
+				be freed with ut_free(), or NULL if
+				there were none */
+	ulint*	n_classes);	/* out: number of elements in the array */
+#endif /* !UNIV_HOTBACKUP */
 /*#####################################################################
 FUNCTION PROTOTYPES FOR DEBUGGING */
 /***********************************************************************
@@ -442,6 +458,9 @@ or row lock! */
 #define	SYNC_BUF_BLOCK		149
 #define SYNC_DOUBLEWRITE	140
 #define	SYNC_ANY_LATCH		135
+#define	SYNC_FIL_IO		134	/* fil_system->io_mutexes; reserved
+					after the fil_system mutex, which is
+					SYNC_ANY_LATCH */
 #define SYNC_THR_LOCAL		133
 #define	SYNC_MEM_HASH		131
 #define	SYNC_MEM_POOL		130
@@ -489,23 +508,42 @@ struct mutex_struct {
 #endif /* UNIV_DEBUG */
 #ifndef UNIV_HOTBACKUP
 	ulong		count_os_wait; /* count of os_wait */
+	ulong		count_spin_loop; /* count of spin loops; this and
+				the two fields below are only updated
+				while srv_latch_profiling is set */
+	ulong		count_spin_rounds; /* count of spin rounds */
+	ulonglong	lspent_time; /* time spent waiting for the mutex
+				after the first spin loop, in
+				microseconds */
 # ifdef UNIV_DEBUG
 	ulong		count_using; /* count of times mutex used */
-	ulong		count_spin_loop; /* count of spin loops */
-	ulong		count_spin_rounds; /* count of spin rounds */
 	ulong		count_os_yield; /* count of os_wait */
-	ulonglong	lspent_time; /* mutex os_wait timer msec */
-	ulonglong	lmax_spent_time; /* mutex os_wait timer msec */
+	ulonglong	lmax_spent_time; /* longest wait in microseconds */
 	const char*	cmutex_name;/* mutex name */
 	ulint		mutex_type;/* 0 - usual mutex 1 - rw_lock mutex	 */
 # endif /* UNIV_DEBUG */
 #endif /* !UNIV_HOTBACKUP */
 };
 
-/* The global array of wait cells for implementation of the databases own
-mutexes and read-write locks. Appears here for debugging purposes only! */
-
-extern sync_array_t*	sync_primary_wait_array;
+/* The contention counters of all the mutexes or rw-locks created at one
+place in the source code, see sync_latch_classes_collect() */
+struct sync_latch_class_struct {
+	const char*	cfile_name;	/* file where the latches were
+					created */
+	ulint		cline;		/* line where the latches were
+					created */
+	ibool		is_rw_lock;	/* TRUE if rw-locks, FALSE if
+					mutexes */
+	ulint		n_latches;	/* number of latches created here
+					which have been waited for */
+	ulint		spin_waits;	/* sum of count_spin_loop */
+	ulint		spin_rounds;	/* sum of count_spin_rounds */
+	ulint		os_waits;	/* sum of count_os_wait */
+	ullint		os_wait_time;	/* sum of lspent_time, in
+					microseconds */
+	sync_latch_class_t* hash;	/* hash chain node, used while
+					collecting */
+};
 
 /* Constant determining how long spin wait is continued before suspending
 the thread. A value 600 rounds on a 1995 100 MHz Pentium seems to correspond
@@ -397,15 +397,33 @@ this contains the same fields as TRX_SYS_MYSQL_LOG_INFO below */
 
 #define TRX_SYS_DOUBLEWRITE_BLOCK_SIZE	FSP_EXTENT_SIZE
 
-/* Doublewrite control struct */
-struct trx_doublewrite_struct{
+/* Number of slots the doublewrite buffer is divided into; each slot is
+written and flushed independently of the others, so that an LRU flush
+batch and a flush list batch do not wait for each other */
+#define TRX_DOUBLEWRITE_N_SLOTS		2
+
+/* Doublewrite buffer slot: consecutive pages inside one of the two
+doublewrite blocks */
+struct trx_doublewrite_slot_struct{
 	mutex_t	mutex;		/* mutex protecting the first_free field and
 				write_buf */
+	ulint	page_no;	/* page number of the first page of the
+				slot in the system tablespace */
+	ulint	n_pages;	/* number of pages in the slot */
+	ulint	first_free;	/* first free position in write_buf measured
+				in units of UNIV_PAGE_SIZE */
+	byte*	write_buf;	/* the part of trx_doublewrite->write_buf
+				used by this slot */
+	buf_page_t**
+		buf_block_arr;	/* array to store pointers to the buffer
+				blocks which have been cached to write_buf */
+};
+
+/* Doublewrite control struct */
+struct trx_doublewrite_struct{
 	ulint	block1;		/* the page number of the first
 				doublewrite block (64 pages) */
 	ulint	block2;		/* page number of the second block */
-	ulint	first_free;	/* first free position in write_buf measured
-				in units of UNIV_PAGE_SIZE */
 	byte*	write_buf;	/* write buffer used in writing to the
 				doublewrite buffer, aligned to an
 				address divisible by UNIV_PAGE_SIZE
@@ -414,6 +432,9 @@ struct trx_doublewrite_struct{
 	buf_page_t**
 		buf_block_arr;	/* array to store pointers to the buffer
 				blocks which have been cached to write_buf */
+	trx_doublewrite_slot_t
+		slots[TRX_DOUBLEWRITE_N_SLOTS];
+				/* the slots of the doublewrite buffer */
 };
 
 /* The transaction system central memory data structure; protected by the
@@ -667,10 +667,18 @@ struct trx_struct{
 					trx that are in the QUE_THR_LOCK_WAIT
 					state */
 	ulint		deadlock_mark;	/* a mark field used in deadlock
-					checking algorithm.  This must be
+					checking algorithm: the identifier
+					of the latest search which searched
+					the waits-for graph behind this trx
+					exhaustively.  This must be
 					in its own machine word, because
 					it can be changed by other
 					threads while holding kernel_mutex. */
+	ibool		deadlock_check_deferred;
+					/* TRUE if the deadlock check of the
+					current lock wait ran out of its
+					budget and is to be finished by
+					lock_deadlock_check_deferred() */
 	/*------------------------------*/
 	mem_heap_t*	lock_heap;	/* memory heap for the locks of the
 					transaction */
@@ -21,15 +21,20 @@ Created 5/7/1996 Heikki Tuuri
 #include "trx0purge.h"
 #include "dict0mem.h"
 #include "trx0sys.h"
+#include "srv0srv.h"
 
 /* Restricts the length of search we will do in the waits-for
 graph of transactions */
 #define LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK 1000000
 
-/* Restricts the recursion depth of the search we will do in the waits-for
+/* Restricts the depth of the search we will do in the waits-for
 graph of transactions */
 #define LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK 200
 
+/* How many steps of the deadlock search are taken between two looks at
+the clock when the search has a time budget */
+#define LOCK_DEADLOCK_CLOCK_INTERVAL	64
+
 /* When releasing transaction locks, this specifies how often we release
 the kernel mutex for a moment to give also others access to it */
 
@@ -41,6 +46,11 @@ bitmap */
 
 #define LOCK_PAGE_BITMAP_MARGIN		64
 
+/* Maximum number of unused record lock queues that are kept in
+lock_sys->free_queues for reuse */
+
+#define LOCK_REC_QUEUE_FREE_MAX		1024
+
 /* An explicit record lock affects both the record and the gap before it.
 An implicit x-lock does not affect the gap, it only locks the index
 record from read or update.
@@ -357,9 +367,39 @@ Monitor will then fetch it and print */
 UNIV_INTERN ibool	lock_deadlock_found = FALSE;
 UNIV_INTERN FILE*	lock_latest_err_file;
 
-/* Flags for recursive deadlock search */
+/* Counters of the deadlock checks, protected by kernel_mutex */
+UNIV_INTERN ulint	lock_deadlock_n_checks		= 0;
+UNIV_INTERN ulint	lock_deadlock_n_steps		= 0;
+UNIV_INTERN ulint	lock_deadlock_n_found		= 0;
+UNIV_INTERN ulint	lock_deadlock_n_deferred	= 0;
+
+/* Return values of the deadlock search */
 #define LOCK_VICTIM_IS_START	1
 #define LOCK_VICTIM_IS_OTHER	2
+#define LOCK_SEARCH_DEFERRED	3
+
+/* A frame of the deadlock search stack: the search walks backwards the
+queue of the lock a transaction is waiting for, and descends to the
+transaction owning a conflicting lock if that transaction waits too */
+typedef struct lock_deadlock_frame_struct	lock_deadlock_frame_t;
+
+struct lock_deadlock_frame_struct{
+	trx_t*	trx;		/* a transaction waiting for a lock */
+	lock_t*	wait_lock;	/* the lock trx is waiting to be granted */
+	lock_t*	lock;		/* the lock ahead of wait_lock in the
+				queue which was examined last */
+	ulint	heap_no;	/* if wait_lock is a record lock, the
+				heap number of the record it waits for,
+				else ULINT_UNDEFINED */
+};
+
+/* The stack of the deadlock search, protected by kernel_mutex */
+static lock_deadlock_frame_t
+lock_deadlock_stack[LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK + 2];
+
+/* Identifier of the latest deadlock search; a transaction whose
+deadlock_mark equals this has been searched exhaustively in it */
+static ulint	lock_deadlock_mark_counter	= 0;
 
 /************************************************************************
 Checks if a lock request results in a deadlock. */
@@ -373,29 +413,15 @@ lock_deadlock_occurs(
 			transaction(s) as victim(s) */
 	lock_t*	lock,	/* in: lock the transaction is requesting */
 	trx_t*	trx);	/* in: transaction */
-/************************************************************************
-Looks recursively for a deadlock. */
+
+/*************************************************************************
+Checks if a waiting record lock request still has to wait in a queue. */
 static
-ulint
-lock_deadlock_recursive(
-/*====================*/
-				/* out: 0 if no deadlock found,
-				LOCK_VICTIM_IS_START if there was a deadlock
-				and we chose 'start' as the victim,
-				LOCK_VICTIM_IS_OTHER if a deadlock
-				was found and we chose some other trx as a
-				victim: we must do the search again in this
-				last case because there may be another
-				deadlock! */
-	trx_t*	start,		/* in: recursion starting point */
-	trx_t*	trx,		/* in: a transaction waiting for a lock */
-	lock_t*	wait_lock,	/* in: the lock trx is waiting to be granted */
-	ulint*	cost,		/* in/out: number of calculation steps thus
-				far: if this exceeds LOCK_MAX_N_STEPS_...
-				we return LOCK_VICTIM_IS_START */
-	ulint	depth);		/* in: recursion depth: if this exceeds
-				LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK, we
-				return LOCK_VICTIM_IS_START */
+ibool
+lock_rec_has_to_wait_in_queue(
+/*==========================*/
+				/* out: TRUE if still has to wait */
+	lock_t*	wait_lock);	/* in: waiting record lock */
 
 /*************************************************************************
 Gets the nth bit of a record lock. */
@@ -563,6 +589,9 @@ lock_sys_create(
 
 	lock_sys->rec_hash = hash_create(n_cells);
 
+	lock_sys->free_queues = NULL;
+	lock_sys->n_free_queues = 0;
+
 	/* hash_create_mutexes(lock_sys->rec_hash, 2, SYNC_REC_LOCK); */
 
 	lock_latest_err_file = os_file_create_tmpfile();
@@ -760,6 +789,23 @@ lock_reset_lock_and_trx_wait(
 	ut_ad((lock->trx)->wait_lock == lock);
 	ut_ad(lock_get_wait(lock));
 
+	if (lock_get_type_low(lock) == LOCK_REC
+	    && lock->un_member.rec_lock.queue != NULL) {
+		lock_rec_queue_t*	queue = lock->un_member.rec_lock.queue;
+
+		ut_ad(queue->n_waiting > 0);
+
+		queue->n_waiting--;
+
+		UT_LIST_REMOVE(un_member.rec_lock.state_list,
+			       LOCK_REC_QUEUE_CELL(
+				       queue,
+				       lock->un_member.rec_lock.wait_heap_no),
+			       lock);
+		UT_LIST_ADD_LAST(un_member.rec_lock.state_list,
+				 queue->granted, lock);
+	}
+
 	/* Reset the back pointer in trx to this waiting lock request */
 
 	(lock->trx)->wait_lock = NULL;
@@ -1067,16 +1113,74 @@ lock_rec_reset_nth_bit(
 }
 
 /*************************************************************************
-Gets the first or next record lock on a page. */
+Gets the record lock queue of a page. */
 UNIV_INLINE
-lock_t*
-lock_rec_get_next_on_page(
-/*======================*/
-			/* out: next lock, NULL if none exists */
-	lock_t*	lock)	/* in: a record lock */
+lock_rec_queue_t*
+lock_rec_queue_get(
+/*===============*/
+			/* out: queue, NULL if there are no record
+			locks on the page */
+	ulint	space,	/* in: space */
+	ulint	page_no,/* in: page number */
+	ulint	hash)	/* in: lock_rec_hash(space, page_no) */
 {
-	ulint	space;
-	ulint	page_no;
+	lock_rec_queue_t*	queue;
+
+	ut_ad(mutex_own(&kernel_mutex));
+
+	queue = HASH_GET_FIRST(lock_sys->rec_hash, hash);
+
+	while (queue) {
+		if (queue->space == space && queue->page_no == page_no) {
+
+			break;
+		}
+
+		queue = HASH_GET_NEXT(hash, queue);
+	}
+
+	return(queue);
+}
+
+/*************************************************************************
+Numbers the locks of a queue from the given lock to the last one again,
+after the lock has been moved or when the numbers have run out. */
+static
+void
+lock_rec_queue_renumber(
+/*====================*/
+	lock_rec_queue_t*	queue,	/* in/out: record lock queue */
+	lock_t*			lock)	/* in: first lock to number */
+{
+	lock_t*	prev;
+	ulint	seq;
+
+	prev = UT_LIST_GET_PREV(un_member.rec_lock.locks, lock);
+
+	seq = prev ? prev->un_member.rec_lock.seq + 1 : 0;
+
+	for (; lock != NULL;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.locks, lock)) {
+
+		lock->un_member.rec_lock.seq = seq++;
+	}
+
+	queue->next_seq = seq;
+}
+
+/*************************************************************************
+Appends a record lock to the queue of its page. The queue is created if
+there are no other record locks on the page. */
+static
+void
+lock_rec_queue_add(
+/*===============*/
+	lock_t*	lock)	/* in: record lock which is not in any queue */
+{
+	lock_rec_queue_t*	queue;
+	ulint			space;
+	ulint			page_no;
+	ulint			i;
 
 	ut_ad(mutex_own(&kernel_mutex));
 	ut_ad(lock_get_type_low(lock) == LOCK_REC);
@@ -1084,22 +1188,124 @@ lock_rec_get_next_on_page(
 	space = lock->un_member.rec_lock.space;
 	page_no = lock->un_member.rec_lock.page_no;
 
-	for (;;) {
-		lock = HASH_GET_NEXT(hash, lock);
-
-		if (!lock) {
+	queue = lock_rec_queue_get(space, page_no,
+				   lock_rec_hash(space, page_no));
 
-			break;
+	if (queue == NULL) {
+		if (lock_sys->free_queues != NULL) {
+			queue = lock_sys->free_queues;
+			lock_sys->free_queues = queue->hash;
+			lock_sys->n_free_queues--;
+		} else {
+			queue = mem_alloc(sizeof(lock_rec_queue_t));
 		}
 
-		if ((lock->un_member.rec_lock.space == space)
-		    && (lock->un_member.rec_lock.page_no == page_no)) {
+		queue->space = space;
+		queue->page_no = page_no;
+		queue->n_waiting = 0;
+		queue->next_seq = 0;
+		UT_LIST_INIT(queue->locks);
+		UT_LIST_INIT(queue->granted);
 
-			break;
+		for (i = 0; i < LOCK_REC_QUEUE_N_CELLS; i++) {
+			UT_LIST_INIT(queue->waiting[i]);
 		}
+
+		HASH_INSERT(lock_rec_queue_t, hash, lock_sys->rec_hash,
+			    lock_rec_fold(space, page_no), queue);
+	} else if (UNIV_UNLIKELY(queue->next_seq == ULINT_MAX)) {
+
+		lock_rec_queue_renumber(queue, UT_LIST_GET_FIRST(queue->locks));
 	}
 
-	return(lock);
+	lock->un_member.rec_lock.queue = queue;
+	lock->un_member.rec_lock.seq = queue->next_seq++;
+
+	UT_LIST_ADD_LAST(un_member.rec_lock.locks, queue->locks, lock);
+
+	if (lock_get_wait(lock)) {
+		/* A waiting request is always created for one record */
+		ulint	heap_no = lock_rec_find_set_bit(lock);
+
+		lock->un_member.rec_lock.wait_heap_no = heap_no;
+
+		UT_LIST_ADD_LAST(un_member.rec_lock.state_list,
+				 LOCK_REC_QUEUE_CELL(queue, heap_no), lock);
+		queue->n_waiting++;
+	} else {
+		UT_LIST_ADD_LAST(un_member.rec_lock.state_list,
+				 queue->granted, lock);
+	}
+}
+
+/*************************************************************************
+Removes a record lock from the queue of its page. The queue is freed when
+its last lock is removed. */
+static
+void
+lock_rec_queue_remove(
+/*==================*/
+	lock_t*	lock)	/* in: record lock */
+{
+	lock_rec_queue_t*	queue;
+
+	ut_ad(mutex_own(&kernel_mutex));
+	ut_ad(lock_get_type_low(lock) == LOCK_REC);
+
+	queue = lock->un_member.rec_lock.queue;
+	ut_ad(queue);
+
+	UT_LIST_REMOVE(un_member.rec_lock.locks, queue->locks, lock);
+
+	if (lock_get_wait(lock)) {
+		ut_ad(queue->n_waiting > 0);
+
+		queue->n_waiting--;
+
+		UT_LIST_REMOVE(un_member.rec_lock.state_list,
+			       LOCK_REC_QUEUE_CELL(
+				       queue,
+				       lock->un_member.rec_lock.wait_heap_no),
+			       lock);
+	} else {
+		UT_LIST_REMOVE(un_member.rec_lock.state_list,
+			       queue->granted, lock);
+	}
+
+	lock->un_member.rec_lock.queue = NULL;
+
+	if (UT_LIST_GET_LEN(queue->locks) > 0) {
+
+		return;
+	}
+
+	ut_ad(queue->n_waiting == 0);
+
+	HASH_DELETE(lock_rec_queue_t, hash, lock_sys->rec_hash,
+		    lock_rec_fold(queue->space, queue->page_no), queue);
+
+	if (lock_sys->n_free_queues < LOCK_REC_QUEUE_FREE_MAX) {
+		queue->hash = lock_sys->free_queues;
+		lock_sys->free_queues = queue;
+		lock_sys->n_free_queues++;
+	} else {
+		mem_free(queue);
+	}
+}
+
+/*************************************************************************
+Gets the first or next record lock on a page. */
+UNIV_INLINE
+lock_t*
+lock_rec_get_next_on_page(
+/*======================*/
+			/* out: next lock, NULL if none exists */
+	lock_t*	lock)	/* in: a record lock */
+{
+	ut_ad(mutex_own(&kernel_mutex));
+	ut_ad(lock_get_type_low(lock) == LOCK_REC);
+
+	return(UT_LIST_GET_NEXT(un_member.rec_lock.locks, lock));
 }
 
 /*************************************************************************
@@ -1113,23 +1319,14 @@ lock_rec_get_first_on_page_addr(
 	ulint	space,	/* in: space */
 	ulint	page_no)/* in: page number */
 {
-	lock_t*	lock;
+	lock_rec_queue_t*	queue;
 
 	ut_ad(mutex_own(&kernel_mutex));
 
-	lock = HASH_GET_FIRST(lock_sys->rec_hash,
-			      lock_rec_hash(space, page_no));
-	while (lock) {
-		if ((lock->un_member.rec_lock.space == space)
-		    && (lock->un_member.rec_lock.page_no == page_no)) {
+	queue = lock_rec_queue_get(space, page_no,
+				   lock_rec_hash(space, page_no));
 
-			break;
-		}
-
-		lock = HASH_GET_NEXT(hash, lock);
-	}
-
-	return(lock);
+	return(queue ? UT_LIST_GET_FIRST(queue->locks) : NULL);
 }
 
 /*************************************************************************
@@ -1169,28 +1366,15 @@ lock_rec_get_first_on_page(
 					none exists */
 	const buf_block_t*	block)	/* in: buffer block */
 {
-	ulint	hash;
-	lock_t*	lock;
-	ulint	space	= buf_block_get_space(block);
-	ulint	page_no	= buf_block_get_page_no(block);
+	lock_rec_queue_t*	queue;
 
 	ut_ad(mutex_own(&kernel_mutex));
 
-	hash = buf_block_get_lock_hash_val(block);
+	queue = lock_rec_queue_get(buf_block_get_space(block),
+				   buf_block_get_page_no(block),
+				   buf_block_get_lock_hash_val(block));
 
-	lock = HASH_GET_FIRST(lock_sys->rec_hash, hash);
-
-	while (lock) {
-		if ((lock->un_member.rec_lock.space == space)
-		    && (lock->un_member.rec_lock.page_no == page_no)) {
-
-			break;
-		}
-
-		lock = HASH_GET_NEXT(hash, lock);
-	}
-
-	return(lock);
+	return(queue ? UT_LIST_GET_FIRST(queue->locks) : NULL);
 }
 
 /*************************************************************************
@@ -1481,33 +1665,48 @@ lock_rec_other_has_conflicting(
 	ulint			heap_no,/* in: heap number of the record */
 	trx_t*			trx)	/* in: our transaction */
 {
-	lock_t*	lock;
+	lock_rec_queue_t*	queue;
+	lock_t*			lock;
+	const ibool		on_supremum
+		= heap_no == PAGE_HEAP_NO_SUPREMUM;
 
 	ut_ad(mutex_own(&kernel_mutex));
 
-	lock = lock_rec_get_first(block, heap_no);
+	queue = lock_rec_queue_get(buf_block_get_space(block),
+				   buf_block_get_page_no(block),
+				   buf_block_get_lock_hash_val(block));
 
-	if (UNIV_LIKELY_NULL(lock)) {
-		if (UNIV_UNLIKELY(heap_no == PAGE_HEAP_NO_SUPREMUM)) {
+	if (queue == NULL) {
 
-			do {
-				if (lock_rec_has_to_wait(trx, mode, lock,
-							 TRUE)) {
-					return(lock);
-				}
+		return(NULL);
+	}
 
-				lock = lock_rec_get_next(heap_no, lock);
-			} while (lock);
-		} else {
+	/* The order of the locks does not matter here: look at the
+	granted locks and then at the requests waiting for the record */
 
-			do {
-				if (lock_rec_has_to_wait(trx, mode, lock,
-							 FALSE)) {
-					return(lock);
-				}
+	for (lock = UT_LIST_GET_FIRST(queue->granted); lock != NULL;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, lock)) {
 
-				lock = lock_rec_get_next(heap_no, lock);
-			} while (lock);
+		if (lock_rec_get_nth_bit(lock, heap_no)
+		    && lock_rec_has_to_wait(trx, mode, lock, on_supremum)) {
+
+			return(lock);
+		}
+	}
+
+	if (queue->n_waiting == 0) {
+
+		return(NULL);
+	}
+
+	for (lock = UT_LIST_GET_FIRST(LOCK_REC_QUEUE_CELL(queue, heap_no));
+	     lock != NULL;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, lock)) {
+
+		if (lock_rec_get_nth_bit(lock, heap_no)
+		    && lock_rec_has_to_wait(trx, mode, lock, on_supremum)) {
+
+			return(lock);
 		}
 	}
 
@@ -1695,8 +1894,8 @@ lock_rec_create(
 	/* Set the bit corresponding to rec */
 	lock_rec_set_nth_bit(lock, heap_no);
 
-	HASH_INSERT(lock_t, hash, lock_sys->rec_hash,
-		    lock_rec_fold(space, page_no), lock);
+	lock_rec_queue_add(lock);
+
 	if (UNIV_UNLIKELY(type_mode & LOCK_WAIT)) {
 
 		lock_set_lock_and_trx_wait(lock, trx);
@@ -1705,6 +1904,176 @@ lock_rec_create(
 	return(lock);
 }
 
+/*****************************************************************
+Checks if a waiting lock request should be granted before another one
+under the lock scheduling policy srv_lock_schedule. */
+UNIV_INLINE
+ibool
+lock_has_priority(
+/*==============*/
+				/* out: TRUE if lock1 goes before lock2 */
+	const lock_t*	lock1,	/* in: waiting lock request */
+	const lock_t*	lock2)	/* in: waiting lock request */
+{
+	switch (srv_lock_schedule) {
+	case LOCK_SCHEDULE_AGE:
+		return(ut_dulint_cmp(lock1->trx->id, lock2->trx->id) < 0);
+	case LOCK_SCHEDULE_WEIGHT:
+		return(trx_weight_cmp(lock1->trx, lock2->trx) > 0);
+	}
+
+	return(FALSE);
+}
+
+/* Maximum number of granted locks on a record for which
+lock_rec_queue_prioritize() moves a waiting request; with more, the
+request keeps its place in the queue */
+#define LOCK_SCHEDULE_MAX_GRANTED	16
+
+/*************************************************************************
+Moves a waiting record lock request, which lock_rec_create() appended to
+the queue of its page, ahead of the waiting requests of lower priority
+under srv_lock_schedule. The waiting requests for a record are thus kept
+in the order in which they are to be granted, and the queue is never
+reordered afterwards. The request is not moved past a granted lock on the
+record, nor past a waiting request for the record by a transaction
+holding a granted lock on it: that transaction would then wait for the
+moved request, which waits for its granted lock. The caller must check
+the moved request for deadlocks, as the requests it passed now wait for
+it. */
+static
+void
+lock_rec_queue_prioritize(
+/*======================*/
+	lock_t*	lock,	/* in: waiting record lock request, the last
+			in its queue */
+	ulint	heap_no)/* in: heap number of the record */
+{
+	lock_rec_queue_t*	queue;
+	const trx_t*		granted[LOCK_SCHEDULE_MAX_GRANTED];
+	ulint			n_granted	= 0;
+	ibool			too_many	= FALSE;
+	ulint			limit		= 0;
+	lock_t*			pos;
+	lock_t*			prev;
+	ulint			i;
+
+	ut_ad(mutex_own(&kernel_mutex));
+	ut_ad(lock_get_wait(lock));
+
+	queue = lock->un_member.rec_lock.queue;
+
+	ut_ad(UT_LIST_GET_LAST(queue->locks) == lock);
+	ut_ad(UT_LIST_GET_LAST(LOCK_REC_QUEUE_CELL(queue, heap_no)) == lock);
+
+	/* Collect the holders of the granted locks on the record, and
+	the position in the queue of the last of those locks */
+
+	for (prev = UT_LIST_GET_FIRST(queue->granted); prev != NULL;
+	     prev = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, prev)) {
+
+		if (!lock_rec_get_nth_bit(prev, heap_no)) {
+
+			continue;
+		}
+
+		if (prev->un_member.rec_lock.seq >= limit) {
+			limit = prev->un_member.rec_lock.seq + 1;
+		}
+
+		if (n_granted == LOCK_SCHEDULE_MAX_GRANTED) {
+			too_many = TRUE;
+		} else {
+			granted[n_granted++] = prev->trx;
+		}
+	}
+
+	/* Walk back over the waiting requests of lower priority for
+	the record that are behind its granted locks; the locks on
+	other records do not matter */
+
+	pos = lock;
+
+	for (prev = UT_LIST_GET_PREV(un_member.rec_lock.state_list, lock);
+	     prev != NULL;
+	     prev = UT_LIST_GET_PREV(un_member.rec_lock.state_list, prev)) {
+
+		if (!lock_rec_get_nth_bit(prev, heap_no)) {
+
+			continue;
+		}
+
+		if (prev->un_member.rec_lock.seq < limit
+		    || !lock_has_priority(lock, prev)) {
+
+			break;
+		}
+
+		pos = prev;
+	}
+
+	if (pos == lock || too_many) {
+
+		return;
+	}
+
+	/* Do not pass the requests for the record by the holders of
+	the granted locks */
+
+	for (prev = pos; prev != lock;
+	     prev = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, prev)) {
+
+		if (!lock_rec_get_nth_bit(prev, heap_no)) {
+
+			continue;
+		}
+
+		for (i = 0; i < n_granted; i++) {
+			if (granted[i] == prev->trx) {
+				pos = UT_LIST_GET_NEXT(
+					un_member.rec_lock.state_list, prev);
+
+				break;
+			}
+		}
+	}
+
+	if (pos == lock) {
+
+		return;
+	}
+
+	/* Move the request ahead of pos in the queue and in its cell */
+
+	prev = UT_LIST_GET_PREV(un_member.rec_lock.locks, pos);
+
+	UT_LIST_REMOVE(un_member.rec_lock.locks, queue->locks, lock);
+
+	if (prev == NULL) {
+		UT_LIST_ADD_FIRST(un_member.rec_lock.locks,
+				  queue->locks, lock);
+	} else {
+		UT_LIST_INSERT_AFTER(un_member.rec_lock.locks,
+				     queue->locks, prev, lock);
+	}
+
+	prev = UT_LIST_GET_PREV(un_member.rec_lock.state_list, pos);
+
+	UT_LIST_REMOVE(un_member.rec_lock.state_list,
+		       LOCK_REC_QUEUE_CELL(queue, heap_no), lock);
+
+	if (prev == NULL) {
+		UT_LIST_ADD_FIRST(un_member.rec_lock.state_list,
+				  LOCK_REC_QUEUE_CELL(queue, heap_no), lock);
+	} else {
+		UT_LIST_INSERT_AFTER(un_member.rec_lock.state_list,
+				     LOCK_REC_QUEUE_CELL(queue, heap_no),
+				     prev, lock);
+	}
+
+	lock_rec_queue_renumber(queue, lock);
+}
+
 /*************************************************************************
 Enqueues a waiting request for a lock which cannot be granted immediately.
 Checks for deadlocks. */
@@ -1774,6 +2143,19 @@ lock_rec_enqueue_waiting(
 	lock = lock_rec_create(type_mode | LOCK_WAIT,
 			       block, heap_no, index, trx);
 
+	if (srv_lock_schedule != LOCK_SCHEDULE_FIFO) {
+		lock_rec_queue_prioritize(lock, heap_no);
+
+		if (!lock_rec_has_to_wait_in_queue(lock)) {
+			/* The request only conflicted with waiting
+			requests of lower priority, which it passed */
+
+			lock_reset_lock_and_trx_wait(lock);
+
+			return(DB_SUCCESS);
+		}
+	}
+
 	/* Check if a deadlock occurs: if yes, remove the lock request and
 	return an error code */
 
@@ -1832,6 +2214,7 @@ lock_rec_add_to_queue(
 	trx_t*			trx)	/* in: transaction */
 {
 	lock_t*	lock;
+	lock_t*	first_lock;
 
 	ut_ad(mutex_own(&kernel_mutex));
 #ifdef UNIV_DEBUG
@@ -1870,18 +2253,27 @@ lock_rec_add_to_queue(
 		type_mode = type_mode & ~(LOCK_GAP | LOCK_REC_NOT_GAP);
 	}
 
-	/* Look for a waiting lock request on the same record or on a gap */
+	/* Look for a waiting lock request on the same record or on a gap;
+	the queue of the page knows if there are any waiting requests */
 
-	lock = lock_rec_get_first_on_page(block);
+	first_lock = lock_rec_get_first_on_page(block);
 
-	while (lock != NULL) {
-		if (lock_get_wait(lock)
-		    && (lock_rec_get_nth_bit(lock, heap_no))) {
+	if (first_lock != NULL
+	    && first_lock->un_member.rec_lock.queue->n_waiting > 0) {
+		lock_rec_queue_t*	queue
+			= first_lock->un_member.rec_lock.queue;
 
-			goto somebody_waits;
-		}
+		for (lock = UT_LIST_GET_FIRST(
+			     LOCK_REC_QUEUE_CELL(queue, heap_no));
+		     lock != NULL;
+		     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list,
+					     lock)) {
 
-		lock = lock_rec_get_next_on_page(lock);
+			if (lock_rec_get_nth_bit(lock, heap_no)) {
+
+				goto somebody_waits;
+			}
+		}
 	}
 
 	if (UNIV_LIKELY(!(type_mode & LOCK_WAIT))) {
@@ -1891,8 +2283,7 @@ lock_rec_add_to_queue(
 		we can just set the bit */
 
 		lock = lock_rec_find_similar_on_page(
-			type_mode, heap_no,
-			lock_rec_get_first_on_page(block), trx);
+			type_mode, heap_no, first_lock, trx);
 
 		if (lock) {
 
@@ -2130,30 +2521,45 @@ lock_rec_has_to_wait_in_queue(
 				/* out: TRUE if still has to wait */
 	lock_t*	wait_lock)	/* in: waiting record lock */
 {
-	lock_t*	lock;
-	ulint	space;
-	ulint	page_no;
-	ulint	heap_no;
+	lock_rec_queue_t*	queue;
+	lock_t*			lock;
+	ulint			heap_no;
+	ulint			seq;
 
 	ut_ad(mutex_own(&kernel_mutex));
 	ut_ad(lock_get_wait(wait_lock));
 	ut_ad(lock_get_type_low(wait_lock) == LOCK_REC);
 
-	space = wait_lock->un_member.rec_lock.space;
-	page_no = wait_lock->un_member.rec_lock.page_no;
-	heap_no = lock_rec_find_set_bit(wait_lock);
+	queue = wait_lock->un_member.rec_lock.queue;
+	heap_no = wait_lock->un_member.rec_lock.wait_heap_no;
+	seq = wait_lock->un_member.rec_lock.seq;
 
-	lock = lock_rec_get_first_on_page_addr(space, page_no);
+	ut_ad(heap_no == lock_rec_find_set_bit(wait_lock));
+
+	/* Only the locks on the record ahead of wait_lock in the queue
+	count: the granted ones, and the waiting requests ahead of it in
+	its cell */
+
+	for (lock = UT_LIST_GET_FIRST(queue->granted); lock != NULL;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, lock)) {
+
+		if (lock->un_member.rec_lock.seq < seq
+		    && lock_rec_get_nth_bit(lock, heap_no)
+		    && lock_has_to_wait(wait_lock, lock)) {
+
+			return(TRUE);
+		}
+	}
 
-	while (lock != wait_lock) {
+	for (lock = UT_LIST_GET_FIRST(LOCK_REC_QUEUE_CELL(queue, heap_no));
+	     lock != wait_lock;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, lock)) {
 
 		if (lock_rec_get_nth_bit(lock, heap_no)
 		    && lock_has_to_wait(wait_lock, lock)) {
 
 			return(TRUE);
 		}
-
-		lock = lock_rec_get_next_on_page(lock);
 	}
 
 	return(FALSE);
@@ -2241,38 +2647,68 @@ lock_rec_dequeue_from_page(
 			transactions waiting behind will get their lock
 			requests granted, if they are now qualified to it */
 {
-	ulint	space;
-	ulint	page_no;
-	lock_t*	lock;
-	trx_t*	trx;
+	lock_rec_queue_t*	queue;
+	lock_t*			lock;
+	lock_t*			next_lock;
+	trx_t*			trx;
+	ulint			heap_no;
 
 	ut_ad(mutex_own(&kernel_mutex));
 	ut_ad(lock_get_type_low(in_lock) == LOCK_REC);
 
 	trx = in_lock->trx;
+	queue = in_lock->un_member.rec_lock.queue;
 
-	space = in_lock->un_member.rec_lock.space;
-	page_no = in_lock->un_member.rec_lock.page_no;
+	if (UT_LIST_GET_LEN(queue->locks) == 1) {
+		/* in_lock is the last lock on the page: the queue will
+		be freed and nobody can be waiting */
+
+		queue = NULL;
+	}
 
-	HASH_DELETE(lock_t, hash, lock_sys->rec_hash,
-		    lock_rec_fold(space, page_no), in_lock);
+	lock_rec_queue_remove(in_lock);
 
 	UT_LIST_REMOVE(trx_locks, trx->trx_locks, in_lock);
 
+	if (queue == NULL || queue->n_waiting == 0) {
+
+		return;
+	}
+
 	/* Check if waiting locks in the queue can now be granted: grant
-	locks if there are no conflicting locks ahead. */
+	locks if there are no conflicting locks ahead. Only the requests
+	waiting for a record on which in_lock had a bit set can have
+	become grantable. Under a non-FIFO srv_lock_schedule, the waiting
+	requests are already in priority order, see
+	lock_rec_queue_prioritize(). */
 
-	lock = lock_rec_get_first_on_page_addr(space, page_no);
+	for (heap_no = 0; heap_no < lock_rec_get_n_bits(in_lock); heap_no++) {
 
-	while (lock != NULL) {
-		if (lock_get_wait(lock)
-		    && !lock_rec_has_to_wait_in_queue(lock)) {
+		if (!lock_rec_get_nth_bit(in_lock, heap_no)) {
 
-			/* Grant the lock */
-			lock_grant(lock);
+			continue;
 		}
 
-		lock = lock_rec_get_next_on_page(lock);
+		for (lock = UT_LIST_GET_FIRST(
+			     LOCK_REC_QUEUE_CELL(queue, heap_no));
+		     lock != NULL; lock = next_lock) {
+
+			/* lock_grant() moves the lock to queue->granted */
+			next_lock = UT_LIST_GET_NEXT(
+				un_member.rec_lock.state_list, lock);
+
+			if (lock_rec_get_nth_bit(lock, heap_no)
+			    && !lock_rec_has_to_wait_in_queue(lock)) {
+
+				/* Grant the lock */
+				lock_grant(lock);
+			}
+		}
+
+		if (queue->n_waiting == 0) {
+
+			break;
+		}
 	}
 }
 
@@ -2285,8 +2721,6 @@ lock_rec_discard(
 	lock_t*	in_lock)/* in: record lock object: all record locks which
 			are contained in this lock object are removed */
 {
-	ulint	space;
-	ulint	page_no;
 	trx_t*	trx;
 
 	ut_ad(mutex_own(&kernel_mutex));
@@ -2294,11 +2728,7 @@ lock_rec_discard(
 
 	trx = in_lock->trx;
 
-	space = in_lock->un_member.rec_lock.space;
-	page_no = in_lock->un_member.rec_lock.page_no;
-
-	HASH_DELETE(lock_t, hash, lock_sys->rec_hash,
-		    lock_rec_fold(space, page_no), in_lock);
+	lock_rec_queue_remove(in_lock);
 
 	UT_LIST_REMOVE(trx_locks, trx->trx_locks, in_lock);
 }
@@ -3251,74 +3681,137 @@ lock_rec_restore_from_page_infimum(
 /*=========== DEADLOCK CHECKING ======================================*/
 
 /************************************************************************
-Checks if a lock request results in a deadlock. */
+Prints a lock to the latest deadlock error buffer. */
 static
-ibool
-lock_deadlock_occurs(
-/*=================*/
-			/* out: TRUE if a deadlock was detected and we
-			chose trx as a victim; FALSE if no deadlock, or
-			there was a deadlock, but we chose other
-			transaction(s) as victim(s) */
-	lock_t*	lock,	/* in: lock the transaction is requesting */
-	trx_t*	trx)	/* in: transaction */
+void
+lock_deadlock_print_lock(
+/*=====================*/
+	FILE*		ef,	/* in: lock_latest_err_file */
+	const lock_t*	lock)	/* in: record or table lock */
 {
-	dict_table_t*	table;
-	dict_index_t*	index;
-	trx_t*		mark_trx;
-	ulint		ret;
-	ulint		cost	= 0;
+	if (lock_get_type_low(lock) == LOCK_REC) {
+		lock_rec_print(ef, lock);
+	} else {
+		lock_table_print(ef, lock);
+	}
+}
+
+/************************************************************************
+Reports a deadlock or a too long search found by lock_deadlock_search()
+and chooses a victim. */
+static
+ulint
+lock_deadlock_resolve(
+/*==================*/
+				/* out: LOCK_VICTIM_IS_START or
+				LOCK_VICTIM_IS_OTHER */
+	trx_t*	start,		/* in: search starting point */
+	lock_t*	wait_lock,	/* in: lock a transaction is waiting for */
+	lock_t*	lock,		/* in: lock ahead of wait_lock which
+				wait_lock has to wait for */
+	ibool	too_far)	/* in: TRUE if the search was aborted
+				because it took too long */
+{
+	FILE*	ef = lock_latest_err_file;
 
-	ut_ad(trx);
-	ut_ad(lock);
 	ut_ad(mutex_own(&kernel_mutex));
-retry:
-	/* We check that adding this trx to the waits-for graph
-	does not produce a cycle. First mark all active transactions
-	with 0: */
 
-	mark_trx = UT_LIST_GET_FIRST(trx_sys->trx_list);
+	rewind(ef);
+	ut_print_timestamp(ef);
 
-	while (mark_trx) {
-		mark_trx->deadlock_mark = 0;
-		mark_trx = UT_LIST_GET_NEXT(trx_list, mark_trx);
-	}
+	fputs("\n*** (1) TRANSACTION:\n", ef);
 
-	ret = lock_deadlock_recursive(trx, trx, lock, &cost, 0);
+	trx_print(ef, wait_lock->trx, 3000);
 
-	if (ret == LOCK_VICTIM_IS_OTHER) {
-		/* We chose some other trx as a victim: retry if there still
-		is a deadlock */
+	fputs("*** (1) WAITING FOR THIS LOCK TO BE GRANTED:\n", ef);
 
-		goto retry;
+	lock_deadlock_print_lock(ef, wait_lock);
+
+	fputs("*** (2) TRANSACTION:\n", ef);
+
+	trx_print(ef, lock->trx, 3000);
+
+	fputs("*** (2) HOLDS THE LOCK(S):\n", ef);
+
+	lock_deadlock_print_lock(ef, lock);
+
+	fputs("*** (2) WAITING FOR THIS LOCK TO BE GRANTED:\n", ef);
+
+	lock_deadlock_print_lock(ef, start->wait_lock);
+#ifdef UNIV_DEBUG
+	if (lock_print_waits) {
+		fputs("Deadlock detected or too long search\n", stderr);
 	}
+#endif /* UNIV_DEBUG */
+	if (too_far) {
 
-	if (UNIV_UNLIKELY(ret == LOCK_VICTIM_IS_START)) {
-		if (lock_get_type_low(lock) & LOCK_TABLE) {
-			table = lock->un_member.tab_lock.table;
-			index = NULL;
-		} else {
-			index = lock->index;
-			table = index->table;
-		}
+		fputs("TOO DEEP OR LONG SEARCH IN THE LOCK TABLE"
+		      " WAITS-FOR GRAPH\n", ef);
 
-		lock_deadlock_found = TRUE;
+		return(LOCK_VICTIM_IS_START);
+	}
 
-		fputs("*** WE ROLL BACK TRANSACTION (2)\n",
-		      lock_latest_err_file);
+	lock_deadlock_n_found++;
 
-		return(TRUE);
+	if (trx_weight_cmp(wait_lock->trx, start) >= 0) {
+		/* Our search starting point transaction is 'smaller',
+		let us choose 'start' as the victim and roll back it */
+
+		return(LOCK_VICTIM_IS_START);
 	}
 
-	return(FALSE);
+	lock_deadlock_found = TRUE;
+
+	/* Let us choose the transaction of wait_lock as a victim to try
+	to avoid deadlocking our search starting point transaction */
+
+	fputs("*** WE ROLL BACK TRANSACTION (1)\n", ef);
+
+	wait_lock->trx->was_chosen_as_deadlock_victim = TRUE;
+
+	lock_cancel_waiting_and_release(wait_lock);
+
+	/* Since trx and wait_lock are no longer in the waits-for graph,
+	the search can be restarted; note that our selective algorithm
+	can choose several transactions as victims, but still we may end
+	up rolling back also the search starting point transaction! */
+
+	return(LOCK_VICTIM_IS_OTHER);
+}
+
+/************************************************************************
+Pushes a transaction waiting for a lock to the deadlock search stack. */
+UNIV_INLINE
+void
+lock_deadlock_frame_init(
+/*=====================*/
+	lock_deadlock_frame_t*	frame,		/* out: stack frame */
+	trx_t*			trx,		/* in: waiting transaction */
+	lock_t*			wait_lock)	/* in: the lock trx is
+						waiting to be granted */
+{
+	frame->trx = trx;
+	frame->wait_lock = wait_lock;
+	frame->lock = wait_lock;
+	frame->heap_no = ULINT_UNDEFINED;
+
+	if (lock_get_type_low(wait_lock) == LOCK_REC) {
+
+		frame->heap_no = lock_rec_find_set_bit(wait_lock);
+
+		ut_a(frame->heap_no != ULINT_UNDEFINED);
+	}
 }
 
 /************************************************************************
-Looks recursively for a deadlock. */
+Looks for a deadlock by a depth-first search in the waits-for graph of
+transactions, starting from a lock request of a transaction. The search
+keeps its path in lock_deadlock_stack instead of recursing, and marks the
+transactions whose subtree it has searched exhaustively. */
 static
 ulint
-lock_deadlock_recursive(
-/*====================*/
+lock_deadlock_search(
+/*=================*/
 				/* out: 0 if no deadlock found,
 				LOCK_VICTIM_IS_START if there was a deadlock
 				and we chose 'start' as the victim,
@@ -3326,185 +3819,255 @@ lock_deadlock_recursive(
 				was found and we chose some other trx as a
 				victim: we must do the search again in this
 				last case because there may be another
-				deadlock! */
-	trx_t*	start,		/* in: recursion starting point */
-	trx_t*	trx,		/* in: a transaction waiting for a lock */
-	lock_t*	wait_lock,	/* in: the lock trx is waiting to be granted */
-	ulint*	cost,		/* in/out: number of calculation steps thus
-				far: if this exceeds LOCK_MAX_N_STEPS_...
-				we return LOCK_VICTIM_IS_START */
-	ulint	depth)		/* in: recursion depth: if this exceeds
-				LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK, we
-				return LOCK_VICTIM_IS_START */
+				deadlock!, LOCK_SEARCH_DEFERRED if the search
+				took too long and defer was TRUE */
+	trx_t*	start,		/* in: search starting point */
+	lock_t*	wait_lock,	/* in: the lock start is waiting for */
+	ulint	max_usec,	/* in: time budget of the search in
+				microseconds, or 0 if unlimited */
+	ibool	defer)		/* in: TRUE if a too long search should
+				be left to lock_deadlock_check_deferred()
+				instead of choosing 'start' as the victim */
 {
-	lock_t*	lock;
-	ulint	bit_no		= ULINT_UNDEFINED;
-	trx_t*	lock_trx;
-	ulint	ret;
+	lock_deadlock_frame_t*	frame;
+	lock_t*			lock;
+	trx_t*			lock_trx;
+	ulint			depth	= 0;
+	ulint			cost	= 1;
+	ullint			deadline = 0;
+	ibool			timed_out = FALSE;
 
-	ut_a(trx);
+	ut_ad(mutex_own(&kernel_mutex));
 	ut_a(start);
 	ut_a(wait_lock);
-	ut_ad(mutex_own(&kernel_mutex));
 
-	if (trx->deadlock_mark == 1) {
-		/* We have already exhaustively searched the subtree starting
-		from this trx */
+	if (UNIV_UNLIKELY(++lock_deadlock_mark_counter == 0)) {
+		/* The search identifier wrapped around: forget the
+		marks of the earlier searches */
+
+		trx_t*	mark_trx = UT_LIST_GET_FIRST(trx_sys->trx_list);
+
+		while (mark_trx) {
+			mark_trx->deadlock_mark = 0;
+			mark_trx = UT_LIST_GET_NEXT(trx_list, mark_trx);
+		}
 
-		return(0);
+		lock_deadlock_mark_counter = 1;
 	}
 
-	*cost = *cost + 1;
+	if (max_usec) {
+		deadline = ut_time_us(NULL) + max_usec;
+	}
 
-	lock = wait_lock;
+	lock_deadlock_n_checks++;
 
-	if (lock_get_type_low(wait_lock) == LOCK_REC) {
+	frame = lock_deadlock_stack;
+	lock_deadlock_frame_init(frame, start, wait_lock);
 
-		bit_no = lock_rec_find_set_bit(wait_lock);
+	for (;;) {
+		ibool	too_far;
 
-		ut_a(bit_no != ULINT_UNDEFINED);
-	}
+		/* Look at the next lock ahead of wait_lock in the queue */
 
-	/* Look at the locks ahead of wait_lock in the lock queue */
+		lock = frame->lock;
 
-	for (;;) {
 		if (lock_get_type_low(lock) & LOCK_TABLE) {
 
 			lock = UT_LIST_GET_PREV(un_member.tab_lock.locks,
 						lock);
 		} else {
 			ut_ad(lock_get_type_low(lock) == LOCK_REC);
-			ut_a(bit_no != ULINT_UNDEFINED);
 
-			lock = (lock_t*) lock_rec_get_prev(lock, bit_no);
+			lock = (lock_t*) lock_rec_get_prev(lock,
+							   frame->heap_no);
 		}
 
+		frame->lock = lock;
+
 		if (lock == NULL) {
-			/* We can mark this subtree as searched */
-			trx->deadlock_mark = 1;
+			/* We can mark this subtree as searched and
+			return to the transaction which waits for it */
 
-			return(FALSE);
+			frame->trx->deadlock_mark = lock_deadlock_mark_counter;
+
+			if (depth == 0) {
+				lock_deadlock_n_steps += cost;
+
+				return(0);
+			}
+
+			depth--;
+			frame--;
+
+			continue;
 		}
 
-		if (lock_has_to_wait(wait_lock, lock)) {
+		if (!lock_has_to_wait(frame->wait_lock, lock)) {
 
-			ibool	too_far
-				= depth > LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK
-				|| *cost > LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK;
+			continue;
+		}
 
-			lock_trx = lock->trx;
+		too_far = timed_out
+			|| depth > LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK
+			|| cost > LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK;
 
-			if (lock_trx == start || too_far) {
+		lock_trx = lock->trx;
 
-				/* We came back to the recursion starting
-				point: a deadlock detected; or we have
-				searched the waits-for graph too long */
+		if (too_far && defer) {
+			lock_deadlock_n_steps += cost;
+			lock_deadlock_n_deferred++;
 
-				FILE*	ef = lock_latest_err_file;
+			return(LOCK_SEARCH_DEFERRED);
+		}
 
-				rewind(ef);
-				ut_print_timestamp(ef);
+		if (lock_trx == start || too_far) {
 
-				fputs("\n*** (1) TRANSACTION:\n", ef);
+			/* We came back to the search starting point: a
+			deadlock detected; or we have searched the
+			waits-for graph too long */
 
-				trx_print(ef, wait_lock->trx, 3000);
+			lock_deadlock_n_steps += cost;
 
-				fputs("*** (1) WAITING FOR THIS LOCK"
-				      " TO BE GRANTED:\n", ef);
+			return(lock_deadlock_resolve(start, frame->wait_lock,
+						     lock, too_far));
+		}
 
-				if (lock_get_type_low(wait_lock) == LOCK_REC) {
-					lock_rec_print(ef, wait_lock);
-				} else {
-					lock_table_print(ef, wait_lock);
-				}
+		if (lock_trx->que_state == TRX_QUE_LOCK_WAIT
+		    && lock_trx->deadlock_mark != lock_deadlock_mark_counter) {
 
-				fputs("*** (2) TRANSACTION:\n", ef);
+			/* Another trx ahead has requested lock in an
+			incompatible mode, and is itself waiting for a lock
+			in a subtree we have not searched yet */
 
-				trx_print(ef, lock->trx, 3000);
+			cost++;
 
-				fputs("*** (2) HOLDS THE LOCK(S):\n", ef);
+			if (deadline
+			    && cost % LOCK_DEADLOCK_CLOCK_INTERVAL == 0
+			    && ut_time_us(NULL) > deadline) {
 
-				if (lock_get_type_low(lock) == LOCK_REC) {
-					lock_rec_print(ef, lock);
-				} else {
-					lock_table_print(ef, lock);
-				}
+				timed_out = TRUE;
+			}
 
-				fputs("*** (2) WAITING FOR THIS LOCK"
-				      " TO BE GRANTED:\n", ef);
+			depth++;
+			frame++;
 
-				if (lock_get_type_low(start->wait_lock)
-				    == LOCK_REC) {
-					lock_rec_print(ef, start->wait_lock);
-				} else {
-					lock_table_print(ef, start->wait_lock);
-				}
-#ifdef UNIV_DEBUG
-				if (lock_print_waits) {
-					fputs("Deadlock detected"
-					      " or too long search\n",
-					      stderr);
-				}
-#endif /* UNIV_DEBUG */
-				if (too_far) {
+			lock_deadlock_frame_init(frame, lock_trx,
+						 lock_trx->wait_lock);
+		}
+	}
+}
 
-					fputs("TOO DEEP OR LONG SEARCH"
-					      " IN THE LOCK TABLE"
-					      " WAITS-FOR GRAPH\n", ef);
+/************************************************************************
+Checks if a lock request results in a deadlock. */
+static
+ibool
+lock_deadlock_check(
+/*================*/
+			/* out: TRUE if a deadlock was detected and we
+			chose trx as a victim; FALSE if no deadlock, or
+			there was a deadlock, but we chose other
+			transaction(s) as victim(s), or the check was
+			deferred */
+	lock_t*	lock,	/* in: lock the transaction is requesting */
+	trx_t*	trx,	/* in: transaction */
+	ulint	max_usec,/* in: time budget of one search in
+			microseconds, or 0 if unlimited */
+	ibool	defer)	/* in: TRUE if a too long search should be
+			left to lock_deadlock_check_deferred() */
+{
+	ulint	ret;
 
-					return(LOCK_VICTIM_IS_START);
-				}
+	ut_ad(trx);
+	ut_ad(lock);
+	ut_ad(mutex_own(&kernel_mutex));
 
-				if (trx_weight_cmp(wait_lock->trx,
-						   start) >= 0) {
-					/* Our recursion starting point
-					transaction is 'smaller', let us
-					choose 'start' as the victim and roll
-					back it */
+	trx->deadlock_check_deferred = FALSE;
+retry:
+	/* We check that adding this trx to the waits-for graph
+	does not produce a cycle */
 
-					return(LOCK_VICTIM_IS_START);
-				}
+	ret = lock_deadlock_search(trx, lock, max_usec, defer);
 
-				lock_deadlock_found = TRUE;
+	switch (ret) {
+	case LOCK_VICTIM_IS_OTHER:
+		/* We chose some other trx as a victim: retry if our
+		request still waits and there still is a deadlock */
 
-				/* Let us choose the transaction of wait_lock
-				as a victim to try to avoid deadlocking our
-				recursion starting point transaction */
+		if (trx->wait_lock != lock) {
 
-				fputs("*** WE ROLL BACK TRANSACTION (1)\n",
-				      ef);
+			return(FALSE);
+		}
 
-				wait_lock->trx->was_chosen_as_deadlock_victim
-					= TRUE;
+		goto retry;
 
-				lock_cancel_waiting_and_release(wait_lock);
+	case LOCK_VICTIM_IS_START:
+		lock_deadlock_found = TRUE;
 
-				/* Since trx and wait_lock are no longer
-				in the waits-for graph, we can return FALSE;
-				note that our selective algorithm can choose
-				several transactions as victims, but still
-				we may end up rolling back also the recursion
-				starting point transaction! */
+		fputs("*** WE ROLL BACK TRANSACTION (2)\n",
+		      lock_latest_err_file);
 
-				return(LOCK_VICTIM_IS_OTHER);
-			}
+		return(TRUE);
 
-			if (lock_trx->que_state == TRX_QUE_LOCK_WAIT) {
+	case LOCK_SEARCH_DEFERRED:
+		trx->deadlock_check_deferred = TRUE;
 
-				/* Another trx ahead has requested lock	in an
-				incompatible mode, and is itself waiting for
-				a lock */
+		/* Wake up the thread which will finish the check */
+		os_event_set(srv_lock_timeout_thread_event);
+	}
 
-				ret = lock_deadlock_recursive(
-					start, lock_trx,
-					lock_trx->wait_lock, cost, depth + 1);
-				if (ret != 0) {
+	return(FALSE);
+}
 
-					return(ret);
-				}
-			}
+/************************************************************************
+Checks if a lock request results in a deadlock. */
+static
+ibool
+lock_deadlock_occurs(
+/*=================*/
+			/* out: TRUE if a deadlock was detected and we
+			chose trx as a victim; FALSE if no deadlock, or
+			there was a deadlock, but we chose other
+			transaction(s) as victim(s) */
+	lock_t*	lock,	/* in: lock the transaction is requesting */
+	trx_t*	trx)	/* in: transaction */
+{
+	return(lock_deadlock_check(lock, trx,
+				   srv_deadlock_check_budget_usec,
+				   srv_deadlock_detect_background));
+}
+
+/************************************************************************
+Finishes the deadlock checks which lock_deadlock_occurs() left undone
+because they ran out of their budget. The checks are done without a time
+budget, and a transaction chosen as a victim has its lock wait cancelled. */
+UNIV_INTERN
+void
+lock_deadlock_check_deferred(void)
+/*==============================*/
+{
+	trx_t*	trx;
+
+	ut_ad(mutex_own(&kernel_mutex));
+
+	for (trx = UT_LIST_GET_FIRST(trx_sys->trx_list); trx != NULL;
+	     trx = UT_LIST_GET_NEXT(trx_list, trx)) {
+
+		if (!trx->deadlock_check_deferred) {
+
+			continue;
+		}
+
+		if (trx->que_state == TRX_QUE_LOCK_WAIT
+		    && trx->wait_lock != NULL
+		    && lock_deadlock_check(trx->wait_lock, trx, 0, FALSE)) {
+
+			trx->was_chosen_as_deadlock_victim = TRUE;
+
+			lock_cancel_waiting_and_release(trx->wait_lock);
 		}
-	}/* end of the 'for (;;)'-loop */
+
+		trx->deadlock_check_deferred = FALSE;
+	}
 }
 
 /*========================= TABLE LOCKS ==============================*/
@@ -4271,20 +4834,20 @@ ulint
 lock_get_n_rec_locks(void)
 /*======================*/
 {
-	lock_t*	lock;
-	ulint	n_locks	= 0;
-	ulint	i;
+	lock_rec_queue_t*	queue;
+	ulint			n_locks	= 0;
+	ulint			i;
 
 	ut_ad(mutex_own(&kernel_mutex));
 
 	for (i = 0; i < hash_get_n_cells(lock_sys->rec_hash); i++) {
 
-		lock = HASH_GET_FIRST(lock_sys->rec_hash, i);
+		queue = HASH_GET_FIRST(lock_sys->rec_hash, i);
 
-		while (lock) {
-			n_locks++;
+		while (queue) {
+			n_locks += UT_LIST_GET_LEN(queue->locks);
 
-			lock = HASH_GET_NEXT(hash, lock);
+			queue = HASH_GET_NEXT(hash, queue);
 		}
 	}
 
@@ -4314,6 +4877,14 @@ lock_print_info_summary(
 		ut_copy_file(file, lock_latest_err_file);
 	}
 
+	fprintf(file,
+		"Deadlock checks %lu, search steps %lu,"
+		" deadlocks found %lu, checks deferred %lu\n",
+		(ulong) lock_deadlock_n_checks,
+		(ulong) lock_deadlock_n_steps,
+		(ulong) lock_deadlock_n_found,
+		(ulong) lock_deadlock_n_deferred);
+
 	fputs("------------\n"
 	      "TRANSACTIONS\n"
 	      "------------\n", file);
@@ -4657,6 +5228,61 @@ lock_rec_queue_validate(
 	return(TRUE);
 }
 
+/*************************************************************************
+Validates the lists of the granted locks and of the waiting requests of a
+record lock queue. */
+static
+ibool
+lock_rec_queue_validate_lists(
+/*==========================*/
+					/* out: TRUE if ok */
+	const lock_rec_queue_t*	queue)	/* in: record lock queue */
+{
+	const lock_t*	lock;
+	const lock_t*	next;
+	ulint		n_waiting	= 0;
+	ulint		i;
+
+	ut_ad(mutex_own(&kernel_mutex));
+
+	for (lock = UT_LIST_GET_FIRST(queue->locks); lock != NULL;
+	     lock = next) {
+		next = UT_LIST_GET_NEXT(un_member.rec_lock.locks, lock);
+
+		ut_a(!next || next->un_member.rec_lock.seq
+		     > lock->un_member.rec_lock.seq);
+		ut_a(lock->un_member.rec_lock.seq < queue->next_seq);
+	}
+
+	for (lock = UT_LIST_GET_FIRST(queue->granted); lock != NULL;
+	     lock = UT_LIST_GET_NEXT(un_member.rec_lock.state_list, lock)) {
+
+		ut_a(!lock_get_wait(lock));
+	}
+
+	for (i = 0; i < LOCK_REC_QUEUE_N_CELLS; i++) {
+		for (lock = UT_LIST_GET_FIRST(queue->waiting[i]);
+		     lock != NULL; lock = next) {
+			next = UT_LIST_GET_NEXT(un_member.rec_lock.state_list,
+						lock);
+
+			ut_a(lock_get_wait(lock));
+			ut_a(lock->un_member.rec_lock.wait_heap_no
+			     % LOCK_REC_QUEUE_N_CELLS == i);
+			ut_a(!next || next->un_member.rec_lock.seq
+			     > lock->un_member.rec_lock.seq);
+		}
+
+		n_waiting += UT_LIST_GET_LEN(queue->waiting[i]);
+	}
+
+	ut_a(n_waiting == queue->n_waiting);
+	ut_a(n_waiting + UT_LIST_GET_LEN(queue->granted)
+	     == UT_LIST_GET_LEN(queue->locks));
+
+	return(TRUE);
+}
+
 /*************************************************************************
 Validates the record lock queues on a page. */
 static
@@ -4764,12 +5390,13 @@ lock_validate(void)
 /*===============*/
 			/* out: TRUE if ok */
 {
-	lock_t*	lock;
-	trx_t*	trx;
-	dulint	limit;
-	ulint	space;
-	ulint	page_no;
-	ulint	i;
+	lock_rec_queue_t*	queue;
+	lock_t*			lock;
+	trx_t*			trx;
+	dulint			limit;
+	ulint			space;
+	ulint			page_no;
+	ulint			i;
 
 	lock_mutex_enter_kernel();
 
@@ -4796,13 +5423,23 @@ lock_validate(void)
 		limit = ut_dulint_zero;
 
 		for (;;) {
-			lock = HASH_GET_FIRST(lock_sys->rec_hash, i);
+			queue = HASH_GET_FIRST(lock_sys->rec_hash, i);
+
+			while (queue) {
+				ut_a(UT_LIST_GET_LEN(queue->locks) > 0);
+
+				for (lock = UT_LIST_GET_FIRST(queue->locks);
+				     lock != NULL;
+				     lock = lock_rec_get_next_on_page(lock)) {
+					ut_a(trx_in_trx_list(lock->trx));
+					ut_a(lock->un_member.rec_lock.queue
+					     == queue);
+				}
 
-			while (lock) {
-				ut_a(trx_in_trx_list(lock->trx));
+				ut_a(lock_rec_queue_validate_lists(queue));
 
-				space = lock->un_member.rec_lock.space;
-				page_no = lock->un_member.rec_lock.page_no;
+				space = queue->space;
+				page_no = queue->page_no;
 
 				if (ut_dulint_cmp(
 					    ut_dulint_create(space, page_no),
@@ -4810,10 +5447,10 @@ lock_validate(void)
 					break;
 				}
 
-				lock = HASH_GET_NEXT(hash, lock);
+				queue = HASH_GET_NEXT(hash, queue);
 			}
 
-			if (!lock) {
+			if (!queue) {
 
 				break;
 			}
@@ -1174,6 +1174,8 @@ log_group_write_buf(
 	ut_ad(mutex_own(&(log_sys->mutex)));
 	ut_a(len % OS_FILE_LOG_BLOCK_SIZE == 0);
 	ut_a(((ulint) start_lsn) % OS_FILE_LOG_BLOCK_SIZE == 0);
+	/* The log files may be opened with O_DIRECT */
+	ut_ad(ut_align_offset(buf, OS_FILE_LOG_BLOCK_SIZE) == 0);
 
 	if (new_data_offset == 0) {
 		write_header = TRUE;
@@ -2110,6 +2112,8 @@ log_group_read_log_seg(
 	ibool	sync;
 
 	ut_ad(mutex_own(&(log_sys->mutex)));
+	/* The log files may be opened with O_DIRECT */
+	ut_ad(ut_align_offset(buf, OS_FILE_LOG_BLOCK_SIZE) == 0);
 
 	sync = (type == LOG_RECOVER);
 loop:
@@ -3009,7 +3013,9 @@ loop:
 
 	if (srv_fast_shutdown < 2
 	   && (srv_error_monitor_active
-	      || srv_lock_timeout_and_monitor_active)) {
+	      || srv_lock_timeout_and_monitor_active
+	      || srv_LRU_flusher_active
+	      || srv_preallocate_active)) {
 
 		mutex_exit(&kernel_mutex);
 
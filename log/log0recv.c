@@ -51,6 +51,15 @@ this must be less than UNIV_PAGE_SIZE as it is stored in the buffer pool */
 /* Read-ahead area in applying log records to file pages */
 #define RECV_READ_AHEAD_AREA	32
 
+/* The hash table of recv_sys gets one cell for this many bytes of memory
+available for log records: a recv_addr_t, its recv_t structs and typical
+record bodies take a few hundred bytes per page, so that the chains stay
+short also when recv_sys->heap has grown to its limit */
+#define RECV_HASH_BYTES_PER_CELL	512
+
+/* Interval in seconds between progress reports of a parallel apply batch */
+#define RECV_PROGRESS_INTERVAL	10
+
 UNIV_INTERN recv_sys_t*	recv_sys = NULL;
 UNIV_INTERN ibool	recv_recovery_on = FALSE;
 UNIV_INTERN ibool	recv_recovery_from_backup_on = FALSE;
@@ -169,8 +178,10 @@ recv_sys_init(
 	recv_sys->len = 0;
 	recv_sys->recovered_offset = 0;
 
-	recv_sys->addr_hash = hash_create(available_memory / 64);
+	recv_sys->addr_hash = hash_create(available_memory
+					  / RECV_HASH_BYTES_PER_CELL);
 	recv_sys->n_addrs = 0;
+	recv_sys->n_apply_threads = 0;
 
 	recv_sys->apply_log_recs = FALSE;
 	recv_sys->apply_batch_on = FALSE;
@@ -206,10 +217,11 @@ recv_sys_empty_hash(void)
 		ut_error;
 	}
 
-	hash_table_free(recv_sys->addr_hash);
-	mem_heap_empty(recv_sys->heap);
+	/* Keep the hash table that recv_sys_init() sized from the
+	available memory: the next batch can grow as big as this one */
 
-	recv_sys->addr_hash = hash_create(buf_pool_get_curr_size() / 256);
+	hash_table_clear(recv_sys->addr_hash);
+	mem_heap_empty(recv_sys->heap);
 }
 
 #ifndef UNIV_LOG_DEBUG
@@ -1081,7 +1093,23 @@ recv_add_to_hash_table(
 
 	len = rec_end - body;
 
-	recv = mem_heap_alloc(recv_sys->heap, sizeof(recv_t));
+	if (len <= RECV_DATA_BLOCK_SIZE - sizeof(recv_t)) {
+		/* Store a short record body in the same allocation as
+		the record, so that it takes one chunk of the heap */
+
+		recv = mem_heap_alloc(recv_sys->heap, sizeof(recv_t)
+				      + sizeof(recv_data_t) + len);
+		recv_data = (recv_data_t*) (recv + 1);
+		recv_data->next = NULL;
+
+		ut_memcpy(((byte*)recv_data) + sizeof(recv_data_t),
+			  body, len);
+		recv->data = recv_data;
+	} else {
+		recv = mem_heap_alloc(recv_sys->heap, sizeof(recv_t));
+		recv->data = NULL;
+	}
+
 	recv->type = type;
 	recv->len = rec_end - body;
 	recv->start_lsn = start_lsn;
@@ -1109,6 +1137,11 @@ recv_add_to_hash_table(
 
 	UT_LIST_ADD_LAST(rec_list, recv_addr->rec_list, recv);
 
+	if (recv->data) {
+
+		return;
+	}
+
 	prev_field = &(recv->data);
 
 	/* Store the log record body in chunks of less than UNIV_PAGE_SIZE:
@@ -1222,6 +1255,22 @@ recv_recover_page(
 		return;
 	}
 
+	if (just_read_in && recv_sys->n_apply_threads
+	    && recv_addr->state == RECV_BEING_READ
+	    && recv_no_ibuf_operations) {
+		/* The page was read ahead by the thread dispatching
+		the batch.  Leave it to the recovery thread owning the
+		page, so that the i/o-handler thread does not serialize
+		the application.  This is only safe when no insert
+		buffer merge follows the read. */
+
+		recv_addr->state = RECV_NOT_PROCESSED;
+
+		mutex_exit(&(recv_sys->mutex));
+
+		return;
+	}
+
 #if 0
 	fprintf(stderr, "Recovering space %lu, page %lu\n",
 		buf_block_get_space(block), buf_block_get_page_no(block));
@@ -1418,26 +1467,287 @@ recv_read_in_area(
 	return(n);
 }
 
+/***********************************************************************
+Applies the hashed log records to a page, reading the page in first if
+it is not in the buffer pool. */
+static
+void
+recv_apply_page(
+/*============*/
+	ulint	space,	/* in: space id */
+	ulint	page_no)/* in: page number */
+{
+	ulint		zip_size = fil_space_get_zip_size(space);
+	buf_block_t*	block;
+	mtr_t		mtr;
+
+	if (!buf_page_peek(space, page_no)) {
+		/* Read the page synchronously, so that the i/o
+		completion applies the log records in this thread */
+
+		buf_read_recv_pages(TRUE, space, zip_size, &page_no, 1);
+	}
+
+	mtr_start(&mtr);
+
+	block = buf_page_get(space, zip_size, page_no, RW_X_LATCH, &mtr);
+#ifdef UNIV_SYNC_DEBUG
+	buf_block_dbg_add_level(block, SYNC_NO_ORDER_CHECK);
+#endif /* UNIV_SYNC_DEBUG */
+	recv_recover_page(FALSE, FALSE, block);
+
+	mtr_commit(&mtr);
+}
+
+/* Number of recovery threads in the current parallel apply batch */
+static ulint	recv_n_apply_partitions;
+/* Partition numbers passed to the recovery threads */
+static ulint	recv_apply_thread_no[RECV_MAX_N_THREADS];
+
+/***********************************************************************
+A thread applying log records to the pages whose addresses hash to the
+cells i of recv_sys->addr_hash where i mod recv_n_apply_partitions
+equals the partition number of the thread.  Each page thus has exactly
+one thread applying its log records. */
+static
+os_thread_ret_t
+recv_apply_thread(
+/*==============*/
+			/* out: a dummy parameter */
+	void*	arg)	/* in: pointer to the partition number */
+{
+	ulint		no	= *(ulint*) arg;
+	ulint		n	= recv_n_apply_partitions;
+	recv_addr_t*	recv_addr;
+	ulint		i;
+
+	for (i = no; i < hash_get_n_cells(recv_sys->addr_hash); i += n) {
+
+		/* The hash table is not modified during the batch:
+		it can be traversed without holding recv_sys->mutex */
+
+		recv_addr = HASH_GET_FIRST(recv_sys->addr_hash, i);
+
+		while (recv_addr) {
+			/* A page in RECV_BEING_READ is either applied
+			by the i/o-handler thread or left to us; in
+			both cases buf_page_get() waits for the read. */
+
+			if (recv_addr->state != RECV_PROCESSED) {
+				recv_apply_page(recv_addr->space,
+						recv_addr->page_no);
+			}
+
+			recv_addr = HASH_GET_NEXT(addr_hash, recv_addr);
+		}
+	}
+
+	mutex_enter(&(recv_sys->mutex));
+	ut_a(recv_sys->n_apply_threads > 0);
+	recv_sys->n_apply_threads--;
+	mutex_exit(&(recv_sys->mutex));
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/***********************************************************************
+Prints the progress of a parallel apply batch and an estimate of the
+remaining time, at most every RECV_PROGRESS_INTERVAL seconds. */
+static
+void
+recv_apply_report_progress(
+/*=======================*/
+	ulint		n_total,	/* in: number of pages in the batch */
+	ib_time_t	start_time,	/* in: time when the batch was
+					started */
+	ib_time_t*	last_time)	/* in/out: time of the previous
+					report */
+{
+	ib_time_t	now	= ut_time();
+	ulint		n_done;
+	ulint		n_left;
+	ulint		elapsed;
+	ulint		eta;
+
+	if (ut_difftime(now, *last_time) < RECV_PROGRESS_INTERVAL) {
+
+		return;
+	}
+
+	*last_time = now;
+
+	n_left = recv_sys->n_addrs;
+	n_done = n_total > n_left ? n_total - n_left : 0;
+	elapsed = (ulint) ut_difftime(now, start_time);
+	eta = n_done ? (ulint) ((double) elapsed * n_left / n_done) : 0;
+
+	ut_print_timestamp(stderr);
+	fprintf(stderr,
+		"  InnoDB: Applied log records to %lu of %lu pages"
+		" (%lu%%), about %lu seconds left\n",
+		(ulong) n_done, (ulong) n_total,
+		(ulong) (n_total ? n_done * 100 / n_total : 100),
+		(ulong) eta);
+}
+
+/***********************************************************************
+Applies a batch of hashed log records in srv_n_recv_threads threads,
+partitioned by the page address.  The calling thread reads ahead the
+pages that are not in the buffer pool, keeping at most about
+recv_n_pool_free_frames pages ahead of the recovery threads, and reports
+the progress. */
+static
+void
+recv_apply_in_threads(void)
+/*=======================*/
+{
+	recv_addr_t*	recv_addr;
+	ulint		n_total;
+	ulint		n_read		= 0;
+	ulint		n_threads;
+	ib_time_t	start_time;
+	ib_time_t	last_time;
+	ulint		i;
+
+	ut_ad(!mutex_own(&(recv_sys->mutex)));
+
+	n_threads = ut_min(srv_n_recv_threads, RECV_MAX_N_THREADS);
+
+	mutex_enter(&(recv_sys->mutex));
+	n_total = recv_sys->n_addrs;
+
+	if (n_total == 0) {
+		mutex_exit(&(recv_sys->mutex));
+
+		return;
+	}
+
+	ut_a(recv_sys->n_apply_threads == 0);
+	recv_sys->n_apply_threads = n_threads;
+	recv_n_apply_partitions = n_threads;
+	mutex_exit(&(recv_sys->mutex));
+
+	ut_print_timestamp(stderr);
+	fprintf(stderr,
+		"  InnoDB: Starting an apply batch of log records"
+		" to %lu pages using %lu threads...\n",
+		(ulong) n_total, (ulong) n_threads);
+
+	start_time = last_time = ut_time();
+
+	for (i = 0; i < n_threads; i++) {
+		recv_apply_thread_no[i] = i;
+
+		os_thread_create(recv_apply_thread,
+				 recv_apply_thread_no + i, NULL);
+	}
+
+	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
+
+		recv_addr = HASH_GET_FIRST(recv_sys->addr_hash, i);
+
+		while (recv_addr) {
+			ulint	space = recv_addr->space;
+			ulint	page_no = recv_addr->page_no;
+
+			if (recv_addr->state == RECV_NOT_PROCESSED
+			    && !buf_page_peek(space, page_no)) {
+
+				n_read += recv_read_in_area(
+					space, fil_space_get_zip_size(space),
+					page_no);
+			}
+
+			/* Do not read so far ahead that the pages would
+			be evicted before their recovery thread reaches
+			them */
+
+			while (recv_sys->n_apply_threads
+			       && n_read > n_total - recv_sys->n_addrs
+			       + recv_n_pool_free_frames) {
+
+				os_thread_sleep(10000);
+
+				recv_apply_report_progress(
+					n_total, start_time, &last_time);
+			}
+
+			recv_addr = HASH_GET_NEXT(addr_hash, recv_addr);
+		}
+	}
+
+	while (recv_sys->n_apply_threads) {
+
+		os_thread_sleep(100000);
+
+		recv_apply_report_progress(n_total, start_time, &last_time);
+	}
+
+	ut_print_timestamp(stderr);
+	fprintf(stderr,
+		"  InnoDB: Applied log records to %lu pages"
+		" in %lu seconds\n",
+		(ulong) n_total,
+		(ulong) ut_difftime(ut_time(), start_time));
+}
+
+/***********************************************************************
+Flushes the file pages to disk and invalidates them in the buffer pool.
+This must be done before ibuf operations are allowed again after log
+records were applied without them: the pages read in by the batches did
+not get their insert buffer records merged, which happens when a page is
+read in. */
+static
+void
+recv_flush_and_invalidate(void)
+/*===========================*/
+{
+	ulint	n_pages;
+
+	ut_ad(!mutex_own(&(log_sys->mutex)));
+	ut_ad(!mutex_own(&(recv_sys->mutex)));
+	ut_ad(recv_no_ibuf_operations);
+
+	n_pages = buf_flush_batch(BUF_FLUSH_LIST, ULINT_MAX,
+				  IB_ULONGLONG_MAX);
+	ut_a(n_pages != ULINT_UNDEFINED);
+
+	buf_flush_wait_batch_end(BUF_FLUSH_LIST);
+
+	buf_pool_invalidate();
+
+	recv_no_ibuf_operations = FALSE;
+}
+
 /***********************************************************************
 Empties the hash table of stored log records, applying them to appropriate
 pages. */
-UNIV_INTERN
+static
 void
-recv_apply_hashed_log_recs(
-/*=======================*/
-	ibool	allow_ibuf)	/* in: if TRUE, also ibuf operations are
+recv_apply_batch(
+/*=============*/
+	ibool	allow_ibuf,	/* in: if TRUE, also ibuf operations are
 				allowed during the application; if FALSE,
-				no ibuf operations are allowed, and after
-				the application all file pages are flushed to
-				disk and invalidated in buffer pool: this
+				no ibuf operations are allowed: this
 				alternative means that no new log records
 				can be generated during the application;
 				the caller must in this case own the log
 				mutex */
+	ibool	invalidate)	/* in: if TRUE, after the application of
+				a batch without ibuf operations all file
+				pages are flushed to disk and invalidated
+				in the buffer pool; if FALSE, they are left
+				in the buffer pool for the next batch, and
+				recv_flush_and_invalidate() must be called
+				before ibuf operations are allowed */
 {
 	recv_addr_t* recv_addr;
 	ulint	i;
-	ulint	n_pages;
 	ibool	has_printed	= FALSE;
 	mtr_t	mtr;
 loop:
@@ -1456,11 +1766,29 @@ loop:
 
 	if (!allow_ibuf) {
 		recv_no_ibuf_operations = TRUE;
+	} else if (recv_no_ibuf_operations) {
+		/* An earlier batch left pages in the buffer pool */
+
+		mutex_exit(&(recv_sys->mutex));
+
+		recv_flush_and_invalidate();
+
+		mutex_enter(&(recv_sys->mutex));
 	}
 
 	recv_sys->apply_log_recs = TRUE;
 	recv_sys->apply_batch_on = TRUE;
 
+	if (srv_n_recv_threads > 1) {
+		mutex_exit(&(recv_sys->mutex));
+
+		recv_apply_in_threads();
+
+		mutex_enter(&(recv_sys->mutex));
+
+		goto wait_for_pages;
+	}
+
 	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
 
 		recv_addr = HASH_GET_FIRST(recv_sys->addr_hash, i);
@@ -1519,6 +1847,7 @@ loop:
 		}
 	}
 
+wait_for_pages:
 	/* Wait until all the pages have been processed */
 
 	while (recv_sys->n_addrs != 0) {
@@ -1535,25 +1864,17 @@ loop:
 		fprintf(stderr, "\n");
 	}
 
-	if (!allow_ibuf) {
+	if (!allow_ibuf && invalidate) {
 		/* Flush all the file pages to disk and invalidate them in
 		the buffer pool */
 
 		mutex_exit(&(recv_sys->mutex));
 		mutex_exit(&(log_sys->mutex));
 
-		n_pages = buf_flush_batch(BUF_FLUSH_LIST, ULINT_MAX,
-					  IB_ULONGLONG_MAX);
-		ut_a(n_pages != ULINT_UNDEFINED);
-
-		buf_flush_wait_batch_end(BUF_FLUSH_LIST);
-
-		buf_pool_invalidate();
+		recv_flush_and_invalidate();
 
 		mutex_enter(&(log_sys->mutex));
 		mutex_enter(&(recv_sys->mutex));
-
-		recv_no_ibuf_operations = FALSE;
 	}
 
 	recv_sys->apply_log_recs = FALSE;
@@ -1568,6 +1889,26 @@ loop:
 	mutex_exit(&(recv_sys->mutex));
 }
 
+/***********************************************************************
+Empties the hash table of stored log records, applying them to appropriate
+pages. */
+UNIV_INTERN
+void
+recv_apply_hashed_log_recs(
+/*=======================*/
+	ibool	allow_ibuf)	/* in: if TRUE, also ibuf operations are
+				allowed during the application; if FALSE,
+				no ibuf operations are allowed, and after
+				the application all file pages are flushed to
+				disk and invalidated in buffer pool: this
+				alternative means that no new log records
+				can be generated during the application;
+				the caller must in this case own the log
+				mutex */
+{
+	recv_apply_batch(allow_ibuf, !allow_ibuf);
+}
+
 #ifdef UNIV_HOTBACKUP
 /***********************************************************************
 Applies log records in the hash table to a backup. */
@@ -2434,9 +2775,12 @@ recv_scan_log_recs(
 			empty it; FALSE means no ibuf operations
 			allowed, as we cannot add new records to the
 			log yet: they would be produced by ibuf
-			operations */
+			operations.  The recovered pages stay in the
+			buffer pool, so that the next batches need not
+			read them again; they are invalidated once at
+			the end of the log scan. */
 
-			recv_apply_hashed_log_recs(FALSE);
+			recv_apply_batch(FALSE, FALSE);
 		}
 
 		if (recv_sys->recovered_offset > RECV_PARSING_BUF_SIZE / 4) {
@@ -2566,9 +2910,15 @@ recv_recovery_from_checkpoint_start(
 	ib_uint64_t	archived_lsn;
 	ulint		capacity;
 	byte*		buf;
-	byte		log_hdr_buf[LOG_FILE_HDR_SIZE];
+	byte*		log_hdr_buf;
+	byte		log_hdr_buf_unaligned[LOG_FILE_HDR_SIZE
+					      + OS_FILE_LOG_BLOCK_SIZE];
 	ulint		err;
 
+	/* Align the buffer for file i/o, as the log files may be
+	opened with O_DIRECT */
+	log_hdr_buf = ut_align(log_hdr_buf_unaligned, OS_FILE_LOG_BLOCK_SIZE);
+
 	ut_ad(type != LOG_CHECKPOINT || limit_lsn == IB_ULONGLONG_MAX);
 
 	if (type == LOG_CHECKPOINT) {
@@ -2739,6 +3089,18 @@ recv_recovery_from_checkpoint_start(
 
 	/* Done with startup scan. Clear the flag. */
 	recv_log_scan_is_startup_type = FALSE;
+
+	if (recv_no_ibuf_operations) {
+		/* Apply batches during the scan left the recovered
+		pages in the buffer pool without merging their insert
+		buffer records */
+
+		mutex_exit(&(log_sys->mutex));
+
+		recv_flush_and_invalidate();
+
+		mutex_enter(&(log_sys->mutex));
+	}
 	if (type == LOG_CHECKPOINT) {
 		/* NOTE: we always do a 'recovery' at startup, but only if
 		there is something wrong we will print a message to the
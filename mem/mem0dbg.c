@@ -141,6 +141,17 @@ mem_init(
 	mem_comm_pool = mem_pool_create(size);
 }
 
+/**********************************************************************
+Frees the area caches of the common memory pool. Its memory is freed by
+ut_free_all_mem(). */
+UNIV_INTERN
+void
+mem_close(void)
+/*===========*/
+{
+	mem_pool_free_caches(mem_comm_pool);
+}
+
 #ifdef UNIV_MEM_DEBUG
 /**********************************************************************
 Initializes an allocated memory field in the debug version. */
@@ -15,6 +15,7 @@ Created 5/12/1997 Heikki Tuuri
 #include "ut0mem.h"
 #include "ut0lst.h"
 #include "ut0byte.h"
+#include "ut0rnd.h"
 #include "mem0mem.h"
 
 /* We would like to use also the buffer frames to allocate memory. This
@@ -79,18 +80,57 @@ pool, and after that its locks will grow into the buffer pool. */
 #define MEM_AREA_MIN_SIZE	(2 * MEM_AREA_EXTRA_SIZE)
 
 
+/* Number of area caches in front of a memory pool. A thread uses the
+cache picked by its thread id, so that the threads seldom share one. */
+#define MEM_POOL_N_CACHES	32
+
+/* The largest area size class which is cached: areas of up to 16 kB,
+which covers the standard size of a heap block */
+#define MEM_CACHE_MAX_CLASS	14
+
+/* Number of areas moved from the pool to a cache at a time */
+#define MEM_CACHE_BATCH		4
+
+typedef struct mem_cache_struct	mem_cache_t;
+
+/* A cache of allocated areas in front of a memory pool. The common
+mem_heap_create()/mem_heap_free() cycle is served from here without
+reserving the pool mutex; the cache is refilled from the pool and
+returned to it in batches. */
+struct mem_cache_struct{
+	os_fast_mutex_t	mutex;		/* mutex protecting this struct;
+					a thread which finds it reserved
+					bypasses the cache */
+	UT_LIST_BASE_NODE_T(mem_area_t)
+			free_list[MEM_CACHE_MAX_CLASS + 1];
+					/* lists of cached areas, indexed
+					like the free lists of the pool */
+	ulint		size;		/* total size of the cached areas */
+	ulint		n_hits;		/* allocations served by the cache */
+	ulint		n_misses;	/* allocations which found the
+					cache empty */
+	ulint		n_refills;	/* batches taken from the pool */
+	ulint		n_flushes;	/* batches returned to the pool */
+};
+
 /* Data structure for a memory pool. The space is allocated using the buddy
 algorithm, where free list i contains areas of size 2 to power i. */
 struct mem_pool_struct{
 	byte*		buf;		/* memory pool */
 	ulint		size;		/* memory common pool size */
 	ulint		reserved;	/* amount of currently allocated
-					memory */
+					memory, including the areas held
+					in the caches */
 	mutex_t		mutex;		/* mutex protecting this struct */
 	UT_LIST_BASE_NODE_T(mem_area_t)
 			free_list[64];	/* lists of free memory areas: an
 					area is put to the list whose number
 					is the 2-logarithm of the area size */
+	mem_cache_t*	caches;		/* array of MEM_POOL_N_CACHES
+					area caches */
+	ulint		cache_max_size;	/* maximum total size of the areas
+					in one cache; the caches together
+					hold at most a quarter of the pool */
 };
 
 /* The common memory pool */
@@ -122,6 +162,16 @@ mem_pool_mutex_exit(void)
 	mutex_exit(&(mem_comm_pool->mutex));
 }
 
+/************************************************************************
+Puts an area to the free lists of a pool, merging it with its free
+buddies. The caller must own the pool mutex. */
+static
+void
+mem_pool_free_low(
+/*==============*/
+	mem_area_t*	area,	/* in, own: area which is not free */
+	mem_pool_t*	pool);	/* in: memory pool */
+
 /************************************************************************
 Returns memory area size. */
 UNIV_INLINE
@@ -241,9 +291,85 @@ mem_pool_create(
 
 	pool->reserved = 0;
 
+	pool->caches = ut_malloc(MEM_POOL_N_CACHES * sizeof(mem_cache_t));
+	pool->cache_max_size = size / 4 / MEM_POOL_N_CACHES;
+
+	for (i = 0; i < MEM_POOL_N_CACHES; i++) {
+		mem_cache_t*	cache = &pool->caches[i];
+		ulint		j;
+
+		os_fast_mutex_init(&cache->mutex);
+
+		for (j = 0; j <= MEM_CACHE_MAX_CLASS; j++) {
+			UT_LIST_INIT(cache->free_list[j]);
+		}
+
+		cache->size = 0;
+		cache->n_hits = 0;
+		cache->n_misses = 0;
+		cache->n_refills = 0;
+		cache->n_flushes = 0;
+	}
+
 	return(pool);
 }
 
+/************************************************************************
+Returns the areas held in the caches of a pool to the pool and frees the
+caches. */
+UNIV_INTERN
+void
+mem_pool_free_caches(
+/*=================*/
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	mem_area_t*	area;
+	ulint		i;
+	ulint		j;
+
+	mutex_enter(&(pool->mutex));
+
+	for (i = 0; i < MEM_POOL_N_CACHES; i++) {
+		mem_cache_t*	cache = &pool->caches[i];
+
+		for (j = 0; j <= MEM_CACHE_MAX_CLASS; j++) {
+			while ((area = UT_LIST_GET_FIRST(
+					cache->free_list[j])) != NULL) {
+
+				UT_LIST_REMOVE(free_list,
+					       cache->free_list[j], area);
+				mem_pool_free_low(area, pool);
+			}
+		}
+
+		os_fast_mutex_free(&cache->mutex);
+	}
+
+	mutex_exit(&(pool->mutex));
+
+	ut_free(pool->caches);
+	pool->caches = NULL;
+}
+
+/************************************************************************
+Returns the area cache of the current thread. */
+UNIV_INLINE
+mem_cache_t*
+mem_pool_get_cache(
+/*===============*/
+				/* out: area cache */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	ulint	id;
+
+	/* Thread ids are often addresses of thread stacks, aligned to
+	a large power of 2: fold in the higher bits. */
+	id = (ulint) os_thread_pf(os_thread_get_curr_id());
+
+	return(&pool->caches[ut_fold_ulint_pair(id, id >> 12)
+			     % MEM_POOL_N_CACHES]);
+}
+
 /************************************************************************
 Fills the specified free list. */
 static
@@ -317,32 +443,21 @@ mem_pool_fill_free_list(
 }
 
 /************************************************************************
-Allocates memory from a pool. NOTE: This low-level function should only be
-used in mem0mem.*! */
-UNIV_INTERN
-void*
-mem_area_alloc(
-/*===========*/
-				/* out, own: allocated memory buffer */
-	ulint*		psize,	/* in: requested size in bytes; for optimum
-				space usage, the size should be a power of 2
-				minus MEM_AREA_EXTRA_SIZE;
-				out: allocated size in bytes (greater than
-				or equal to the requested size) */
+Takes an area from a free list of a pool. The caller must own the pool
+mutex. */
+static
+mem_area_t*
+mem_pool_alloc_low(
+/*===============*/
+				/* out: area, or NULL if the pool is out
+				of space */
+	ulint		n,	/* in: 2-logarithm of the area size */
 	mem_pool_t*	pool)	/* in: memory pool */
 {
 	mem_area_t*	area;
-	ulint		size;
-	ulint		n;
 	ibool		ret;
 
-	size = *psize;
-	n = ut_2_log(ut_max(size + MEM_AREA_EXTRA_SIZE, MEM_AREA_MIN_SIZE));
-
-	mutex_enter(&(pool->mutex));
-	mem_n_threads_inside++;
-
-	ut_a(mem_n_threads_inside == 1);
+	ut_ad(mutex_own(&(pool->mutex)));
 
 	area = UT_LIST_GET_FIRST(pool->free_list[n]);
 
@@ -350,13 +465,8 @@ mem_area_alloc(
 		ret = mem_pool_fill_free_list(n, pool);
 
 		if (ret == FALSE) {
-			/* Out of memory in memory pool: we try to allocate
-			from the operating system with the regular malloc: */
 
-			mem_n_threads_inside--;
-			mutex_exit(&(pool->mutex));
-
-			return(ut_malloc(size));
+			return(NULL);
 		}
 
 		area = UT_LIST_GET_FIRST(pool->free_list[n]);
@@ -403,8 +513,145 @@ mem_area_alloc(
 
 	pool->reserved += mem_area_get_size(area);
 
-	mem_n_threads_inside--;
-	mutex_exit(&(pool->mutex));
+	return(area);
+}
+
+/************************************************************************
+Takes an area from the cache of the current thread, refilling the cache
+from the pool if it is empty. */
+static
+mem_area_t*
+mem_cache_alloc(
+/*============*/
+				/* out: area, or NULL if the cache is in
+				use by another thread or could not be
+				filled */
+	ulint		n,	/* in: 2-logarithm of the area size */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	mem_cache_t*	cache;
+	mem_area_t*	area;
+	ulint		i;
+
+	if (UNIV_UNLIKELY(pool->caches == NULL)) {
+		/* mem_close() has been called */
+
+		return(NULL);
+	}
+
+	cache = mem_pool_get_cache(pool);
+
+	if (os_fast_mutex_trylock(&cache->mutex)) {
+
+		return(NULL);
+	}
+
+	area = UT_LIST_GET_FIRST(cache->free_list[n]);
+
+	if (area != NULL) {
+		cache->n_hits++;
+	} else {
+		cache->n_misses++;
+
+		if (cache->size + ut_2_exp(n) > pool->cache_max_size) {
+			os_fast_mutex_unlock(&cache->mutex);
+
+			return(NULL);
+		}
+
+		/* Take a batch of areas from the pool, reserving its
+		mutex only once */
+
+		mutex_enter(&(pool->mutex));
+		mem_n_threads_inside++;
+
+		ut_a(mem_n_threads_inside == 1);
+
+		for (i = 0; i < MEM_CACHE_BATCH; i++) {
+			if (i > 0 && cache->size + ut_2_exp(n)
+			    > pool->cache_max_size) {
+
+				break;
+			}
+
+			area = mem_pool_alloc_low(n, pool);
+
+			if (area == NULL) {
+
+				break;
+			}
+
+			UT_LIST_ADD_FIRST(free_list, cache->free_list[n],
+					  area);
+			cache->size += ut_2_exp(n);
+		}
+
+		mem_n_threads_inside--;
+		mutex_exit(&(pool->mutex));
+
+		cache->n_refills++;
+
+		area = UT_LIST_GET_FIRST(cache->free_list[n]);
+
+		if (area == NULL) {
+			os_fast_mutex_unlock(&cache->mutex);
+
+			return(NULL);
+		}
+	}
+
+	UT_LIST_REMOVE(free_list, cache->free_list[n], area);
+	cache->size -= ut_2_exp(n);
+
+	os_fast_mutex_unlock(&cache->mutex);
+
+	return(area);
+}
+
+/************************************************************************
+Allocates memory from a pool. NOTE: This low-level function should only be
+used in mem0mem.*! */
+UNIV_INTERN
+void*
+mem_area_alloc(
+/*===========*/
+				/* out, own: allocated memory buffer */
+	ulint*		psize,	/* in: requested size in bytes; for optimum
+				space usage, the size should be a power of 2
+				minus MEM_AREA_EXTRA_SIZE;
+				out: allocated size in bytes (greater than
+				or equal to the requested size) */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	mem_area_t*	area	= NULL;
+	ulint		size;
+	ulint		n;
+
+	size = *psize;
+	n = ut_2_log(ut_max(size + MEM_AREA_EXTRA_SIZE, MEM_AREA_MIN_SIZE));
+
+	if (n <= MEM_CACHE_MAX_CLASS) {
+		area = mem_cache_alloc(n, pool);
+	}
+
+	if (area == NULL) {
+		mutex_enter(&(pool->mutex));
+		mem_n_threads_inside++;
+
+		ut_a(mem_n_threads_inside == 1);
+
+		area = mem_pool_alloc_low(n, pool);
+
+		mem_n_threads_inside--;
+		mutex_exit(&(pool->mutex));
+
+		if (area == NULL) {
+			/* Out of memory in memory pool: we try to allocate
+			from the operating system with the regular malloc: */
+
+			return(ut_malloc(size));
+		}
+	}
 
 	ut_ad(mem_pool_validate(pool));
 
@@ -454,6 +701,129 @@ mem_area_get_buddy(
 	return(buddy);
 }
 
+/************************************************************************
+Puts an area to the free lists of a pool, merging it with its free
+buddies. The caller must own the pool mutex. */
+static
+void
+mem_pool_free_low(
+/*==============*/
+	mem_area_t*	area,	/* in, own: area which is not free */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	mem_area_t*	buddy;
+	ulint		size;
+	ulint		n;
+
+	ut_ad(mutex_own(&(pool->mutex)));
+
+	for (;;) {
+		size = mem_area_get_size(area);
+		buddy = mem_area_get_buddy(area, size, pool);
+		n = ut_2_log(size);
+
+		if (!buddy || !mem_area_get_free(buddy)
+		    || size != mem_area_get_size(buddy)) {
+
+			break;
+		}
+
+		/* The buddy is in a free list: remove it from there and
+		merge it to area */
+
+		if ((byte*)buddy < (byte*)area) {
+			area = buddy;
+
+			mem_area_set_free(area, FALSE);
+		}
+
+		mem_area_set_size(area, 2 * size);
+
+		UT_LIST_REMOVE(free_list, pool->free_list[n], buddy);
+
+		pool->reserved += ut_2_exp(n);
+
+		UNIV_MEM_FREE(MEM_AREA_EXTRA_SIZE + (byte*) area,
+			      2 * size - MEM_AREA_EXTRA_SIZE);
+	}
+
+	UT_LIST_ADD_FIRST(free_list, pool->free_list[n], area);
+
+	mem_area_set_free(area, TRUE);
+
+	ut_ad(pool->reserved >= size);
+
+	pool->reserved -= size;
+}
+
+/************************************************************************
+Puts an area to the cache of the current thread. If the cache grows
+beyond its maximum size, returns a batch of its areas to the pool. */
+static
+ibool
+mem_cache_free(
+/*===========*/
+				/* out: TRUE if the area was cached,
+				FALSE if the cache is in use by another
+				thread or the caches have been freed */
+	mem_area_t*	area,	/* in, own: area */
+	ulint		n,	/* in: 2-logarithm of the area size */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	mem_cache_t*	cache;
+	mem_area_t*	victim;
+	ulint		i;
+
+	if (UNIV_UNLIKELY(pool->caches == NULL)) {
+		/* mem_close() has been called: return the area to
+		the pool */
+
+		return(FALSE);
+	}
+
+	cache = mem_pool_get_cache(pool);
+
+	if (os_fast_mutex_trylock(&cache->mutex)) {
+
+		return(FALSE);
+	}
+
+	UT_LIST_ADD_FIRST(free_list, cache->free_list[n], area);
+	cache->size += ut_2_exp(n);
+
+	if (cache->size > pool->cache_max_size) {
+		/* Return the least recently cached areas, the biggest
+		first, until the cache is half empty */
+
+		mutex_enter(&(pool->mutex));
+		mem_n_threads_inside++;
+
+		ut_a(mem_n_threads_inside == 1);
+
+		for (i = MEM_CACHE_MAX_CLASS + 1; i-- > 0; ) {
+			while (cache->size > pool->cache_max_size / 2
+			       && (victim = UT_LIST_GET_LAST(
+					   cache->free_list[i])) != NULL) {
+
+				UT_LIST_REMOVE(free_list,
+					       cache->free_list[i], victim);
+				cache->size -= ut_2_exp(i);
+
+				mem_pool_free_low(victim, pool);
+			}
+		}
+
+		mem_n_threads_inside--;
+		mutex_exit(&(pool->mutex));
+
+		cache->n_flushes++;
+	}
+
+	os_fast_mutex_unlock(&cache->mutex);
+
+	return(TRUE);
+}
+
 /************************************************************************
 Frees memory to a pool. */
 UNIV_INTERN
@@ -465,8 +835,6 @@ mem_area_free(
 	mem_pool_t*	pool)	/* in: memory pool */
 {
 	mem_area_t*	area;
-	mem_area_t*	buddy;
-	void*		new_ptr;
 	ulint		size;
 	ulint		n;
 
@@ -524,52 +892,19 @@ mem_area_free(
 		}
 	}
 #endif
-	buddy = mem_area_get_buddy(area, size, pool);
-
 	n = ut_2_log(size);
 
-	mutex_enter(&(pool->mutex));
-	mem_n_threads_inside++;
-
-	ut_a(mem_n_threads_inside == 1);
-
-	if (buddy && mem_area_get_free(buddy)
-	    && (size == mem_area_get_size(buddy))) {
-
-		/* The buddy is in a free list */
-
-		if ((byte*)buddy < (byte*)area) {
-			new_ptr = ((byte*)buddy) + MEM_AREA_EXTRA_SIZE;
-
-			mem_area_set_size(buddy, 2 * size);
-			mem_area_set_free(buddy, FALSE);
-		} else {
-			new_ptr = ptr;
-
-			mem_area_set_size(area, 2 * size);
-		}
-
-		/* Remove the buddy from its free list and merge it to area */
-
-		UT_LIST_REMOVE(free_list, pool->free_list[n], buddy);
-
-		pool->reserved += ut_2_exp(n);
-
-		mem_n_threads_inside--;
-		mutex_exit(&(pool->mutex));
-
-		mem_area_free(new_ptr, pool);
+	if (n <= MEM_CACHE_MAX_CLASS && mem_cache_free(area, n, pool)) {
 
 		return;
-	} else {
-		UT_LIST_ADD_FIRST(free_list, pool->free_list[n], area);
+	}
 
-		mem_area_set_free(area, TRUE);
+	mutex_enter(&(pool->mutex));
+	mem_n_threads_inside++;
 
-		ut_ad(pool->reserved >= size);
+	ut_a(mem_n_threads_inside == 1);
 
-		pool->reserved -= size;
-	}
+	mem_pool_free_low(area, pool);
 
 	mem_n_threads_inside--;
 	mutex_exit(&(pool->mutex));
@@ -623,6 +958,86 @@ mem_pool_validate(
 	return(TRUE);
 }
 
+/************************************************************************
+Sums up the counters of the area caches of a pool. The caches are not
+latched: the sums are only approximate while the caches are in use. */
+static
+ulint
+mem_pool_get_cache_info(
+/*====================*/
+				/* out: total size of the cached areas */
+	mem_pool_t*	pool,	/* in: memory pool */
+	ulint*		n_hits,	/* out: allocations served by the caches,
+				or NULL */
+	ulint*		n_misses,/* out: allocations which found a cache
+				empty, or NULL */
+	ulint*		n_refills,/* out: batches taken from the pool,
+				or NULL */
+	ulint*		n_flushes)/* out: batches returned to the pool,
+				or NULL */
+{
+	ulint	size	= 0;
+	ulint	hits	= 0;
+	ulint	misses	= 0;
+	ulint	refills	= 0;
+	ulint	flushes	= 0;
+	ulint	i;
+
+	for (i = 0; pool->caches && i < MEM_POOL_N_CACHES; i++) {
+		const mem_cache_t*	cache = &pool->caches[i];
+
+		size += cache->size;
+		hits += cache->n_hits;
+		misses += cache->n_misses;
+		refills += cache->n_refills;
+		flushes += cache->n_flushes;
+	}
+
+	if (n_hits) {
+		*n_hits = hits;
+	}
+
+	if (n_misses) {
+		*n_misses = misses;
+	}
+
+	if (n_refills) {
+		*n_refills = refills;
+	}
+
+	if (n_flushes) {
+		*n_flushes = flushes;
+	}
+
+	return(size);
+}
+
+/************************************************************************
+Prints info of the area caches of a memory pool. */
+static
+void
+mem_pool_print_cache_info(
+/*======================*/
+	FILE*		outfile,/* in: output file to write to */
+	mem_pool_t*	pool)	/* in: memory pool */
+{
+	ulint	size;
+	ulint	n_hits;
+	ulint	n_misses;
+	ulint	n_refills;
+	ulint	n_flushes;
+
+	size = mem_pool_get_cache_info(pool, &n_hits, &n_misses,
+				       &n_refills, &n_flushes);
+
+	fprintf(outfile,
+		"Thread caches %lu, max size %lu each, cached %lu;"
+		" hits %lu, misses %lu, refills %lu, flushes %lu\n",
+		(ulong) MEM_POOL_N_CACHES, (ulong) pool->cache_max_size,
+		(ulong) size, (ulong) n_hits, (ulong) n_misses,
+		(ulong) n_refills, (ulong) n_flushes);
+}
+
 /************************************************************************
 Prints info of a memory pool. */
 UNIV_INTERN
@@ -654,6 +1069,8 @@ mem_pool_print_info(
 	fprintf(outfile, "Pool size %lu, reserved %lu.\n", (ulong) pool->size,
 		(ulong) pool->reserved);
 	mutex_exit(&(pool->mutex));
+
+	mem_pool_print_cache_info(outfile, pool);
 }
 
 /************************************************************************
@@ -673,5 +1090,10 @@ mem_pool_get_reserved(
 
 	mutex_exit(&(pool->mutex));
 
+	/* The cached areas are not in use */
+
+	reserved -= ut_min(reserved, mem_pool_get_cache_info(
+				   pool, NULL, NULL, NULL, NULL));
+
 	return(reserved);
 }
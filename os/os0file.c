@@ -1348,10 +1348,13 @@ try_again:
 
 	*success = TRUE;
 
-	/* We disable OS caching (O_DIRECT) only on data files */
-	if (type != OS_LOG_FILE
-	    && srv_unix_file_flush_method == SRV_UNIX_O_DIRECT) {
-		
+	/* We disable OS caching (O_DIRECT) on data files, and with
+	ALL_O_DIRECT also on log files: the log is always written and read
+	in whole OS_FILE_LOG_BLOCK_SIZE blocks from aligned buffers */
+	if (srv_unix_file_flush_method == SRV_UNIX_ALL_O_DIRECT
+	    || (type != OS_LOG_FILE
+		&& srv_unix_file_flush_method == SRV_UNIX_O_DIRECT)) {
+
 		os_file_set_nocache(file, name, mode_str);
 	}
 
@@ -1695,6 +1698,80 @@ os_file_get_size_as_iblonglong(
 	return((((ib_longlong)size_high) << 32) + (ib_longlong)size);
 }
 
+/***************************************************************************
+Checks if writes to a file bypass the file cache of the operating system,
+that is, if the file was opened with O_DIRECT or FILE_FLAG_NO_BUFFERING.
+Only then does a page write reach the device as one request. */
+UNIV_INTERN
+ibool
+os_file_is_unbuffered(
+/*==================*/
+				/* out: TRUE if the file is known to be
+				unbuffered */
+	os_file_t	file)	/* in: handle to a file */
+{
+#ifdef __WIN__
+	UT_NOT_USED(file);
+# ifdef UNIV_NON_BUFFERED_IO
+	return(srv_win_file_flush_method == SRV_WIN_IO_UNBUFFERED);
+# else
+	return(FALSE);
+# endif
+#elif defined(O_DIRECT)
+	int	flags;
+
+	flags = fcntl(file, F_GETFL);
+
+	return(flags != -1 && (flags & O_DIRECT));
+#else
+	/* We cannot tell whether directio() succeeded on Solaris */
+	UT_NOT_USED(file);
+
+	return(FALSE);
+#endif
+}
+
+/***************************************************************************
+Reserves disk space for a region of a file with posix_fallocate(), without
+writing to it; the region reads as zeros. */
+UNIV_INTERN
+ibool
+os_file_allocate(
+/*=============*/
+				/* out: TRUE if success; FALSE if the
+				operating system or file system cannot do
+				this or there is no space: the caller should
+				then write zeros to the file */
+	os_file_t	file,	/* in: handle to a file */
+	ulint		offset,	/* in: least significant 32 bits of the
+				file offset where the region starts */
+	ulint		offset_high,/* in: most significant 32 bits of
+				offset */
+	ulint		len)	/* in: length of the region in bytes */
+{
+#if defined(HAVE_POSIX_FALLOCATE) && !defined(__WIN__)
+	off_t	offs;
+
+	if (sizeof(off_t) <= 4 && offset_high > 0) {
+
+		return(FALSE);
+	}
+
+	/* If off_t is > 4 bytes in size, then we assume we can pass a
+	64-bit address */
+	offs = (off_t)offset + (((off_t)offset_high) << 32);
+
+	return(posix_fallocate(file, offs, (off_t) len) == 0);
+#else
+	UT_NOT_USED(file);
+	UT_NOT_USED(offset);
+	UT_NOT_USED(offset_high);
+	UT_NOT_USED(len);
+
+	return(FALSE);
+#endif
+}
+
 /***************************************************************************
 Write the specified number of zeros to a newly created file. */
 UNIV_INTERN
@@ -190,6 +190,107 @@ page_cur_rec_field_extends(
 }
 #endif /* PAGE_CUR_LE_OR_EXTENDS */
 
+/********************************************************************
+Determines if the first field of a search tuple can be compared to the
+records of an index page with memcmp() at a fixed position.  This is
+the case when the first index field is a fixed-length NOT NULL column
+of a type whose values are ordered bytewise, such as an integer, a
+system column or a fixed-length binary string. */
+UNIV_INLINE
+ulint
+page_cur_get_memcmp_len(
+/*====================*/
+					/* out: length of the first field,
+					or 0 if the field must be compared
+					with cmp_dtuple_rec_with_match() */
+	const dict_index_t*	index,	/* in: record descriptor */
+	const dtuple_t*		tuple)	/* in: data tuple */
+{
+	const dict_field_t*	field;
+
+	if (!index->n_fixed_prefix
+	    || !dict_table_is_comp(index->table)
+	    || !dtuple_get_n_fields_cmp(tuple)
+	    || (dtuple_get_info_bits(tuple) & REC_INFO_MIN_REC_FLAG)) {
+
+		return(0);
+	}
+
+	field = dict_index_get_nth_field(index, 0);
+
+	switch (dict_field_get_col(field)->mtype) {
+	case DATA_FIXBINARY:
+	case DATA_INT:
+	case DATA_SYS:
+		break;
+	default:
+		return(0);
+	}
+
+	if (dfield_get_len(dtuple_get_nth_field(tuple, 0))
+	    != field->fixed_len) {
+
+		return(0);
+	}
+
+	return(field->fixed_len);
+}
+
+/********************************************************************
+Compares the first field of a data tuple to the first field of a
+ROW_FORMAT=COMPACT record with memcmp().  The field starts at the
+record origin, so that rec_get_offsets() need not be called for the
+records that differ from the tuple already in the first field.  The
+matched fields and bytes are updated in the same way as
+cmp_dtuple_rec_with_match() would update them. */
+UNIV_INLINE
+int
+page_cur_cmp_first_field(
+/*=====================*/
+				/* out: 1 or -1 if the tuple is greater
+				or less than rec in the first field;
+				0 if the first fields are equal, in which
+				case *matched_fields is set to 1, or if
+				rec is the predefined minimum record */
+	const dtuple_t*	tuple,	/* in: data tuple */
+	const rec_t*	rec,	/* in: user record */
+	ulint		len,	/* in: page_cur_get_memcmp_len() */
+	ulint*		matched_fields,	/* in/out: number of already
+				completely matched fields; must be 0 */
+	ulint*		matched_bytes)	/* in/out: number of already
+				matched bytes in the first field */
+{
+	const byte*	data;
+	ulint		i;
+
+	ut_ad(*matched_fields == 0);
+	ut_ad(*matched_bytes < len);
+
+	if (UNIV_UNLIKELY(rec_get_info_bits(rec, TRUE)
+			  & REC_INFO_MIN_REC_FLAG)) {
+
+		return(0);
+	}
+
+	data = dfield_get_data(dtuple_get_nth_field(tuple, 0));
+	i = *matched_bytes;
+
+	if (!memcmp(data + i, rec + i, len - i)) {
+		*matched_fields = 1;
+		*matched_bytes = 0;
+
+		return(0);
+	}
+
+	while (data[i] == rec[i]) {
+		i++;
+	}
+
+	*matched_bytes = i;
+
+	return(data[i] > rec[i] ? 1 : -1);
+}
+
 /********************************************************************
 Searches the right position for a page cursor. */
 UNIV_INTERN
@@ -233,6 +334,7 @@ page_cur_search_with_match(
 	ulint		cur_matched_fields;
 	ulint		cur_matched_bytes;
 	int		cmp;
+	ulint		memcmp_len;
 #ifdef UNIV_SEARCH_DEBUG
 	int		dbg_cmp;
 	ulint		dbg_matched_fields;
@@ -305,6 +407,11 @@ page_cur_search_with_match(
 	low_matched_fields = *ilow_matched_fields;
 	low_matched_bytes  = *ilow_matched_bytes;
 
+	/* Until the first field has been matched completely, decide the
+	order by comparing it in place whenever possible. */
+
+	memcmp_len = page_cur_get_memcmp_len(index, tuple);
+
 	/* Perform binary search. First the search is done through the page
 	directory, after that as a linear search in the list of records
 	owned by the upper limit directory slot. */
@@ -324,13 +431,24 @@ page_cur_search_with_match(
 			    low_matched_fields, low_matched_bytes,
 			    up_matched_fields, up_matched_bytes);
 
-		offsets = rec_get_offsets(mid_rec, index, offsets,
-					  dtuple_get_n_fields_cmp(tuple),
-					  &heap);
+		cmp = 0;
+
+		if (memcmp_len && !cur_matched_fields) {
+			cmp = page_cur_cmp_first_field(tuple, mid_rec,
+						       memcmp_len,
+						       &cur_matched_fields,
+						       &cur_matched_bytes);
+		}
+
+		if (!cmp) {
+			offsets = rec_get_offsets(
+				mid_rec, index, offsets,
+				dtuple_get_n_fields_cmp(tuple), &heap);
 
-		cmp = cmp_dtuple_rec_with_match(tuple, mid_rec, offsets,
-						&cur_matched_fields,
-						&cur_matched_bytes);
+			cmp = cmp_dtuple_rec_with_match(
+				tuple, mid_rec, offsets,
+				&cur_matched_fields, &cur_matched_bytes);
+		}
 		if (UNIV_LIKELY(cmp > 0)) {
 low_slot_match:
 			low = mid;
@@ -381,13 +499,24 @@ up_slot_match:
 			    low_matched_fields, low_matched_bytes,
 			    up_matched_fields, up_matched_bytes);
 
-		offsets = rec_get_offsets(mid_rec, index, offsets,
-					  dtuple_get_n_fields_cmp(tuple),
-					  &heap);
+		cmp = 0;
 
-		cmp = cmp_dtuple_rec_with_match(tuple, mid_rec, offsets,
-						&cur_matched_fields,
-						&cur_matched_bytes);
+		if (memcmp_len && !cur_matched_fields) {
+			cmp = page_cur_cmp_first_field(tuple, mid_rec,
+						       memcmp_len,
+						       &cur_matched_fields,
+						       &cur_matched_bytes);
+		}
+
+		if (!cmp) {
+			offsets = rec_get_offsets(
+				mid_rec, index, offsets,
+				dtuple_get_n_fields_cmp(tuple), &heap);
+
+			cmp = cmp_dtuple_rec_with_match(
+				tuple, mid_rec, offsets,
+				&cur_matched_fields, &cur_matched_bytes);
+		}
 		if (UNIV_LIKELY(cmp > 0)) {
 low_rec_match:
 			low_rec = mid_rec;
@@ -1658,6 +1787,73 @@ page_copy_rec_list_end_to_created_page(
 	mtr_set_log_mode(mtr, log_mode);
 }
 
+/*************************************************************
+Writes the log for the records of a newly created page that were appended
+to it one by one with page_cur_insert_rec_low() while logging was switched
+off. The log is that of page_copy_rec_list_end_to_created_page(): in
+recovery the records are appended to the created page in the same order,
+which rebuilds the page exactly, and PAGE_LAST_INSERT, PAGE_DIRECTION and
+PAGE_N_DIRECTION are reset; the caller must reset them on the page. */
+UNIV_INTERN
+void
+page_cur_log_appended_recs(
+/*=======================*/
+	page_t*		page,	/* in: index page */
+	dict_index_t*	index,	/* in: record descriptor */
+	mtr_t*		mtr)	/* in: mtr */
+{
+	rec_t*		prev_rec;
+	rec_t*		rec;
+	ulint		log_mode;
+	byte*		log_ptr;
+	ulint		log_data_len;
+	mem_heap_t*	heap		= NULL;
+	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+	ulint*		offsets		= offsets_;
+	rec_offs_init(offsets_);
+
+	prev_rec = page_get_infimum_rec(page);
+	rec = page_rec_get_next(prev_rec);
+
+	if (page_rec_is_supremum(rec)) {
+
+		return;
+	}
+
+	log_ptr = page_copy_rec_list_to_created_page_write_log(page,
+							       index, mtr);
+	if (UNIV_UNLIKELY(log_ptr == NULL)) {
+
+		return;
+	}
+
+	log_data_len = dyn_array_get_data_size(&(mtr->log));
+
+	log_mode = mtr_set_log_mode(mtr, MTR_LOG_SHORT_INSERTS);
+
+	do {
+		offsets = rec_get_offsets(rec, index, offsets,
+					  ULINT_UNDEFINED, &heap);
+
+		page_cur_insert_rec_write_log(rec, rec_offs_size(offsets),
+					      prev_rec, index, mtr);
+		prev_rec = rec;
+		rec = page_rec_get_next(rec);
+	} while (!page_rec_is_supremum(rec));
+
+	mtr_set_log_mode(mtr, log_mode);
+
+	if (UNIV_LIKELY_NULL(heap)) {
+		mem_heap_free(heap);
+	}
+
+	log_data_len = dyn_array_get_data_size(&(mtr->log)) - log_data_len;
+
+	ut_a(log_data_len < 100 * UNIV_PAGE_SIZE);
+
+	mach_write_to_4(log_ptr, log_data_len);
+}
+
 /***************************************************************
 Writes log record of a record delete on a page. */
 UNIV_INLINE
@@ -259,6 +259,15 @@ cmp_whole_field(
 		/* fall through */
 	case DATA_VARMYSQL:
 	case DATA_MYSQL:
+		/* Identical strings are equal in every collation.  This
+		is common in searches for existing keys and in duplicate
+		checks, and it is much cheaper than calling MySQL. */
+
+		if (a_length == b_length && !memcmp(a, b, a_length)) {
+
+			return(0);
+		}
+
 		return(innobase_mysql_cmp(
 			       (int)(prtype & DATA_MYSQL_TYPE_MASK),
 			       (uint)dtype_get_charset_coll(prtype),
@@ -211,6 +211,33 @@ rec_get_n_extern_new(
 	return(n_extern);
 }
 
+/**********************************************************
+Copies the precomputed end offsets of the leading fixed-length
+NOT NULL fields of a ROW_FORMAT=COMPACT index to offsets[].  These
+fields take no null flag and no length byte in the record header. */
+static
+ulint
+rec_init_offsets_fixed(
+/*===================*/
+					/* out: number of fields
+					initialized */
+	const dict_index_t*	index,	/* in: record descriptor */
+	ulint*			offsets,/* in/out: array of offsets */
+	ulint			n)	/* in: maximum number of fields
+					to initialize */
+{
+	if (n > index->n_fixed_prefix) {
+		n = index->n_fixed_prefix;
+	}
+
+	if (n) {
+		memcpy(rec_offs_base(offsets) + 1, index->fixed_offs,
+		       n * sizeof *offsets);
+	}
+
+	return(n);
+}
+
 /**********************************************************
 Determine the offset to each field in a leaf-page record
 in ROW_FORMAT=COMPACT.  This is a special case of
@@ -229,7 +256,7 @@ rec_init_offsets_comp_ordinary(
 	ulint*			offsets)/* in/out: array of offsets;
 					in: n=rec_offs_n_fields(offsets) */
 {
-	ulint		i		= 0;
+	ulint		i;
 	ulint		offs		= 0;
 	ulint		any_ext		= 0;
 	const byte*	nulls		= rec - (extra + 1);
@@ -246,8 +273,14 @@ rec_init_offsets_comp_ordinary(
 	offsets[3] = (ulint) index;
 #endif /* UNIV_DEBUG */
 
-	/* read the lengths of fields 0..n */
-	do {
+	i = rec_init_offsets_fixed(index, offsets,
+				   rec_offs_n_fields(offsets));
+	if (i) {
+		offs = rec_offs_base(offsets)[i];
+	}
+
+	/* read the lengths of fields i..n */
+	for (; i < rec_offs_n_fields(offsets); i++) {
 		ulint	len;
 
 		field = dict_index_get_nth_field(index, i);
@@ -307,7 +340,7 @@ rec_init_offsets_comp_ordinary(
 		}
 resolved:
 		rec_offs_base(offsets)[i + 1] = len;
-	} while (++i < rec_offs_n_fields(offsets));
+	}
 
 	*rec_offs_base(offsets)
 		= (rec - (lens + 1)) | REC_OFFS_COMPACT | any_ext;
@@ -373,8 +406,15 @@ rec_init_offsets(
 		offs = 0;
 		null_mask = 1;
 
-		/* read the lengths of fields 0..n */
-		do {
+		i = rec_init_offsets_fixed(index, offsets,
+					   ut_min(n_node_ptr_field,
+						  rec_offs_n_fields(offsets)));
+		if (i) {
+			offs = rec_offs_base(offsets)[i];
+		}
+
+		/* read the lengths of fields i..n */
+		for (; i < rec_offs_n_fields(offsets); i++) {
 			ulint	len;
 			if (UNIV_UNLIKELY(i == n_node_ptr_field)) {
 				len = offs += 4;
@@ -435,7 +475,7 @@ rec_init_offsets(
 			}
 resolved:
 			rec_offs_base(offsets)[i + 1] = len;
-		} while (++i < rec_offs_n_fields(offsets));
+		}
 
 		*rec_offs_base(offsets)
 			= (rec - (lens + 1)) | REC_OFFS_COMPACT;
@@ -19,6 +19,7 @@ Completed by Sunny Bains and Marko Makela
 #include "dict0crea.h"
 #include "dict0load.h"
 #include "btr0btr.h"
+#include "page0zip.h"
 #include "mach0data.h"
 #include "trx0rseg.h"
 #include "trx0trx.h"
@@ -1525,7 +1526,9 @@ row_merge_copy_blobs(
 
 /************************************************************************
 Read sorted file containing index data tuples and insert these data
-tuples to the index */
+tuples to the index. The tuples of a secondary index are loaded to the
+empty tree bottom-up with btr_bulk_insert(), as long as they can be
+stored on the page entirely; the rest are inserted one by one. */
 static
 ulint
 row_merge_insert_index_tuples(
@@ -1545,6 +1548,7 @@ row_merge_insert_index_tuples(
 	ins_node_t*		node;
 	mem_heap_t*		tuple_heap;
 	mem_heap_t*		graph_heap;
+	btr_bulk_t*		bulk = NULL;
 	ulint			error = DB_SUCCESS;
 	ulint			foffs = 0;
 	ulint*			offsets;
@@ -1577,6 +1581,10 @@ row_merge_insert_index_tuples(
 
 	b = *block;
 
+	if (!dict_index_is_clust(index)) {
+		bulk = btr_bulk_create(index, trx->id);
+	}
+
 	if (!row_merge_read(fd, foffs, block)) {
 		error = DB_CORRUPTION;
 	} else {
@@ -1603,12 +1611,41 @@ row_merge_insert_index_tuples(
 						     dtuple, tuple_heap);
 			}
 
+			ut_ad(dtuple_validate(dtuple));
+
+			if (bulk) {
+				if (UNIV_LIKELY(!n_ext)
+				    && !page_zip_rec_needs_ext(
+					    rec_get_converted_size(
+						    index, dtuple, 0),
+					    dict_table_is_comp(table),
+					    dict_table_zip_size(table))) {
+
+					error = btr_bulk_insert(bulk, dtuple);
+
+					if (UNIV_UNLIKELY(error
+							  != DB_SUCCESS)) {
+						break;
+					}
+
+					goto next_rec;
+				}
+
+				/* Complete the tree, and insert this and
+				the following tuples one by one */
+
+				error = btr_bulk_finish(bulk, DB_SUCCESS);
+				bulk = NULL;
+
+				if (UNIV_UNLIKELY(error != DB_SUCCESS)) {
+					break;
+				}
+			}
+
 			node->row = dtuple;
 			node->table = table;
 			node->trx_id = trx->id;
 
-			ut_ad(dtuple_validate(dtuple));
-
 			do {
 				thr->run_node = thr;
 				thr->prev_node = thr->common.parent;
@@ -1634,6 +1671,10 @@ next_rec:
 		}
 	}
 
+	if (bulk) {
+		error = btr_bulk_finish(bulk, error);
+	}
+
 	que_thr_stop_for_mysql_no_error(thr, trx);
 err_exit:
 	que_graph_free(thr->graph);
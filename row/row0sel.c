@@ -1341,7 +1341,8 @@ table_loop:
 			rw_lock_s_lock(&btr_search_latch);
 
 			search_latch_locked = TRUE;
-		} else if (btr_search_latch.writer_is_wait_ex) {
+		} else if (rw_lock_get_writer(&btr_search_latch)
+			   == RW_LOCK_WAIT_EX) {
 
 			/* There is an x-latch request waiting: release the
 			s-latch for a moment; as an s-latch here is often
@@ -3429,7 +3430,8 @@ row_search_for_mysql(
 	/* PHASE 0: Release a possible s-latch we are holding on the
 	adaptive hash index latch if there is someone waiting behind */
 
-	if (UNIV_UNLIKELY(btr_search_latch.writer != RW_LOCK_NOT_LOCKED)
+	if (UNIV_UNLIKELY(rw_lock_get_writer(&btr_search_latch)
+			  != RW_LOCK_NOT_LOCKED)
 	    && trx->has_search_latch) {
 
 		/* There is an x-latch request on the adaptive hash index:
@@ -4612,7 +4614,10 @@ row_search_check_if_query_cache_permitted(
 	dict_table_t*	table;
 	ibool		ret	= FALSE;
 
-	table = dict_table_get(norm_name, FALSE);
+	/* Increment the handle count, so that dict_table_LRU_trim()
+	cannot evict the table while we look at its locks */
+
+	table = dict_table_get(norm_name, TRUE);
 
 	if (table == NULL) {
 
@@ -4650,6 +4655,8 @@ row_search_check_if_query_cache_permitted(
 
 	mutex_exit(&kernel_mutex);
 
+	dict_table_decrement_handle_count(table, FALSE);
+
 	return(ret);
 }
 
@@ -68,6 +68,8 @@ UNIV_INTERN ulint	srv_dml_needed_delay = 0;
 
 UNIV_INTERN ibool	srv_lock_timeout_and_monitor_active = FALSE;
 UNIV_INTERN ibool	srv_error_monitor_active = FALSE;
+UNIV_INTERN ibool	srv_LRU_flusher_active = FALSE;
+UNIV_INTERN ibool	srv_preallocate_active = FALSE;
 
 UNIV_INTERN const char*	srv_main_thread_op_info = "";
 
@@ -135,6 +137,10 @@ UNIV_INTERN ulint	srv_mem_pool_size	= ULINT_MAX;
 UNIV_INTERN ulint	srv_lock_table_size	= ULINT_MAX;
 
 UNIV_INTERN ulint	srv_n_file_io_threads	= ULINT_MAX;
+/* Number of threads applying redo log records in crash recovery, see
+recv_apply_hashed_log_recs(); 1 applies them in the calling thread and
+the i/o-handler threads */
+UNIV_INTERN ulong	srv_n_recv_threads	= 4;
 
 #ifdef UNIV_LOG_ARCHIVE
 UNIV_INTERN ibool		srv_log_archive_on	= FALSE;
@@ -144,15 +150,30 @@ UNIV_INTERN ib_uint64_t	srv_archive_recovery_limit_lsn;
 
 UNIV_INTERN ulint	srv_lock_wait_timeout	= 1024 * 1024 * 1024;
 
-/* This parameter is used to throttle the number of insert buffers that are
-merged in a batch. By increasing this parameter on a faster disk you can
-possibly reduce the number of I/O operations performed to complete the
-merge operation. The value of this parameter is used as is by the
-background loop when the system is idle (low load), on a busy system
-the parameter is scaled down by a factor of 4, this is to avoid putting
-a heavier load on the I/O sub system. */
+/* Time budget of a deadlock check done when a lock wait starts, in
+microseconds; 0 means that only the step and depth limits apply */
+UNIV_INTERN ulong	srv_deadlock_check_budget_usec = 0;
+/* If TRUE, a deadlock check which exceeds its budget is finished by the
+lock timeout thread instead of rolling back the waiting transaction */
+UNIV_INTERN ibool	srv_deadlock_detect_background = FALSE;
+/* The order in which waiting record lock requests are granted:
+LOCK_SCHEDULE_FIFO, LOCK_SCHEDULE_AGE or LOCK_SCHEDULE_WEIGHT */
+UNIV_INTERN ulong	srv_lock_schedule	= 0;
 
-UNIV_INTERN ulong	srv_insert_buffer_batch_size = 20;
+/* If TRUE, the mutexes and rw-locks count their spin loops and time
+their waits, for SHOW ENGINE INNODB MUTEX; OS waits are always counted */
+UNIV_INTERN ibool	srv_latch_profiling	= FALSE;
+
+/* The number of I/O operations per second the server can perform.
+Background work, such as the insert buffer merge done by the master
+thread, is scaled by this; see PCT_IO(). */
+
+UNIV_INTERN ulong	srv_io_capacity		= 200;
+
+/* Maximum size of the insert buffer as a percentage of the buffer pool
+size; the insert buffer is contracted when it grows beyond this */
+
+UNIV_INTERN ulong	srv_ibuf_max_size_pct	= 50;
 
 UNIV_INTERN char*	srv_file_flush_method_str = NULL;
 UNIV_INTERN ulint	srv_unix_file_flush_method = SRV_UNIX_FDATASYNC;
@@ -167,6 +188,35 @@ that during a time of heavy update/insert activity. */
 
 UNIV_INTERN ulong	srv_max_buf_pool_modified_pct	= 90;
 
+/* The InnoDB main thread evicts unused tables from the data dictionary
+cache when it occupies more than this many bytes; 0 means no limit */
+
+UNIV_INTERN ulong	srv_dict_size_limit	= 0;
+
+/* Which dirty neighbors of a page are flushed along with it, one of
+BUF_FLUSH_NEIGHBORS_OFF, ..._AREA, ..._CONTIGUOUS and ..._AUTO */
+
+UNIV_INTERN ulong	srv_flush_neighbors	= 1;
+
+/* The LRU flusher thread keeps this many blocks free or replaceable in the
+free list and at the end of the LRU list, so that user threads seldom
+have to flush pages themselves to get a free block; 0 leaves the flushing
+to the user threads */
+
+UNIV_INTERN ulong	srv_LRU_scan_depth	= 1024;
+
+/* When a growing single-table tablespace is extended, a background thread
+extends its file ahead by this many extents, so that the following
+extensions do not have to write to the file; 0 disables this */
+
+UNIV_INTERN ulong	srv_preallocate_extents	= 0;
+
+/* When an index is grown by appends to its end or built from sorted
+records, this percentage of each leaf page is filled and the rest is left
+free for future updates of the records */
+
+UNIV_INTERN ulong	srv_fill_factor		= 100;
+
 /* variable counts amount of data read in total (in bytes) */
 UNIV_INTERN ulint srv_data_read = 0;
 
@@ -197,6 +247,10 @@ UNIV_INTERN ulint srv_dblwr_writes = 0;
 doublewrite buffer */
 UNIV_INTERN ulint srv_dblwr_pages_written = 0;
 
+/* here we store the number of pages of tablespaces in the atomic-write
+mode that were written without the doublewrite buffer */
+UNIV_INTERN ulint srv_dblwr_pages_skipped = 0;
+
 /* in this variable we store the number of write requests issued */
 UNIV_INTERN ulint srv_buf_pool_write_requests = 0;
 
@@ -209,6 +263,10 @@ UNIV_INTERN ulint srv_buf_pool_wait_free = 0;
 pool to the disk */
 UNIV_INTERN ulint srv_buf_pool_flushed = 0;
 
+/* variable to count the pages that were flushed because they were
+neighbors of a page picked for flushing */
+UNIV_INTERN ulint srv_buf_pool_flushed_neighbors = 0;
+
 /* variable to count the number of buffer pool reads that led to the
 reading of a disk page */
 UNIV_INTERN ulint srv_buf_pool_reads = 0;
@@ -244,36 +302,50 @@ concurrency check. */
 UNIV_INTERN ulong	srv_thread_concurrency	= 0;
 UNIV_INTERN ulong	srv_commit_concurrency	= 0;
 
-/* this mutex protects srv_conc data structures */
+/* In builds without atomic builtins, this mutex protects the srv_conc
+counters below */
 UNIV_INTERN os_fast_mutex_t	srv_conc_mutex;
 /* number of OS threads currently inside InnoDB; it is not an error if
 this drops temporarily below zero because we do not demand that every
 thread increments this, but a thread waiting for a lock decrements
 this temporarily */
-UNIV_INTERN lint	srv_conc_n_threads	= 0;
-/* number of OS threads waiting in the FIFO for a permission to enter
-InnoDB */
-UNIV_INTERN ulint	srv_conc_n_waiting_threads = 0;
-
-typedef struct srv_conc_slot_struct	srv_conc_slot_t;
-struct srv_conc_slot_struct{
-	os_event_t			event;		/* event to wait */
-	ibool				reserved;	/* TRUE if slot
-							reserved */
-	ibool				wait_ended;	/* TRUE when another
-							thread has already set
-							the event and the
-							thread in this slot is
-							free to proceed; but
-							reserved may still be
-							TRUE at that point */
-	UT_LIST_NODE_T(srv_conc_slot_t)	srv_conc_queue;	/* queue node */
-};
-
-/* queue of threads waiting to get in */
-UNIV_INTERN UT_LIST_BASE_NODE_T(srv_conc_slot_t)	srv_conc_queue;
-/* array of wait slots */
-UNIV_INTERN srv_conc_slot_t* srv_conc_slots;
+UNIV_INTERN volatile lint	srv_conc_n_threads	= 0;
+/* number of OS threads waiting for a permission to enter InnoDB */
+UNIV_INTERN volatile lint	srv_conc_n_waiting_threads = 0;
+
+/* A thread is admitted to InnoDB in the order of the tickets: it draws
+the ticket srv_conc_next_ticket and may enter when the ticket is below
+srv_conc_n_released + srv_thread_concurrency. Every thread leaving
+InnoDB increments srv_conc_n_released, and every thread entering
+without a ticket decrements it. A thread whose ticket is not yet
+admitted sleeps on the event srv_conc_events[ticket % OS_THREAD_MAX_N];
+the thread whose exit admits the ticket sets that event. Since there
+are at most OS_THREAD_MAX_N threads waiting, the event of a slot is
+normally used by one thread at a time; os_event_reset() counts make a
+shared slot merely cause extra wakeups. */
+static volatile lint	srv_conc_next_ticket	= 0;
+static volatile lint	srv_conc_n_released	= 0;
+/* array of OS_THREAD_MAX_N wait events */
+static os_event_t*	srv_conc_events;
+
+/* With SRV_CONC_POLICY_TRX, the threads of started transactions wait for
+a slot outside of the ticket order: a thread leaving InnoDB hands its
+slot directly over to one of them. srv_conc_n_prio_waiting is the number
+of such threads which have not yet been handed a slot, and
+srv_conc_n_prio_grants the number of slots handed over but not yet
+taken. The waiting threads sleep on srv_conc_prio_event. */
+static volatile lint	srv_conc_n_prio_waiting	= 0;
+static volatile lint	srv_conc_n_prio_grants	= 0;
+static os_event_t	srv_conc_prio_event;
+
+/* The admission policy: SRV_CONC_POLICY_FIFO or SRV_CONC_POLICY_TRX */
+UNIV_INTERN ulong	srv_conc_policy		= SRV_CONC_POLICY_FIFO;
+
+/* Statistics of the admission waits */
+static volatile lint	srv_conc_n_waits	= 0;
+static volatile lint	srv_conc_n_prio_admissions = 0;
+static lint		srv_conc_max_waiting	= 0;
+static volatile ullint	srv_conc_wait_time	= 0; /* in microseconds */
 
 /* Number of times a thread is allowed to enter InnoDB within the same
 SQL query after it has once got the ticket at srv_conc_enter_innodb */
@@ -293,6 +365,16 @@ UNIV_INTERN ibool	srv_stats_on_metadata	= TRUE;
 
 UNIV_INTERN ibool	srv_use_doublewrite_buf	= TRUE;
 UNIV_INTERN ibool	srv_use_checksums = TRUE;
+/* If TRUE, the user declares that the storage of the data files writes
+a page atomically; the pages of tablespaces whose files are opened
+unbuffered are then written without the doublewrite buffer, see
+fil_space_get_atomic_writes() */
+UNIV_INTERN ibool	srv_use_atomic_writes = FALSE;
+
+/* If TRUE, a normal startup creates the single-table tablespace objects
+from SYS_TABLES without opening the .ibd files, see
+dict_check_tablespaces_and_store_max_id() */
+UNIV_INTERN ibool	srv_lazy_open_tablespaces = FALSE;
 
 UNIV_INTERN ibool	srv_set_thread_priorities = TRUE;
 UNIV_INTERN int	srv_query_thread_priority = 0;
@@ -304,6 +386,8 @@ UNIV_INTERN ulong	srv_n_spin_wait_rounds	= 20;
 UNIV_INTERN ulong	srv_n_free_tickets_to_enter = 500;
 UNIV_INTERN ulong	srv_thread_sleep_delay = 10000;
 UNIV_INTERN ulint	srv_spin_wait_delay	= 5;
+/* Number of primary sync wait arrays, see sync_array_init() */
+UNIV_INTERN ulong	srv_sync_array_size	= 1;
 UNIV_INTERN ibool	srv_priority_boost	= TRUE;
 
 #ifdef UNIV_DEBUG
@@ -560,6 +644,13 @@ UNIV_INTERN srv_slot_t*	srv_mysql_table = NULL;
 
 UNIV_INTERN os_event_t	srv_lock_timeout_thread_event;
 
+/* The LRU flusher thread waits for this event between its batches */
+UNIV_INTERN os_event_t	srv_LRU_flusher_event;
+
+/* The preallocation thread waits for this event when no tablespace needs
+to be extended */
+UNIV_INTERN os_event_t	srv_preallocate_event;
+
 UNIV_INTERN srv_sys_t*	srv_sys	= NULL;
 
 /* padding to prevent other memory update hotspots from residing on
@@ -819,7 +910,6 @@ void
 srv_init(void)
 /*==========*/
 {
-	srv_conc_slot_t*	conc_slot;
 	srv_slot_t*		slot;
 	dict_table_t*		table;
 	ulint			i;
@@ -852,6 +942,8 @@ srv_init(void)
 	}
 
 	srv_lock_timeout_thread_event = os_event_create(NULL);
+	srv_LRU_flusher_event = os_event_create(NULL);
+	srv_preallocate_event = os_event_create(NULL);
 
 	for (i = 0; i < SRV_MASTER + 1; i++) {
 		srv_n_threads_active[i] = 0;
@@ -896,17 +988,15 @@ srv_init(void)
 
 	os_fast_mutex_init(&srv_conc_mutex);
 
-	UT_LIST_INIT(srv_conc_queue);
-
-	srv_conc_slots = mem_alloc(OS_THREAD_MAX_N * sizeof(srv_conc_slot_t));
+	srv_conc_events = mem_alloc(OS_THREAD_MAX_N * sizeof(os_event_t));
 
 	for (i = 0; i < OS_THREAD_MAX_N; i++) {
-		conc_slot = srv_conc_slots + i;
-		conc_slot->reserved = FALSE;
-		conc_slot->event = os_event_create(NULL);
-		ut_a(conc_slot->event);
+		srv_conc_events[i] = os_event_create(NULL);
+		ut_a(srv_conc_events[i]);
 	}
 
+	srv_conc_prio_event = os_event_create(NULL);
+
 	/* Initialize some INFORMATION SCHEMA internal structures */
 	trx_i_s_cache_init(trx_i_s_cache);
 }
@@ -940,162 +1030,404 @@ srv_general_init(void)
 /* Maximum allowable purge history length.  <=0 means 'infinite'. */
 UNIV_INTERN ulong	srv_max_purge_lag		= 0;
 
+#ifdef HAVE_GCC_ATOMIC_BUILTINS
+# define srv_conc_add(ptr, amount)	os_atomic_increment(ptr, amount)
+# define srv_conc_cas(ptr, old_val, new_val)	\
+	os_compare_and_swap(ptr, old_val, new_val)
+#else /* HAVE_GCC_ATOMIC_BUILTINS */
 /*************************************************************************
-Puts an OS thread to wait if there are too many concurrent threads
-(>= srv_thread_concurrency) inside InnoDB. The threads wait in a FIFO queue. */
-UNIV_INTERN
-void
-srv_conc_enter_innodb(
-/*==================*/
-	trx_t*	trx)	/* in: transaction object associated with the
-			thread */
+Adds amount to a srv_conc counter. */
+static
+lint
+srv_conc_add(
+/*=========*/
+					/* out: the resulting value */
+	volatile lint*	ptr,		/* in/out: counter */
+	lint		amount)		/* in: amount to add */
 {
-	ibool			has_slept = FALSE;
-	srv_conc_slot_t*	slot	  = NULL;
-	ulint			i;
+	lint	val;
 
-	if (trx->mysql_thd != NULL
-	    && thd_is_replication_slave_thread(trx->mysql_thd)) {
+	os_fast_mutex_lock(&srv_conc_mutex);
+	val = *ptr += amount;
+	os_fast_mutex_unlock(&srv_conc_mutex);
 
-		UT_WAIT_FOR(srv_conc_n_threads
-			    < (lint)srv_thread_concurrency,
-			    srv_replication_delay * 1000);
+	return(val);
+}
 
-		return;
+/*************************************************************************
+Sets a srv_conc counter to new_val if it equals old_val. */
+static
+ibool
+srv_conc_cas(
+/*=========*/
+					/* out: TRUE if the counter was set */
+	volatile lint*	ptr,		/* in/out: counter */
+	lint		old_val,	/* in: expected value */
+	lint		new_val)	/* in: value to set */
+{
+	ibool	success;
+
+	os_fast_mutex_lock(&srv_conc_mutex);
+	success = *ptr == old_val;
+
+	if (success) {
+		*ptr = new_val;
 	}
 
-	/* If trx has 'free tickets' to enter the engine left, then use one
-	such ticket */
+	os_fast_mutex_unlock(&srv_conc_mutex);
 
-	if (trx->n_tickets_to_enter_innodb > 0) {
-		trx->n_tickets_to_enter_innodb--;
+	return(success);
+}
+#endif /* HAVE_GCC_ATOMIC_BUILTINS */
 
-		return;
+/*************************************************************************
+Checks if a newly drawn ticket would have to wait. */
+UNIV_INLINE
+ibool
+srv_conc_is_full(void)
+/*==================*/
+			/* out: TRUE if srv_thread_concurrency threads
+			are inside InnoDB or admitted to it */
+{
+	return(srv_conc_next_ticket - srv_conc_n_released
+	       >= (lint) srv_thread_concurrency);
+}
+
+/*************************************************************************
+Checks if the holder of a ticket may enter InnoDB. */
+UNIV_INLINE
+ibool
+srv_conc_ticket_admitted(
+/*=====================*/
+			/* out: TRUE if admitted */
+	lint	ticket)	/* in: ticket drawn in srv_conc_enter_innodb() */
+{
+	return(ticket - srv_conc_n_released < (lint) srv_thread_concurrency);
+}
+
+/*************************************************************************
+Prepares a thread for waiting for admission to InnoDB. */
+static
+ullint
+srv_conc_wait_begin(
+/*================*/
+			/* out: start time of the wait */
+	trx_t*	trx)	/* in: transaction of the waiting thread */
+{
+	lint	n_waiting;
+
+	/* Release possible search system latch this thread has */
+	if (trx->has_search_latch) {
+		trx_search_latch_release_if_reserved(trx);
 	}
 
-	os_fast_mutex_lock(&srv_conc_mutex);
-retry:
-	if (trx->declared_to_be_inside_innodb) {
-		ut_print_timestamp(stderr);
-		fputs("  InnoDB: Error: trying to declare trx"
-		      " to enter InnoDB, but\n"
-		      "InnoDB: it already is declared.\n", stderr);
-		trx_print(stderr, trx, 0);
-		putc('\n', stderr);
-		os_fast_mutex_unlock(&srv_conc_mutex);
+	n_waiting = srv_conc_add(&srv_conc_n_waiting_threads, 1);
 
-		return;
+	if (n_waiting > srv_conc_max_waiting) {
+		/* A race here only loses a maximum */
+		srv_conc_max_waiting = n_waiting;
 	}
 
-	if (srv_conc_n_threads < (lint)srv_thread_concurrency) {
+	srv_conc_add(&srv_conc_n_waits, 1);
 
-		srv_conc_n_threads++;
-		trx->declared_to_be_inside_innodb = TRUE;
-		trx->n_tickets_to_enter_innodb = SRV_FREE_TICKETS_TO_ENTER;
+	return(ut_time_us(NULL));
+}
 
+/*************************************************************************
+Records the end of a wait for admission to InnoDB. */
+static
+void
+srv_conc_wait_end(
+/*==============*/
+	trx_t*	trx,		/* in: transaction of the waiting thread */
+	ullint	start_time)	/* in: value returned by
+				srv_conc_wait_begin() */
+{
+	ullint	now = ut_time_us(NULL);
+
+	trx->op_info = "";
+
+	srv_conc_add(&srv_conc_n_waiting_threads, -1);
+
+	if (now > start_time) {
+#ifdef HAVE_GCC_ATOMIC_BUILTINS
+		os_atomic_increment(&srv_conc_wait_time, now - start_time);
+#else /* HAVE_GCC_ATOMIC_BUILTINS */
+		os_fast_mutex_lock(&srv_conc_mutex);
+		srv_conc_wait_time += now - start_time;
 		os_fast_mutex_unlock(&srv_conc_mutex);
+#endif /* HAVE_GCC_ATOMIC_BUILTINS */
+	}
+}
 
-		return;
+/*************************************************************************
+Waits until a ticket is admitted to InnoDB. The thread first spins for a
+while and then sleeps on the event of the ticket. */
+static
+void
+srv_conc_wait_for_ticket(
+/*=====================*/
+	trx_t*	trx,	/* in: transaction of the waiting thread */
+	lint	ticket)	/* in: ticket drawn in srv_conc_enter_innodb() */
+{
+	os_event_t	event;
+	ib_longlong	sig_count;
+	ullint		start_time;
+	ulint		i;
+
+	event = srv_conc_events[(ulint) ticket % OS_THREAD_MAX_N];
+
+	start_time = srv_conc_wait_begin(trx);
+
+	for (i = 0; !srv_conc_ticket_admitted(ticket); i++) {
+
+		if (i < srv_n_spin_wait_rounds) {
+			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+
+			continue;
+		}
+
+		sig_count = os_event_reset(event);
+
+		/* Check again: the thread admitting the ticket may have
+		set the event before we reset it */
+
+		if (srv_conc_ticket_admitted(ticket)) {
+
+			break;
+		}
+
+		trx->op_info = "waiting in InnoDB queue";
+
+		os_event_wait_low(event, sig_count);
 	}
 
-	/* If the transaction is not holding resources, let it sleep
-	for SRV_THREAD_SLEEP_DELAY microseconds, and try again then */
+	srv_conc_wait_end(trx, start_time);
+}
 
-	if (!has_slept && !trx->has_search_latch
-	    && NULL == UT_LIST_GET_FIRST(trx->trx_locks)) {
+/*************************************************************************
+Waits until a thread leaving InnoDB hands its slot over to this thread;
+used with SRV_CONC_POLICY_TRX. If room appears in the ticket order before
+that, e.g. because srv_thread_concurrency was increased, the thread stops
+waiting and the caller must draw a ticket. */
+static
+ibool
+srv_conc_wait_for_grant(
+/*====================*/
+			/* out: TRUE if a slot was handed over, FALSE
+			if the caller must draw a ticket */
+	trx_t*	trx)	/* in: transaction of the waiting thread */
+{
+	ib_longlong	sig_count;
+	ullint		start_time;
+	lint		n;
+	ulint		i;
+	ibool		granted;
 
-		has_slept = TRUE; /* We let it sleep only once to avoid
-				  starvation */
+	/* Register before checking for room, so that a thread leaving
+	InnoDB after the check sees us */
 
-		srv_conc_n_waiting_threads++;
+	srv_conc_add(&srv_conc_n_prio_waiting, 1);
 
-		os_fast_mutex_unlock(&srv_conc_mutex);
+	start_time = srv_conc_wait_begin(trx);
 
-		trx->op_info = "sleeping before joining InnoDB queue";
+	for (i = 0;; i++) {
+		n = srv_conc_n_prio_grants;
 
-		/* Peter Zaitsev suggested that we take the sleep away
-		altogether. But the sleep may be good in pathological
-		situations of lots of thread switches. Simply put some
-		threads aside for a while to reduce the number of thread
-		switches. */
-		if (SRV_THREAD_SLEEP_DELAY > 0) {
-			os_thread_sleep(SRV_THREAD_SLEEP_DELAY);
+		if (n > 0) {
+			if (srv_conc_cas(&srv_conc_n_prio_grants, n, n - 1)) {
+				granted = TRUE;
+
+				break;
+			}
+
+			continue;
 		}
 
-		trx->op_info = "";
+		if (!srv_conc_is_full()) {
+			/* Unregister, unless a slot was handed over to
+			us in the meantime */
 
-		os_fast_mutex_lock(&srv_conc_mutex);
+			n = srv_conc_n_prio_waiting;
+
+			if (n > 0 && srv_conc_cas(&srv_conc_n_prio_waiting,
+						  n, n - 1)) {
+				granted = FALSE;
+
+				break;
+			}
 
-		srv_conc_n_waiting_threads--;
+			continue;
+		}
+
+		if (i < srv_n_spin_wait_rounds) {
+			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+
+			continue;
+		}
+
+		sig_count = os_event_reset(srv_conc_prio_event);
 
-		goto retry;
+		if (srv_conc_n_prio_grants > 0 || !srv_conc_is_full()) {
+
+			continue;
+		}
+
+		trx->op_info = "waiting in InnoDB queue";
+
+		os_event_wait_low(srv_conc_prio_event, sig_count);
 	}
 
-	/* Too many threads inside: put the current thread to a queue */
+	srv_conc_wait_end(trx, start_time);
 
-	for (i = 0; i < OS_THREAD_MAX_N; i++) {
-		slot = srv_conc_slots + i;
+	return(granted);
+}
 
-		if (!slot->reserved) {
+/*************************************************************************
+Lets the next waiting thread enter InnoDB after a thread has left it. */
+static
+void
+srv_conc_release_slot(void)
+/*=======================*/
+{
+	lint	n;
+	lint	ticket;
 
-			break;
+	/* Hand the slot over to a waiting thread of a started transaction
+	if there is one */
+
+	while ((n = srv_conc_n_prio_waiting) > 0) {
+		if (srv_conc_cas(&srv_conc_n_prio_waiting, n, n - 1)) {
+			srv_conc_add(&srv_conc_n_prio_grants, 1);
+			srv_conc_add(&srv_conc_n_prio_admissions, 1);
+
+			os_event_set(srv_conc_prio_event);
+
+			return;
 		}
 	}
 
-	if (i == OS_THREAD_MAX_N) {
-		/* Could not find a free wait slot, we must let the
-		thread enter */
+	ticket = srv_conc_add(&srv_conc_n_released, 1)
+		+ (lint) srv_thread_concurrency - 1;
 
-		srv_conc_n_threads++;
-		trx->declared_to_be_inside_innodb = TRUE;
-		trx->n_tickets_to_enter_innodb = 0;
+	/* If the ticket which was admitted now has been drawn, wake up
+	its holder */
 
-		os_fast_mutex_unlock(&srv_conc_mutex);
+	if (ticket >= 0 && ticket < srv_conc_next_ticket) {
+		os_event_set(srv_conc_events[(ulint) ticket
+					     % OS_THREAD_MAX_N]);
+	}
+}
+
+/*************************************************************************
+Wakes up all threads waiting for admission to InnoDB, so that they check
+their admission again. This must be called when srv_thread_concurrency
+is changed. */
+UNIV_INTERN
+void
+srv_conc_wake_all(void)
+/*===================*/
+{
+	ulint	i;
+
+	for (i = 0; i < OS_THREAD_MAX_N; i++) {
+		os_event_set(srv_conc_events[i]);
+	}
+
+	os_event_set(srv_conc_prio_event);
+}
+
+/*************************************************************************
+Puts an OS thread to wait if there are too many concurrent threads
+(>= srv_thread_concurrency) inside InnoDB. The threads are admitted in the
+order in which they draw tickets; with SRV_CONC_POLICY_TRX the threads of
+started transactions are admitted first. */
+UNIV_INTERN
+void
+srv_conc_enter_innodb(
+/*==================*/
+	trx_t*	trx)	/* in: transaction object associated with the
+			thread */
+{
+	lint	ticket;
+
+	if (trx->mysql_thd != NULL
+	    && thd_is_replication_slave_thread(trx->mysql_thd)) {
+
+		UT_WAIT_FOR(srv_conc_n_threads
+			    < (lint)srv_thread_concurrency,
+			    srv_replication_delay * 1000);
 
 		return;
 	}
 
-	/* Release possible search system latch this thread has */
-	if (trx->has_search_latch) {
-		trx_search_latch_release_if_reserved(trx);
+	/* If trx has 'free tickets' to enter the engine left, then use one
+	such ticket */
+
+	if (trx->n_tickets_to_enter_innodb > 0) {
+		trx->n_tickets_to_enter_innodb--;
+
+		return;
 	}
 
-	/* Add to the queue */
-	slot->reserved = TRUE;
-	slot->wait_ended = FALSE;
+	if (trx->declared_to_be_inside_innodb) {
+		ut_print_timestamp(stderr);
+		fputs("  InnoDB: Error: trying to declare trx"
+		      " to enter InnoDB, but\n"
+		      "InnoDB: it already is declared.\n", stderr);
+		trx_print(stderr, trx, 0);
+		putc('\n', stderr);
 
-	UT_LIST_ADD_LAST(srv_conc_queue, srv_conc_queue, slot);
+		return;
+	}
 
-	os_event_reset(slot->event);
+	if (srv_conc_is_full()) {
+		if (srv_conc_policy == SRV_CONC_POLICY_TRX
+		    && (trx->conc_state == TRX_ACTIVE
+			|| UT_LIST_GET_FIRST(trx->trx_locks) != NULL)) {
 
-	srv_conc_n_waiting_threads++;
+			if (srv_conc_wait_for_grant(trx)) {
 
-	os_fast_mutex_unlock(&srv_conc_mutex);
+				goto entered;
+			}
+		} else if (SRV_THREAD_SLEEP_DELAY > 0
+			   && !trx->has_search_latch
+			   && NULL == UT_LIST_GET_FIRST(trx->trx_locks)) {
 
-	/* Go to wait for the event; when a thread leaves InnoDB it will
-	release this thread */
+			/* The transaction is not holding resources: let
+			it sleep for SRV_THREAD_SLEEP_DELAY microseconds
+			before it joins the queue. Peter Zaitsev suggested
+			that we take the sleep away altogether. But the
+			sleep may be good in pathological situations of
+			lots of thread switches. Simply put some threads
+			aside for a while to reduce the number of thread
+			switches. */
 
-	trx->op_info = "waiting in InnoDB queue";
+			srv_conc_add(&srv_conc_n_waiting_threads, 1);
 
-	os_event_wait(slot->event);
+			trx->op_info = "sleeping before joining InnoDB queue";
 
-	trx->op_info = "";
+			os_thread_sleep(SRV_THREAD_SLEEP_DELAY);
 
-	os_fast_mutex_lock(&srv_conc_mutex);
+			trx->op_info = "";
 
-	srv_conc_n_waiting_threads--;
+			srv_conc_add(&srv_conc_n_waiting_threads, -1);
+		}
+	}
 
-	/* NOTE that the thread which released this thread already
-	incremented the thread counter on behalf of this thread */
+	ticket = srv_conc_add(&srv_conc_next_ticket, 1) - 1;
 
-	slot->reserved = FALSE;
+	if (!srv_conc_ticket_admitted(ticket)) {
+		/* Too many threads inside: wait until threads leaving
+		InnoDB admit the ticket */
 
-	UT_LIST_REMOVE(srv_conc_queue, srv_conc_queue, slot);
+		srv_conc_wait_for_ticket(trx, ticket);
+	}
 
+entered:
+	srv_conc_add(&srv_conc_n_threads, 1);
 	trx->declared_to_be_inside_innodb = TRUE;
 	trx->n_tickets_to_enter_innodb = SRV_FREE_TICKETS_TO_ENTER;
-
-	os_fast_mutex_unlock(&srv_conc_mutex);
 }
 
 /*************************************************************************
@@ -1113,13 +1445,14 @@ srv_conc_force_enter_innodb(
 		return;
 	}
 
-	os_fast_mutex_lock(&srv_conc_mutex);
+	/* Take a slot without a ticket: this delays the admission of
+	the tickets by one */
+
+	srv_conc_add(&srv_conc_n_released, -1);
+	srv_conc_add(&srv_conc_n_threads, 1);
 
-	srv_conc_n_threads++;
 	trx->declared_to_be_inside_innodb = TRUE;
 	trx->n_tickets_to_enter_innodb = 1;
-
-	os_fast_mutex_unlock(&srv_conc_mutex);
 }
 
 /*************************************************************************
@@ -1132,8 +1465,6 @@ srv_conc_force_exit_innodb(
 	trx_t*	trx)	/* in: transaction object associated with the
 			thread */
 {
-	srv_conc_slot_t*	slot	= NULL;
-
 	if (UNIV_LIKELY(!srv_thread_concurrency)) {
 
 		return;
@@ -1150,37 +1481,12 @@ srv_conc_force_exit_innodb(
 		return;
 	}
 
-	os_fast_mutex_lock(&srv_conc_mutex);
-
-	srv_conc_n_threads--;
 	trx->declared_to_be_inside_innodb = FALSE;
 	trx->n_tickets_to_enter_innodb = 0;
 
-	if (srv_conc_n_threads < (lint)srv_thread_concurrency) {
-		/* Look for a slot where a thread is waiting and no other
-		thread has yet released the thread */
-
-		slot = UT_LIST_GET_FIRST(srv_conc_queue);
-
-		while (slot && slot->wait_ended == TRUE) {
-			slot = UT_LIST_GET_NEXT(srv_conc_queue, slot);
-		}
+	srv_conc_add(&srv_conc_n_threads, -1);
 
-		if (slot != NULL) {
-			slot->wait_ended = TRUE;
-
-			/* We increment the count on behalf of the released
-			thread */
-
-			srv_conc_n_threads++;
-		}
-	}
-
-	os_fast_mutex_unlock(&srv_conc_mutex);
-
-	if (slot != NULL) {
-		os_event_set(slot->event);
-	}
+	srv_conc_release_slot();
 }
 
 /*************************************************************************
@@ -1692,6 +1998,15 @@ srv_printf_innodb_monitor(
 	fprintf(file, "%ld queries inside InnoDB, %lu queries in queue\n",
 		(long) srv_conc_n_threads,
 		(ulong) srv_conc_n_waiting_threads);
+	fprintf(file,
+		"%lu queue waits, %.2f ms average wait,"
+		" %lu max queue length, %lu handed over to active trx\n",
+		(ulong) srv_conc_n_waits,
+		srv_conc_n_waits
+		? (double) srv_conc_wait_time / 1000 / srv_conc_n_waits
+		: 0.0,
+		(ulong) srv_conc_max_waiting,
+		(ulong) srv_conc_n_prio_admissions);
 
 	fprintf(file, "%lu read views open inside InnoDB\n",
 		UT_LIST_GET_LEN(trx_sys->view_list));
@@ -1771,6 +2086,8 @@ srv_export_innodb_status(void)
 		= srv_buf_pool_write_requests;
 	export_vars.innodb_buffer_pool_wait_free = srv_buf_pool_wait_free;
 	export_vars.innodb_buffer_pool_pages_flushed = srv_buf_pool_flushed;
+	export_vars.innodb_buffer_pool_pages_flushed_neighbors
+		= srv_buf_pool_flushed_neighbors;
 	export_vars.innodb_buffer_pool_reads = srv_buf_pool_reads;
 	export_vars.innodb_buffer_pool_read_ahead_rnd = srv_read_ahead_rnd;
 	export_vars.innodb_buffer_pool_read_ahead_seq = srv_read_ahead_seq;
@@ -1795,11 +2112,28 @@ srv_export_innodb_status(void)
 	export_vars.innodb_os_log_pending_writes = srv_os_log_pending_writes;
 	export_vars.innodb_log_write_requests = srv_log_write_requests;
 	export_vars.innodb_log_writes = srv_log_writes;
+	export_vars.innodb_conc_queue_length = srv_conc_n_waiting_threads;
+	export_vars.innodb_conc_queue_length_max = srv_conc_max_waiting;
+	export_vars.innodb_conc_waits = srv_conc_n_waits;
+	export_vars.innodb_conc_wait_time = srv_conc_wait_time / 1000;
+	export_vars.innodb_conc_prio_admissions = srv_conc_n_prio_admissions;
+	export_vars.innodb_dblwr_pages_skipped = srv_dblwr_pages_skipped;
 	export_vars.innodb_dblwr_pages_written = srv_dblwr_pages_written;
 	export_vars.innodb_dblwr_writes = srv_dblwr_writes;
+	ibuf_get_stats(&export_vars.innodb_ibuf_size,
+		       &export_vars.innodb_ibuf_max_size,
+		       &export_vars.innodb_ibuf_inserts,
+		       &export_vars.innodb_ibuf_merges,
+		       &export_vars.innodb_ibuf_merged_recs);
 	export_vars.innodb_pages_created = buf_pool->n_pages_created;
 	export_vars.innodb_pages_read = buf_pool->n_pages_read;
 	export_vars.innodb_pages_written = buf_pool->n_pages_written;
+	export_vars.innodb_deadlock_checks = lock_deadlock_n_checks;
+	export_vars.innodb_deadlock_checks_deferred = lock_deadlock_n_deferred;
+	export_vars.innodb_deadlock_steps = lock_deadlock_n_steps;
+	export_vars.innodb_deadlocks = lock_deadlock_n_found;
+	export_vars.innodb_dict_tables_evicted = dict_sys->n_evicted;
+	export_vars.innodb_dict_tables_reloaded = dict_sys->n_reloaded;
 	export_vars.innodb_row_lock_waits = srv_n_lock_wait_count;
 	export_vars.innodb_row_lock_current_waits
 		= srv_n_lock_wait_current_count;
@@ -1929,6 +2263,11 @@ loop:
 
 	mutex_enter(&kernel_mutex);
 
+	/* Finish the deadlock checks which ran out of their budget when
+	the lock waits started */
+
+	lock_deadlock_check_deferred();
+
 	some_waits = FALSE;
 
 	/* Check of all slots if a thread is waiting there, and if it
@@ -2097,6 +2436,90 @@ loop:
 	OS_THREAD_DUMMY_RETURN;
 }
 
+/*************************************************************************
+A thread which keeps a reserve of replaceable blocks in the buffer pool by
+flushing pages from the end of the LRU list, so that the user threads
+needing a free block do not have to do the flushing themselves. */
+UNIV_INTERN
+os_thread_ret_t
+srv_LRU_flusher_thread(
+/*===================*/
+			/* out: a dummy parameter */
+	void*	arg __attribute__((unused)))
+			/* in: a dummy parameter required by
+			os_thread_create */
+{
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "LRU flusher thread starts, id %lu\n",
+		os_thread_pf(os_thread_get_curr_id()));
+#endif
+	srv_LRU_flusher_active = TRUE;
+
+	while (srv_shutdown_state < SRV_SHUTDOWN_CLEANUP) {
+
+		/* Reset the event before looking at the buffer pool, so
+		that a wake-up request made meanwhile is not lost */
+
+		os_event_reset(srv_LRU_flusher_event);
+
+		if (srv_LRU_scan_depth > 0
+		    && buf_flush_LRU_reserve(srv_LRU_scan_depth)) {
+
+			continue;
+		}
+
+		os_event_wait_time(srv_LRU_flusher_event, 1000000);
+	}
+
+	srv_LRU_flusher_active = FALSE;
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/*************************************************************************
+A thread which extends the files of growing tablespaces ahead of their
+use, so that the user threads allocating pages seldom have to wait for
+a file extension. */
+UNIV_INTERN
+os_thread_ret_t
+srv_preallocate_thread(
+/*===================*/
+			/* out: a dummy parameter */
+	void*	arg __attribute__((unused)))
+			/* in: a dummy parameter required by
+			os_thread_create */
+{
+#ifdef UNIV_DEBUG_THREAD_CREATION
+	fprintf(stderr, "Preallocation thread starts, id %lu\n",
+		os_thread_pf(os_thread_get_curr_id()));
+#endif
+	srv_preallocate_active = TRUE;
+
+	while (srv_shutdown_state < SRV_SHUTDOWN_CLEANUP) {
+
+		os_event_reset(srv_preallocate_event);
+
+		if (!fil_preallocate_next_space()) {
+
+			os_event_wait_time(srv_preallocate_event, 1000000);
+		}
+	}
+
+	srv_preallocate_active = FALSE;
+
+	/* We count the number of threads in os_thread_exit(). A created
+	thread should always use that to exit and not use return() to exit. */
+
+	os_thread_exit(NULL);
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
 /***********************************************************************
 Tells the InnoDB server that there has been activity in the database
 and wakes up the master thread if it is suspended (not sleeping). Used
@@ -2231,6 +2654,22 @@ loop:
 			goto background_loop;
 		}
 
+		if (srv_dict_size_limit) {
+			srv_main_thread_op_info = "evicting tables from"
+				" the dictionary cache";
+
+			dict_table_LRU_trim(srv_dict_size_limit);
+
+			srv_main_thread_op_info = "";
+		}
+
+		/* Keep some file handles free for the i/o's which
+		have to open a tablespace file */
+
+		srv_main_thread_op_info = "closing files";
+		fil_close_files_in_LRU();
+		srv_main_thread_op_info = "";
+
 		/* We flush the log once in a second even if no commit
 		is issued or the we have specified in my.cnf no flush
 		at transaction commit */
@@ -2241,19 +2680,18 @@ loop:
 		srv_main_thread_op_info = "making checkpoint";
 		log_free_check();
 
-		/* If there were less than 5 i/os during the
-		one second sleep, we assume that there is free
-		disk i/o capacity available, and it makes sense to
-		do an insert buffer merge. */
+		/* If there were less than 5 % of srv_io_capacity
+		i/os during the one second sleep, we assume that there
+		is free disk i/o capacity available, and it makes
+		sense to do an insert buffer merge. */
 
 		n_pend_ios = buf_get_n_pending_ios()
 			+ log_sys->n_pending_writes;
 		n_ios = log_sys->n_log_ios + buf_pool->n_pages_read
 			+ buf_pool->n_pages_written;
-		if (n_pend_ios < 3 && (n_ios - n_ios_old < 5)) {
+		if (n_pend_ios < 3 && (n_ios - n_ios_old < PCT_IO(5))) {
 			srv_main_thread_op_info = "doing insert buffer merge";
-			ibuf_contract_for_n_pages(
-				TRUE, srv_insert_buffer_batch_size / 4);
+			ibuf_contract_for_n_pages(TRUE, PCT_IO(5));
 
 			srv_main_thread_op_info = "flushing log";
 
@@ -2314,7 +2752,7 @@ loop:
 	even if the server were active */
 
 	srv_main_thread_op_info = "doing insert buffer merge";
-	ibuf_contract_for_n_pages(TRUE, srv_insert_buffer_batch_size / 4);
+	ibuf_contract_for_n_pages(TRUE, PCT_IO(5));
 
 	srv_main_thread_op_info = "flushing log";
 	log_buffer_flush_to_disk();
@@ -2409,6 +2847,13 @@ background_loop:
 		os_thread_sleep(100000);
 	}
 
+	if (srv_dict_size_limit && srv_shutdown_state == 0) {
+		srv_main_thread_op_info = "evicting tables from"
+			" the dictionary cache";
+
+		dict_table_LRU_trim(srv_dict_size_limit);
+	}
+
 	srv_main_thread_op_info = "purging";
 
 	/* Run a full purge */
@@ -2449,7 +2894,7 @@ background_loop:
 		n_bytes_merged = 0;
 	} else {
 		n_bytes_merged = ibuf_contract_for_n_pages(
-			TRUE, srv_insert_buffer_batch_size);
+			TRUE, PCT_IO(100));
 	}
 
 	srv_main_thread_op_info = "reserving kernel mutex";
@@ -85,8 +85,8 @@ static os_file_t	files[1000];
 static mutex_t		ios_mutex;
 static ulint		ios;
 
-static ulint		n[SRV_MAX_N_IO_THREADS + 5];
-static os_thread_id_t	thread_ids[SRV_MAX_N_IO_THREADS + 5];
+static ulint		n[SRV_MAX_N_IO_THREADS + 6];
+static os_thread_id_t	thread_ids[SRV_MAX_N_IO_THREADS + 6];
 
 /* We use this mutex to test the return value of pthread_mutex_trylock
    on successful locking. HP-UX does NOT return 0, though Linux et al do. */
@@ -1101,6 +1101,10 @@ innobase_start_or_create_for_mysql(void)
 	} else if (0 == ut_strcmp(srv_file_flush_method_str, "O_DIRECT")) {
 		srv_unix_file_flush_method = SRV_UNIX_O_DIRECT;
 
+	} else if (0 == ut_strcmp(srv_file_flush_method_str,
+				  "ALL_O_DIRECT")) {
+		srv_unix_file_flush_method = SRV_UNIX_ALL_O_DIRECT;
+
 	} else if (0 == ut_strcmp(srv_file_flush_method_str, "littlesync")) {
 		srv_unix_file_flush_method = SRV_UNIX_LITTLESYNC;
 
@@ -1567,6 +1571,18 @@ innobase_start_or_create_for_mysql(void)
 
 	os_thread_create(&srv_master_thread, NULL, thread_ids
 			 + (1 + SRV_MAX_N_IO_THREADS));
+
+	/* Create the thread which flushes the end of the LRU list, so that
+	the user threads find free blocks in the buffer pool */
+
+	os_thread_create(&srv_LRU_flusher_thread, NULL,
+			 thread_ids + 4 + SRV_MAX_N_IO_THREADS);
+
+	/* Create the thread which extends the files of growing
+	tablespaces in the background */
+
+	os_thread_create(&srv_preallocate_thread, NULL,
+			 thread_ids + 5 + SRV_MAX_N_IO_THREADS);
 #ifdef UNIV_DEBUG
 	/* buf_debug_prints = TRUE; */
 #endif /* UNIV_DEBUG */
@@ -1815,8 +1831,11 @@ innobase_shutdown_for_mysql(void)
 		/* b. srv error monitor thread exits automatically, no need
 		to do anything here */
 
-		/* c. We wake the master thread so that it exits */
+		/* c. We wake the master thread, the LRU flusher thread
+		and the preallocation thread so that they exit */
 		srv_wake_master_thread();
+		os_event_set(srv_LRU_flusher_event);
+		os_event_set(srv_preallocate_event);
 
 		/* d. Exit the i/o threads */
 
@@ -1872,8 +1891,9 @@ innobase_shutdown_for_mysql(void)
 	mutex_free(&srv_dict_tmpfile_mutex);
 	mutex_free(&srv_misc_tmpfile_mutex);
 
-	/* 3. Free all InnoDB's own mutexes and the os_fast_mutexes inside
-	them */
+	/* 3. Free the caches of the memory pool, and all InnoDB's own
+	mutexes and the os_fast_mutexes inside them */
+	mem_close();
 	sync_close();
 
 	/* 4. Free the os_conc_mutex and all os_events and os_mutexes */
@@ -16,6 +16,7 @@ Created 9/5/1995 Heikki Tuuri
 #include "os0sync.h"
 #include "os0file.h"
 #include "srv0srv.h"
+#include "ut0rnd.h"
 
 /*
 			WAIT ARRAY
@@ -48,7 +49,15 @@ Instead, now the event that a thread wants to wait on is embedded
 in the wait object (mutex or rw_lock). We still keep the global
 wait array for the sake of diagnostics and also to avoid infinite
 wait The error_monitor thread scans the global wait array to signal
-any waiting threads who have missed the signal. */
+any waiting threads who have missed the signal.
+
+A single global array is protected by one OS mutex, which every thread
+that has to suspend itself must acquire. Therefore the primary wait array
+is split into sync_array_size arrays, each with its own mutex. A thread
+reserves its cell in the array selected by its thread id; only if that
+array is full does it try the following ones. Free cells of an array
+are kept in a list, so that a reservation does not have to scan the
+array. */
 
 /* A cell where an individual thread may wait suspended
 until a resource is released. The suspending is implemented
@@ -80,6 +89,9 @@ struct sync_cell_struct {
 					wait call. */
 	time_t		reservation_time;/* time when the thread reserved
 					the wait cell */
+	ulint		next_free;	/* if the cell is free, the index of
+					the next free cell in the array, or
+					ULINT_UNDEFINED */
 };
 
 /* NOTE: It is allowed for a thread to wait
@@ -93,6 +105,9 @@ struct sync_array_struct {
 	ulint		n_cells;	/* number of cells in the
 					wait array */
 	sync_cell_t*	array;		/* pointer to wait array */
+	ulint		first_free;	/* index of the first free cell,
+					or ULINT_UNDEFINED if the array
+					is full */
 	ulint		protection;	/* this flag tells which
 					mutex protects the data */
 	mutex_t		mutex;		/* possible database mutex
@@ -105,11 +120,19 @@ struct sync_array_struct {
 					in implementation, we fall back to
 					an OS mutex. */
 	ulint		sg_count;	/* count of how many times an
-					object has been signalled */
+					object has been signalled; with
+					atomic builtins this is incremented
+					without the mutex */
 	ulint		res_count;	/* count of cell reservations
 					since creation of the array */
 };
 
+/* The primary wait arrays */
+UNIV_INTERN sync_array_t**	sync_wait_array;
+
+/* Number of primary wait arrays, set from srv_sync_array_size */
+UNIV_INTERN ulint		sync_array_size;
+
 #ifdef UNIV_SYNC_DEBUG
 /**********************************************************************
 This function is called only in the debug version. Detects a deadlock
@@ -214,6 +237,7 @@ sync_array_create(
 	arr->n_cells = n_cells;
 	arr->n_reserved = 0;
 	arr->array = cell_array;
+	arr->first_free = 0;
 	arr->protection = protection;
 	arr->sg_count = 0;
 	arr->res_count = 0;
@@ -229,9 +253,10 @@ sync_array_create(
 
 	for (i = 0; i < n_cells; i++) {
 		cell = sync_array_get_nth_cell(arr, i);
-	cell->wait_object = NULL;
+		cell->wait_object = NULL;
 		cell->waiting = FALSE;
 		cell->signal_count = 0;
+		cell->next_free = (i + 1 < n_cells) ? i + 1 : ULINT_UNDEFINED;
 	}
 
 	return(arr);
@@ -291,6 +316,18 @@ sync_array_validate(
 
 	ut_a(count == arr->n_reserved);
 
+	/* The free list must contain exactly the unreserved cells */
+	count = 0;
+
+	for (i = arr->first_free; i != ULINT_UNDEFINED;
+	     i = cell->next_free) {
+		cell = sync_array_get_nth_cell(arr, i);
+		ut_a(cell->wait_object == NULL);
+		count++;
+	}
+
+	ut_a(count == arr->n_cells - arr->n_reserved);
+
 	sync_array_exit(arr);
 }
 
@@ -307,11 +344,9 @@ sync_cell_event_reset(
 {
 	if (type == SYNC_MUTEX) {
 		return(os_event_reset(((mutex_t *) object)->event));
-#ifdef __WIN__
 	} else if (type == RW_LOCK_WAIT_EX) {
 		return(os_event_reset(
 		       ((rw_lock_t *) object)->wait_ex_event));
-#endif
 	} else {
 		return(os_event_reset(((rw_lock_t *) object)->event));
 	}
@@ -321,9 +356,11 @@ sync_cell_event_reset(
 Reserves a wait array cell for waiting for an object.
 The event of the cell is reset to nonsignalled state. */
 UNIV_INTERN
-void
+ibool
 sync_array_reserve_cell(
 /*====================*/
+				/* out: TRUE if a cell was reserved,
+				FALSE if the array is full */
 	sync_array_t*	arr,	/* in: wait array */
 	void*		object, /* in: pointer to the object to wait for */
 	ulint		type,	/* in: lock request type */
@@ -339,51 +376,114 @@ sync_array_reserve_cell(
 
 	sync_array_enter(arr);
 
+	i = arr->first_free;
+
+	if (UNIV_UNLIKELY(i == ULINT_UNDEFINED)) {
+		sync_array_exit(arr);
+
+		return(FALSE);
+	}
+
 	arr->res_count++;
 
-	/* Reserve a new cell. */
-	for (i = 0; i < arr->n_cells; i++) {
-		cell = sync_array_get_nth_cell(arr, i);
+	/* Reserve the first free cell. */
+	cell = sync_array_get_nth_cell(arr, i);
 
-		if (cell->wait_object == NULL) {
+	ut_a(cell->wait_object == NULL);
 
-			cell->waiting = FALSE;
-			cell->wait_object = object;
+	arr->first_free = cell->next_free;
 
-			if (type == SYNC_MUTEX) {
-				cell->old_wait_mutex = object;
-			} else {
-				cell->old_wait_rw_lock = object;
-			}
+	cell->waiting = FALSE;
+	cell->wait_object = object;
+
+	if (type == SYNC_MUTEX) {
+		cell->old_wait_mutex = object;
+	} else {
+		cell->old_wait_rw_lock = object;
+	}
+
+	cell->request_type = type;
+
+	cell->file = file;
+	cell->line = line;
+
+	arr->n_reserved++;
+
+	*index = i;
 
-			cell->request_type = type;
+	sync_array_exit(arr);
+
+	/* Make sure the event is reset and also store the value of
+	signal_count at which the event was reset. */
+	cell->signal_count = sync_cell_event_reset(type, object);
 
-			cell->file = file;
-			cell->line = line;
+	cell->reservation_time = time(NULL);
 
-			arr->n_reserved++;
+	cell->thread = os_thread_get_curr_id();
 
-			*index = i;
+	return(TRUE);
+}
+
+/**********************************************************************
+Returns the number of the primary wait array of the current thread. */
+static
+ulint
+sync_array_get_nth_for_thread(void)
+/*===============================*/
+				/* out: index to sync_wait_array */
+{
+	ulint	id;
 
-			sync_array_exit(arr);
+	if (sync_array_size == 1) {
 
-			/* Make sure the event is reset and also store
-			the value of signal_count at which the event
-			was reset. */
-			cell->signal_count = sync_cell_event_reset(type,
-								object);
+		return(0);
+	}
 
-			cell->reservation_time = time(NULL);
+	/* Thread ids are often addresses of thread stacks, aligned to
+	a large power of 2: fold in the higher bits. */
+	id = (ulint) os_thread_pf(os_thread_get_curr_id());
 
-			cell->thread = os_thread_get_curr_id();
+	return(ut_fold_ulint_pair(id, id >> 12) % sync_array_size);
+}
 
-			return;
+/**********************************************************************
+Reserves a cell for the current thread in one of the primary wait
+arrays. The array of the thread is tried first; if it is full, the
+following ones. */
+UNIV_INTERN
+sync_array_t*
+sync_array_get_and_reserve_cell(
+/*============================*/
+				/* out: the wait array where the cell
+				was reserved; pass it to
+				sync_array_wait_event() or
+				sync_array_free_cell() */
+	void*		object, /* in: pointer to the object to wait for */
+	ulint		type,	/* in: lock request type */
+	const char*	file,	/* in: file where requested */
+	ulint		line,	/* in: line where requested */
+	ulint*		index)	/* out: index of the reserved cell */
+{
+	sync_array_t*	arr;
+	ulint		n;
+	ulint		i;
+
+	n = sync_array_get_nth_for_thread();
+
+	for (i = 0; i < sync_array_size; i++) {
+		arr = sync_wait_array[(n + i) % sync_array_size];
+
+		if (sync_array_reserve_cell(arr, object, type,
+					    file, line, index)) {
+
+			return(arr);
 		}
 	}
 
-	ut_error; /* No free cell found */
+	/* The arrays have room for all OS_THREAD_MAX_N threads */
+	ut_error;
 
-	return;
+	return(NULL);
 }
 
 /**********************************************************************
@@ -413,13 +513,11 @@ sync_array_wait_event(
 
 	if (cell->request_type == SYNC_MUTEX) {
 		event = ((mutex_t*) cell->wait_object)->event;
-#ifdef __WIN__
-	/* On windows if the thread about to wait is the one which
-	has set the state of the rw_lock to RW_LOCK_WAIT_EX, then
-	it waits on a special event i.e.: wait_ex_event. */
+	/* If the thread about to wait is the one which has set the
+	state of the rw_lock to RW_LOCK_WAIT_EX, then it waits on a
+	special event i.e.: wait_ex_event. */
 	} else if (cell->request_type == RW_LOCK_WAIT_EX) {
 		event = ((rw_lock_t*) cell->wait_object)->wait_ex_event;
-#endif
 	} else {
 		event = ((rw_lock_t*) cell->wait_object)->event;
 	}
@@ -431,7 +529,9 @@ sync_array_wait_event(
 	/* We use simple enter to the mutex below, because if
 	we cannot acquire it at once, mutex_enter would call
 	recursively sync_array routines, leading to trouble.
-	rw_lock_debug_mutex freezes the debug lists. */
+	rw_lock_debug_mutex freezes the debug lists. Only the threads
+	waiting in this array are seen by the deadlock detection: with
+	sync_array_size > 1 a deadlock may go unnoticed here. */
 
 	rw_lock_debug_mutex_enter();
 
@@ -461,6 +561,7 @@ sync_array_cell_print(
 {
 	mutex_t*	mutex;
 	rw_lock_t*	rwlock;
+	ulint		writer;
 	ulint		type;
 
 	type = cell->request_type;
@@ -491,12 +592,12 @@ sync_array_cell_print(
 			(ulong) mutex->waiters);
 
 	} else if (type == RW_LOCK_EX
-#ifdef __WIN__
 		   || type == RW_LOCK_WAIT_EX
-#endif
 		   || type == RW_LOCK_SHARED) {
 
-		fputs(type == RW_LOCK_EX ? "X-lock on" : "S-lock on", file);
+		fputs(type == RW_LOCK_EX ? "X-lock on"
+		      : type == RW_LOCK_WAIT_EX ? "X-lock (wait_ex) on"
+		      : "S-lock on", file);
 
 		rwlock = cell->old_wait_rw_lock;
 
@@ -504,22 +605,25 @@ sync_array_cell_print(
 			" RW-latch at %p created in file %s line %lu\n",
 			(void*) rwlock, rwlock->cfile_name,
 			(ulong) rwlock->cline);
-		if (rwlock->writer != RW_LOCK_NOT_LOCKED) {
+		writer = rw_lock_get_writer(rwlock);
+		if (writer != RW_LOCK_NOT_LOCKED) {
 			fprintf(file,
 				"a writer (thread id %lu) has"
 				" reserved it in mode %s",
 				(ulong) os_thread_pf(rwlock->writer_thread),
-				rwlock->writer == RW_LOCK_EX
+				writer == RW_LOCK_EX
 				? " exclusive\n"
 				: " wait exclusive\n");
 		}
 
 		fprintf(file,
-			"number of readers %lu, waiters flag %lu\n"
+			"number of readers %lu, waiters flag %lu,"
+			" lock_word: %lx\n"
 			"Last time read locked in file %s line %lu\n"
 			"Last time write locked in file %s line %lu\n",
-			(ulong) rwlock->reader_count,
+			(ulong) rw_lock_get_reader_count(rwlock),
 			(ulong) rwlock->waiters,
+			(ulong) rwlock->lock_word,
 			rwlock->last_s_file_name,
 			(ulong) rwlock->last_s_line,
 			rwlock->last_x_file_name,
@@ -778,20 +882,21 @@ sync_arr_cell_can_wake_up(
 			return(TRUE);
 		}
 
-	} else if (cell->request_type == RW_LOCK_EX
-		   || cell->request_type == RW_LOCK_WAIT_EX) {
+	} else if (cell->request_type == RW_LOCK_EX) {
 
 		lock = cell->wait_object;
 
-		if (rw_lock_get_reader_count(lock) == 0
-		    && rw_lock_get_writer(lock) == RW_LOCK_NOT_LOCKED) {
+		if (lock->lock_word == X_LOCK_DECR) {
 
 			return(TRUE);
 		}
 
-		if (rw_lock_get_reader_count(lock) == 0
-		    && rw_lock_get_writer(lock) == RW_LOCK_WAIT_EX
-		    && os_thread_eq(lock->writer_thread, cell->thread)) {
+	} else if (cell->request_type == RW_LOCK_WAIT_EX) {
+
+		lock = cell->wait_object;
+
+		/* lock_word == 0 means all readers have left */
+		if (lock->lock_word == 0) {
 
 			return(TRUE);
 		}
@@ -799,7 +904,8 @@ sync_arr_cell_can_wake_up(
 	} else if (cell->request_type == RW_LOCK_SHARED) {
 		lock = cell->wait_object;
 
-		if (rw_lock_get_writer(lock) == RW_LOCK_NOT_LOCKED) {
+		/* lock_word > 0 means no writer or reserved writer */
+		if (lock->lock_word > 0) {
 
 			return(TRUE);
 		}
@@ -830,6 +936,11 @@ sync_array_free_cell(
 	cell->wait_object =  NULL;
 	cell->signal_count = 0;
 
+	/* Reuse the most recently freed cell first: it is likely to
+	be in the cache */
+	cell->next_free = arr->first_free;
+	arr->first_free = index;
+
 	ut_a(arr->n_reserved > 0);
 	arr->n_reserved--;
 
@@ -840,31 +951,37 @@ sync_array_free_cell(
 Increments the signalled count. */
 UNIV_INTERN
 void
-sync_array_object_signalled(
-/*========================*/
-	sync_array_t*	arr)	/* in: wait array */
+sync_array_object_signalled(void)
+/*=============================*/
 {
+	sync_array_t*	arr;
+
+	arr = sync_wait_array[sync_array_get_nth_for_thread()];
+
+#ifdef HAVE_GCC_ATOMIC_BUILTINS
+	os_atomic_increment(&arr->sg_count, 1);
+#else /* HAVE_GCC_ATOMIC_BUILTINS */
 	sync_array_enter(arr);
 
 	arr->sg_count++;
 
 	sync_array_exit(arr);
+#endif /* HAVE_GCC_ATOMIC_BUILTINS */
 }
 
 /**************************************************************************
-If the wakeup algorithm does not work perfectly at semaphore relases,
-this function will do the waking (see the comment in mutex_exit). This
-function should be called about every 1 second in the server.
+Wakes the threads waiting in a wait array for a semaphore which has
+been released.
 
 Note that there's a race condition between this thread and mutex_exit
 changing the lock_word and calling signal_object, so sometimes this finds
 threads to wake up even when nothing has gone wrong. */
-UNIV_INTERN
+static
 void
-sync_arr_wake_threads_if_sema_free(void)
-/*====================================*/
+sync_array_wake_threads_if_sema_free_low(
+/*=====================================*/
+	sync_array_t*	arr)	/* in/out: wait array */
 {
-	sync_array_t*	arr	= sync_primary_wait_array;
 	sync_cell_t*	cell;
 	ulint		count;
 	ulint		i;
@@ -889,14 +1006,12 @@ sync_arr_wake_threads_if_sema_free(void)
 
 					mutex = cell->wait_object;
 					os_event_set(mutex->event);
-#ifdef __WIN__
 				} else if (cell->request_type
 					   == RW_LOCK_WAIT_EX) {
 					rw_lock_t*	lock;
 
 					lock = cell->wait_object;
 					os_event_set(lock->wait_ex_event);
-#endif
 				} else {
 					rw_lock_t*	lock;
 
@@ -913,31 +1028,49 @@ sync_arr_wake_threads_if_sema_free(void)
 }
 
 /**************************************************************************
-Prints warnings of long semaphore waits to stderr. */
+If the wakeup algorithm does not work perfectly at semaphore relases,
+this function will do the waking (see the comment in mutex_exit). This
+function should be called about every 1 second in the server. */
 UNIV_INTERN
+void
+sync_arr_wake_threads_if_sema_free(void)
+/*====================================*/
+{
+	ulint	i;
+
+	for (i = 0; i < sync_array_size; i++) {
+
+		sync_array_wake_threads_if_sema_free_low(sync_wait_array[i]);
+	}
+}
+
+/**************************************************************************
+Prints warnings of long semaphore waits in a wait array to stderr. */
+static
 ibool
-sync_array_print_long_waits(void)
-/*=============================*/
-			/* out: TRUE if fatal semaphore wait threshold
-			was exceeded */
+sync_array_print_long_waits_low(
+/*============================*/
+				/* out: TRUE if fatal semaphore wait
+				threshold was exceeded */
+	sync_array_t*	arr,	/* in: wait array */
+	ibool*		noticed)/* out: set to TRUE if a long wait
+				was printed */
 {
 	sync_cell_t*	cell;
-	ibool		old_val;
-	ibool		noticed = FALSE;
 	ulint		i;
 	ulint		fatal_timeout = srv_fatal_semaphore_wait_threshold;
 	ibool		fatal = FALSE;
 
-	for (i = 0; i < sync_primary_wait_array->n_cells; i++) {
+	for (i = 0; i < arr->n_cells; i++) {
 
-		cell = sync_array_get_nth_cell(sync_primary_wait_array, i);
+		cell = sync_array_get_nth_cell(arr, i);
 
 		if (cell->wait_object != NULL && cell->waiting
 		    && difftime(time(NULL), cell->reservation_time) > 240) {
 			fputs("InnoDB: Warning: a long semaphore wait:\n",
 			      stderr);
 			sync_array_cell_print(stderr, cell);
-			noticed = TRUE;
+			*noticed = TRUE;
 		}
 
 		if (cell->wait_object != NULL && cell->waiting
@@ -947,6 +1080,30 @@ sync_array_print_long_waits(void)
 		}
 	}
 
+	return(fatal);
+}
+
+/**************************************************************************
+Prints warnings of long semaphore waits to stderr. */
+UNIV_INTERN
+ibool
+sync_array_print_long_waits(void)
+/*=============================*/
+			/* out: TRUE if fatal semaphore wait threshold
+			was exceeded */
+{
+	ibool		old_val;
+	ibool		noticed = FALSE;
+	ibool		fatal = FALSE;
+	ulint		i;
+
+	for (i = 0; i < sync_array_size; i++) {
+		if (sync_array_print_long_waits_low(sync_wait_array[i],
+						    &noticed)) {
+			fatal = TRUE;
+		}
+	}
+
 	if (noticed) {
 		fprintf(stderr,
 			"InnoDB: ###### Starts InnoDB Monitor"
@@ -992,9 +1149,6 @@ sync_array_output_info(
 	ulint		count;
 	ulint		i;
 
-	fprintf(file,
-		"OS WAIT ARRAY INFO: reservation count %ld, signal count %ld\n",
-						(long) arr->res_count, (long) arr->sg_count);
 	i = 0;
 	count = 0;
 
@@ -1017,13 +1171,87 @@ UNIV_INTERN
 void
 sync_array_print_info(
 /*==================*/
-	FILE*		file,	/* in: file where to print */
-	sync_array_t*	arr)	/* in: wait array */
+	FILE*		file)	/* in: file where to print */
 {
-	sync_array_enter(arr);
+	ulint	res_count	= 0;
+	ulint	sg_count	= 0;
+	ulint	n_reserved	= 0;
+	ulint	i;
+
+	/* The counters are summed without the mutexes: they are only
+	statistics */
+	for (i = 0; i < sync_array_size; i++) {
+		res_count += sync_wait_array[i]->res_count;
+		sg_count += sync_wait_array[i]->sg_count;
+		n_reserved += sync_wait_array[i]->n_reserved;
+	}
 
-	sync_array_output_info(file, arr);
+	fprintf(file,
+		"OS WAIT ARRAY INFO: reservation count %ld, signal count %ld\n",
+		(long) res_count, (long) sg_count);
 
-	sync_array_exit(arr);
+	if (sync_array_size > 1) {
+		fprintf(file,
+			"OS WAIT ARRAY INFO: %lu arrays,"
+			" %lu cells reserved\n",
+			(ulong) sync_array_size, (ulong) n_reserved);
+	}
+
+	for (i = 0; i < sync_array_size; i++) {
+		sync_array_t*	arr = sync_wait_array[i];
+
+		sync_array_enter(arr);
+
+		sync_array_output_info(file, arr);
+
+		sync_array_exit(arr);
+	}
+}
+
+/***********************************************************************
+Creates the sync_array_size primary wait arrays. */
+UNIV_INTERN
+void
+sync_array_init(
+/*============*/
+	ulint	n_threads)	/* in: number of threads that can wait
+				at the same time */
+{
+	ulint	n_cells;
+	ulint	i;
+
+	ut_a(sync_wait_array == NULL);
+	ut_a(srv_sync_array_size > 0);
+
+	sync_array_size = srv_sync_array_size;
+
+	/* Together the arrays have room for all threads; a thread
+	whose own array is full uses one of the others. */
+	n_cells = 1 + (n_threads - 1) / sync_array_size;
+
+	sync_wait_array = ut_malloc(sync_array_size * sizeof(sync_array_t*));
+
+	for (i = 0; i < sync_array_size; i++) {
+		sync_wait_array[i] = sync_array_create(n_cells,
+						       SYNC_ARRAY_OS_MUTEX);
+	}
+}
+
+/***********************************************************************
+Frees the primary wait arrays. */
+UNIV_INTERN
+void
+sync_array_close(void)
+/*==================*/
+{
+	ulint	i;
+
+	for (i = 0; i < sync_array_size; i++) {
+		sync_array_free(sync_wait_array[i]);
+	}
+
+	ut_free(sync_wait_array);
+
+	sync_wait_array = NULL;
 }
 
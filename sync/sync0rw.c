@@ -51,8 +51,8 @@ UNIV_INTERN mutex_t		rw_lock_list_mutex;
 
 #ifdef UNIV_SYNC_DEBUG
 /* The global mutex which protects debug info lists of all rw-locks.
-To modify the debug info list of an rw-lock, this mutex has to be
-acquired in addition to the mutex protecting the lock. */
+To modify or to read the debug info list of an rw-lock, this mutex has
+to be acquired. */
 
 UNIV_INTERN mutex_t		rw_lock_debug_mutex;
 /* If deadlock detection does not get immediately the mutex,
@@ -119,22 +119,30 @@ rw_lock_create_func(
 	/* If this is the very first time a synchronization object is
 	created, then the following call initializes the sync system. */
 
+#ifndef INNODB_RW_LOCKS_USE_ATOMICS
 	mutex_create(rw_lock_get_mutex(lock), SYNC_NO_ORDER_CHECK);
 
 	lock->mutex.cfile_name = cfile_name;
 	lock->mutex.cline = cline;
 
-#if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
+# if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
 	lock->mutex.cmutex_name = cmutex_name;
 	lock->mutex.mutex_type = 1;
-#endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+# endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
 
-	rw_lock_set_waiters(lock, 0);
-	rw_lock_set_writer(lock, RW_LOCK_NOT_LOCKED);
-	lock->writer_count = 0;
-	rw_lock_set_reader_count(lock, 0);
+#else /* INNODB_RW_LOCKS_USE_ATOMICS */
+# ifdef UNIV_DEBUG
+	UT_NOT_USED(cmutex_name);
+# endif
+#endif /* INNODB_RW_LOCKS_USE_ATOMICS */
 
-	lock->writer_is_wait_ex = FALSE;
+	lock->lock_word = X_LOCK_DECR;
+	lock->waiters = 0;
+
+	/* We set this value to signify that lock->writer_thread
+	contains garbage at initialization and cannot be used for
+	recursive x-locking. */
+	lock->recursive = FALSE;
 
 #ifdef UNIV_SYNC_DEBUG
 	UT_LIST_INIT(lock->debug_list);
@@ -151,11 +159,12 @@ rw_lock_create_func(
 	lock->last_x_file_name = "not yet reserved";
 	lock->last_s_line = 0;
 	lock->last_x_line = 0;
+	lock->count_os_wait = 0;
+	lock->count_spin_loop = 0;
+	lock->count_spin_rounds = 0;
+	lock->lspent_time = 0;
 	lock->event = os_event_create(NULL);
-
-#ifdef __WIN__
 	lock->wait_ex_event = os_event_create(NULL);
-#endif
 
 	mutex_enter(&rw_lock_list_mutex);
 
@@ -180,20 +189,19 @@ rw_lock_free(
 	rw_lock_t*	lock)	/* in: rw-lock */
 {
 	ut_ad(rw_lock_validate(lock));
-	ut_a(rw_lock_get_writer(lock) == RW_LOCK_NOT_LOCKED);
+	ut_a(lock->lock_word == X_LOCK_DECR);
 	ut_a(rw_lock_get_waiters(lock) == 0);
-	ut_a(rw_lock_get_reader_count(lock) == 0);
 
 	lock->magic_n = 0;
 
+#ifndef INNODB_RW_LOCKS_USE_ATOMICS
 	mutex_free(rw_lock_get_mutex(lock));
+#endif /* INNODB_RW_LOCKS_USE_ATOMICS */
 
 	mutex_enter(&rw_lock_list_mutex);
 	os_event_free(lock->event);
 
-#ifdef __WIN__
 	os_event_free(lock->wait_ex_event);
-#endif
 
 	if (UT_LIST_GET_PREV(list, lock)) {
 		ut_a(UT_LIST_GET_PREV(list, lock)->magic_n == RW_LOCK_MAGIC_N);
@@ -217,26 +225,44 @@ rw_lock_validate(
 /*=============*/
 	rw_lock_t*	lock)
 {
+	ulint	waiters;
+	lint	lock_word;
+
 	ut_a(lock);
 
-	mutex_enter(rw_lock_get_mutex(lock));
+	/* The fields are read without any latch: take a copy of each
+	so that the checks below see consistent values */
+	waiters = rw_lock_get_waiters(lock);
+	lock_word = lock->lock_word;
 
 	ut_a(lock->magic_n == RW_LOCK_MAGIC_N);
-	ut_a((rw_lock_get_reader_count(lock) == 0)
-	     || (rw_lock_get_writer(lock) != RW_LOCK_EX));
-	ut_a((rw_lock_get_writer(lock) == RW_LOCK_EX)
-	     || (rw_lock_get_writer(lock) == RW_LOCK_WAIT_EX)
-	     || (rw_lock_get_writer(lock) == RW_LOCK_NOT_LOCKED));
-	ut_a((rw_lock_get_waiters(lock) == 0)
-	     || (rw_lock_get_waiters(lock) == 1));
-	ut_a((lock->writer != RW_LOCK_EX) || (lock->writer_count > 0));
-
-	mutex_exit(rw_lock_get_mutex(lock));
+	ut_a(waiters == 0 || waiters == 1);
+	ut_a(lock_word > -X_LOCK_DECR || (-lock_word) % X_LOCK_DECR == 0);
 
 	return(TRUE);
 }
 #endif /* UNIV_DEBUG */
 
+/**********************************************************************
+Adds the time a thread waited for an rw-lock to the contention profile
+of the lock. */
+UNIV_INLINE
+void
+rw_lock_profile_wait_end(
+/*=====================*/
+	rw_lock_t*	lock,		/* in/out: rw-lock */
+	ullint		start_time)	/* in: ut_time_us() when the wait
+					started, or 0 if it was not timed */
+{
+	ullint	now;
+
+	if (UNIV_UNLIKELY(start_time != 0)
+	    && ut_time_us(&now) > start_time) {
+
+		lock->lspent_time += now - start_time;
+	}
+}
+
 /**********************************************************************
 Lock an rw-lock in shared mode for the current thread. If the rw-lock is
 locked in exclusive mode, or there is an exclusive lock request waiting,
@@ -252,19 +278,21 @@ rw_lock_s_lock_spin(
 	const char*	file_name, /* in: file name where lock requested */
 	ulint		line)	/* in: line where requested */
 {
-	ulint	 index;	/* index of the reserved wait cell */
-	ulint	 i;	/* spin round count */
+	ulint		index;	/* index of the reserved wait cell */
+	sync_array_t*	sync_arr;/* wait array of the cell */
+	ulint		i = 0;	/* spin round count */
+	ulint		i_start;/* value of i when this spin loop started */
+	ibool		profile	= srv_latch_profiling;
+	ullint		start_time = 0;/* for timing the wait */
 
 	ut_ad(rw_lock_validate(lock));
 
+	rw_s_spin_wait_count++;	/* Count calls to this function */
 lock_loop:
-	rw_s_spin_wait_count++;
+	i_start = i;
 
 	/* Spin waiting for the writer field to become free */
-	i = 0;
-
-	while (rw_lock_get_writer(lock) != RW_LOCK_NOT_LOCKED
-	       && i < SYNC_SPIN_ROUNDS) {
+	while (i < SYNC_SPIN_ROUNDS && lock->lock_word <= 0) {
 		if (srv_spin_wait_delay) {
 			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
 		}
@@ -272,7 +300,16 @@ lock_loop:
 		i++;
 	}
 
+	if (UNIV_UNLIKELY(profile)) {
+		lock->count_spin_loop++;
+		lock->count_spin_rounds += i - i_start;
+	}
+
 	if (i == SYNC_SPIN_ROUNDS) {
+		if (UNIV_UNLIKELY(profile) && start_time == 0) {
+			start_time = ut_time_us(NULL);
+		}
+
 		os_thread_yield();
 	}
 
@@ -285,28 +322,34 @@ lock_loop:
 			lock->cfile_name, (ulong) lock->cline, (ulong) i);
 	}
 
-	mutex_enter(rw_lock_get_mutex(lock));
-
 	/* We try once again to obtain the lock */
-
 	if (TRUE == rw_lock_s_lock_low(lock, pass, file_name, line)) {
-		mutex_exit(rw_lock_get_mutex(lock));
+		rw_lock_profile_wait_end(lock, start_time);
 
 		return; /* Success */
 	} else {
-		/* If we get here, locking did not succeed, we may
-		suspend the thread to wait in the wait array */
+
+		if (i < SYNC_SPIN_ROUNDS) {
+			goto lock_loop;
+		}
 
 		rw_s_system_call_count++;
 
-		sync_array_reserve_cell(sync_primary_wait_array,
-					lock, RW_LOCK_SHARED,
-					file_name, line,
-					&index);
+		sync_arr = sync_array_get_and_reserve_cell(lock,
+							   RW_LOCK_SHARED,
+							   file_name, line,
+							   &index);
 
-		rw_lock_set_waiters(lock, 1);
+		/* Set waiters before checking lock_word to ensure wake-up
+		signal is sent. This may lead to some unnecessary signals. */
+		rw_lock_set_waiter_flag(lock);
 
-		mutex_exit(rw_lock_get_mutex(lock));
+		if (TRUE == rw_lock_s_lock_low(lock, pass, file_name, line)) {
+			sync_array_free_cell(sync_arr, index);
+			rw_lock_profile_wait_end(lock, start_time);
+
+			return; /* Success */
+		}
 
 		if (srv_print_latch_waits) {
 			fprintf(stderr,
@@ -319,9 +362,15 @@ lock_loop:
 
 		rw_s_system_call_count++;
 		rw_s_os_wait_count++;
+		lock->count_os_wait++;
+
+		if (UNIV_UNLIKELY(profile) && start_time == 0) {
+			start_time = ut_time_us(NULL);
+		}
 
-		sync_array_wait_event(sync_primary_wait_array, index);
+		sync_array_wait_event(sync_arr, index);
 
+		i = 0;
 		goto lock_loop;
 	}
 }
@@ -343,113 +392,150 @@ rw_lock_x_lock_move_ownership(
 {
 	ut_ad(rw_lock_is_locked(lock, RW_LOCK_EX));
 
-	mutex_enter(&(lock->mutex));
-
-	lock->writer_thread = os_thread_get_curr_id();
-
-	lock->pass = 0;
-
-	mutex_exit(&(lock->mutex));
+	rw_lock_set_writer_id_and_recursion_flag(lock, TRUE);
 }
 
 /**********************************************************************
-Low-level function for acquiring an exclusive lock. */
+Function for the next writer to call. Waits for readers to exit.
+The caller must have already decremented lock_word by X_LOCK_DECR. */
 UNIV_INLINE
-ulint
-rw_lock_x_lock_low(
-/*===============*/
-				/* out: RW_LOCK_NOT_LOCKED if did
-				not succeed, RW_LOCK_EX if success,
-				RW_LOCK_WAIT_EX, if got wait reservation */
+void
+rw_lock_x_lock_wait(
+/*================*/
 	rw_lock_t*	lock,	/* in: pointer to rw-lock */
+#ifdef UNIV_SYNC_DEBUG
 	ulint		pass,	/* in: pass value; != 0, if the lock will
 				be passed to another thread to unlock */
+#endif
 	const char*	file_name,/* in: file name where lock requested */
-	ulint		line)	/* in: line where requested */
+	ulint		line,	/* in: line where requested */
+	ullint*		start_time)/* in/out: ut_time_us() when the wait
+				for the lock started, or 0; set here if
+				0 and the thread has to sleep while the
+				lock is being profiled */
 {
-	ut_ad(mutex_own(rw_lock_get_mutex(lock)));
+	ulint		index;
+	sync_array_t*	sync_arr;
+	ulint		i = 0;
+	ibool		profile	= srv_latch_profiling;
 
-	if (rw_lock_get_writer(lock) == RW_LOCK_NOT_LOCKED) {
+	ut_ad(lock->lock_word <= 0);
 
-		if (rw_lock_get_reader_count(lock) == 0) {
+	while (lock->lock_word < 0) {
+		if (srv_spin_wait_delay) {
+			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+		}
+		if (i < SYNC_SPIN_ROUNDS) {
+			i++;
+			continue;
+		}
 
-			rw_lock_set_writer(lock, RW_LOCK_EX);
-			lock->writer_thread = os_thread_get_curr_id();
-			lock->writer_count++;
-			lock->pass = pass;
+		/* If there is still a reader, then go to sleep.*/
+		rw_x_spin_wait_count++;
 
-#ifdef UNIV_SYNC_DEBUG
-			rw_lock_add_debug_info(lock, pass, RW_LOCK_EX,
-					       file_name, line);
-#endif
-			lock->last_x_file_name = file_name;
-			lock->last_x_line = (unsigned int) line;
+		if (UNIV_UNLIKELY(profile)) {
+			lock->count_spin_loop++;
+			lock->count_spin_rounds += i;
+		}
 
-			/* Locking succeeded, we may return */
-			return(RW_LOCK_EX);
-		} else {
-			/* There are readers, we have to wait */
-			rw_lock_set_writer(lock, RW_LOCK_WAIT_EX);
-			lock->writer_thread = os_thread_get_curr_id();
-			lock->pass = pass;
-			lock->writer_is_wait_ex = TRUE;
+		sync_arr = sync_array_get_and_reserve_cell(lock,
+							   RW_LOCK_WAIT_EX,
+							   file_name, line,
+							   &index);
+		i = 0;
+
+		/* Check lock_word to ensure wake-up isn't missed.*/
+		if (lock->lock_word < 0) {
 
+			/* these stats may not be accurate */
+			rw_x_system_call_count++;
+			rw_x_os_wait_count++;
+			lock->count_os_wait++;
+
+			if (UNIV_UNLIKELY(profile) && *start_time == 0) {
+				*start_time = ut_time_us(NULL);
+			}
+
+			/* Add debug info as it is needed to detect possible
+			deadlock. We must add info for WAIT_EX thread for
+			deadlock detection to work properly. */
 #ifdef UNIV_SYNC_DEBUG
 			rw_lock_add_debug_info(lock, pass, RW_LOCK_WAIT_EX,
 					       file_name, line);
 #endif
 
-			return(RW_LOCK_WAIT_EX);
-		}
-
-	} else if ((rw_lock_get_writer(lock) == RW_LOCK_WAIT_EX)
-		   && os_thread_eq(lock->writer_thread,
-				   os_thread_get_curr_id())) {
-
-		if (rw_lock_get_reader_count(lock) == 0) {
-
-			rw_lock_set_writer(lock, RW_LOCK_EX);
-			lock->writer_count++;
-			lock->pass = pass;
-			lock->writer_is_wait_ex = FALSE;
-
+			sync_array_wait_event(sync_arr, index);
 #ifdef UNIV_SYNC_DEBUG
-			rw_lock_remove_debug_info(lock, pass, RW_LOCK_WAIT_EX);
-			rw_lock_add_debug_info(lock, pass, RW_LOCK_EX,
-					       file_name, line);
+			rw_lock_remove_debug_info(lock, pass,
+						  RW_LOCK_WAIT_EX);
 #endif
+			/* It is possible to wake when lock_word < 0.
+			We must pass the while-loop check to proceed.*/
+		} else {
+			sync_array_free_cell(sync_arr, index);
+		}
+	}
 
-			lock->last_x_file_name = file_name;
-			lock->last_x_line = (unsigned int) line;
+	if (UNIV_UNLIKELY(profile) && i > 0) {
+		lock->count_spin_loop++;
+		lock->count_spin_rounds += i;
+	}
+}
 
-			/* Locking succeeded, we may return */
-			return(RW_LOCK_EX);
-		}
+/**********************************************************************
+Low-level function for acquiring an exclusive lock. */
+UNIV_INLINE
+ibool
+rw_lock_x_lock_low(
+/*===============*/
+				/* out: TRUE if acquired, FALSE if not */
+	rw_lock_t*	lock,	/* in: pointer to rw-lock */
+	ulint		pass,	/* in: pass value; != 0, if the lock will
+				be passed to another thread to unlock */
+	const char*	file_name,/* in: file name where lock requested */
+	ulint		line,	/* in: line where requested */
+	ullint*		start_time)/* in/out: ut_time_us() when the wait
+				for the lock started, or 0 */
+{
+	os_thread_id_t	curr_thread	= os_thread_get_curr_id();
 
-		return(RW_LOCK_WAIT_EX);
+	if (rw_lock_lock_word_decr(lock, X_LOCK_DECR)) {
 
-	} else if ((rw_lock_get_writer(lock) == RW_LOCK_EX)
-		   && os_thread_eq(lock->writer_thread,
-				   os_thread_get_curr_id())
-		   && (lock->pass == 0)
-		   && (pass == 0)) {
+		/* lock->recursive also tells us if the writer_thread
+		field is stale or active. As we are going to write
+		our own thread id in that field it must be that the
+		current writer_thread value is not active. */
+		ut_a(!lock->recursive);
 
-		lock->writer_count++;
+		/* Decrement occurred: we are writer or next-writer. */
+		rw_lock_set_writer_id_and_recursion_flag(lock,
+							 pass ? FALSE : TRUE);
 
+		rw_lock_x_lock_wait(lock,
 #ifdef UNIV_SYNC_DEBUG
-		rw_lock_add_debug_info(lock, pass, RW_LOCK_EX, file_name,
-				       line);
+				    pass,
 #endif
+				    file_name, line, start_time);
 
-		lock->last_x_file_name = file_name;
-		lock->last_x_line = (unsigned int) line;
-
-		/* Locking succeeded, we may return */
-		return(RW_LOCK_EX);
+	} else {
+		/* Decrement failed: relock or failed lock */
+		if (!pass && lock->recursive
+		    && os_thread_eq(lock->writer_thread, curr_thread)) {
+			/* Relock */
+			lock->lock_word -= X_LOCK_DECR;
+		} else {
+			/* Another thread locked before us */
+			return(FALSE);
+		}
 	}
+#ifdef UNIV_SYNC_DEBUG
+	rw_lock_add_debug_info(lock, pass, RW_LOCK_EX,
+			       file_name, line);
+#endif
+	lock->last_x_file_name = file_name;
+	lock->last_x_line = (unsigned int) line;
 
-	/* Locking did not succeed */
-	return(RW_LOCK_NOT_LOCKED);
+	return(TRUE);
 }
 
 /**********************************************************************
@@ -471,31 +557,38 @@ rw_lock_x_lock_func(
 	const char*	file_name,/* in: file name where lock requested */
 	ulint		line)	/* in: line where requested */
 {
-	ulint	index;	/* index of the reserved wait cell */
-	ulint	state;	/* lock state acquired */
-	ulint	i;	/* spin round count */
+	ulint		index;	/* index of the reserved wait cell */
+	sync_array_t*	sync_arr;/* wait array of the cell */
+	ulint		i;	/* spin round count */
+	ulint		i_start;/* value of i when this spin loop started */
+	ibool		spinning = FALSE;
+	ibool		profile	= srv_latch_profiling;
+	ullint		start_time = 0;/* for timing the wait */
 
 	ut_ad(rw_lock_validate(lock));
 
-lock_loop:
-	/* Acquire the mutex protecting the rw-lock fields */
-	mutex_enter_fast(&(lock->mutex));
-
-	state = rw_lock_x_lock_low(lock, pass, file_name, line);
+	i = 0;
 
-	mutex_exit(&(lock->mutex));
+lock_loop:
 
-	if (state == RW_LOCK_EX) {
+	if (rw_lock_x_lock_low(lock, pass, file_name, line,
+			       &start_time)) {
+		rw_lock_profile_wait_end(lock, start_time);
 
 		return;	/* Locking succeeded */
 
-	} else if (state == RW_LOCK_NOT_LOCKED) {
+	} else {
 
-		/* Spin waiting for the writer field to become free */
-		i = 0;
+		if (!spinning) {
+			spinning = TRUE;
+			rw_x_spin_wait_count++;
+		}
+
+		i_start = i;
 
-		while (rw_lock_get_writer(lock) != RW_LOCK_NOT_LOCKED
-		       && i < SYNC_SPIN_ROUNDS) {
+		/* Spin waiting for the lock_word to become free */
+		while (i < SYNC_SPIN_ROUNDS
+		       && lock->lock_word <= 0) {
 			if (srv_spin_wait_delay) {
 				ut_delay(ut_rnd_interval(0,
 							 srv_spin_wait_delay));
@@ -503,29 +596,21 @@ lock_loop:
 
 			i++;
 		}
-		if (i == SYNC_SPIN_ROUNDS) {
-			os_thread_yield();
-		}
-	} else if (state == RW_LOCK_WAIT_EX) {
 
-		/* Spin waiting for the reader count field to become zero */
-		i = 0;
+		if (UNIV_UNLIKELY(profile)) {
+			lock->count_spin_loop++;
+			lock->count_spin_rounds += i - i_start;
+		}
 
-		while (rw_lock_get_reader_count(lock) != 0
-		       && i < SYNC_SPIN_ROUNDS) {
-			if (srv_spin_wait_delay) {
-				ut_delay(ut_rnd_interval(0,
-							 srv_spin_wait_delay));
+		if (i == SYNC_SPIN_ROUNDS) {
+			if (UNIV_UNLIKELY(profile) && start_time == 0) {
+				start_time = ut_time_us(NULL);
 			}
 
-			i++;
-		}
-		if (i == SYNC_SPIN_ROUNDS) {
 			os_thread_yield();
+		} else {
+			goto lock_loop;
 		}
-	} else {
-		i = 0; /* Eliminate a compiler warning */
-		ut_error;
 	}
 
 	if (srv_print_latch_waits) {
@@ -536,40 +621,23 @@ lock_loop:
 			lock->cfile_name, (ulong) lock->cline, (ulong) i);
 	}
 
-	rw_x_spin_wait_count++;
-
-	/* We try once again to obtain the lock. Acquire the mutex protecting
-	the rw-lock fields */
+	rw_x_system_call_count++;
 
-	mutex_enter(rw_lock_get_mutex(lock));
+	sync_arr = sync_array_get_and_reserve_cell(lock, RW_LOCK_EX,
+						   file_name, line, &index);
 
-	state = rw_lock_x_lock_low(lock, pass, file_name, line);
+	/* Waiters must be set before checking lock_word, to ensure signal
+	is sent. This could lead to a few unnecessary wake-up signals. */
+	rw_lock_set_waiter_flag(lock);
 
-	if (state == RW_LOCK_EX) {
-		mutex_exit(rw_lock_get_mutex(lock));
+	if (rw_lock_x_lock_low(lock, pass, file_name, line,
+			       &start_time)) {
+		sync_array_free_cell(sync_arr, index);
+		rw_lock_profile_wait_end(lock, start_time);
 
-		return;	/* Locking succeeded */
+		return; /* Locking succeeded */
 	}
 
-	rw_x_system_call_count++;
-
-	sync_array_reserve_cell(sync_primary_wait_array,
-				lock,
-#ifdef __WIN__
-				/* On windows RW_LOCK_WAIT_EX signifies
-				that this thread should wait on the
-				special wait_ex_event. */
-				(state == RW_LOCK_WAIT_EX)
-				 ? RW_LOCK_WAIT_EX :
-#endif
-				RW_LOCK_EX,
-				file_name, line,
-				&index);
-
-	rw_lock_set_waiters(lock, 1);
-
-	mutex_exit(rw_lock_get_mutex(lock));
-
 	if (srv_print_latch_waits) {
 		fprintf(stderr,
 			"Thread %lu OS wait for rw-x-lock at %p"
@@ -580,9 +648,15 @@ lock_loop:
 
 	rw_x_system_call_count++;
 	rw_x_os_wait_count++;
+	lock->count_os_wait++;
+
+	if (UNIV_UNLIKELY(profile) && start_time == 0) {
+		start_time = ut_time_us(NULL);
+	}
 
-	sync_array_wait_event(sync_primary_wait_array, index);
+	sync_array_wait_event(sync_arr, index);
 
+	i = 0;
 	goto lock_loop;
 }
 
@@ -730,7 +804,7 @@ rw_lock_own(
 	ut_ad(lock);
 	ut_ad(rw_lock_validate(lock));
 
-	mutex_enter(&(lock->mutex));
+	rw_lock_debug_mutex_enter();
 
 	info = UT_LIST_GET_FIRST(lock->debug_list);
 
@@ -740,7 +814,7 @@ rw_lock_own(
 		    && (info->pass == 0)
 		    && (info->lock_type == lock_type)) {
 
-			mutex_exit(&(lock->mutex));
+			rw_lock_debug_mutex_exit();
 			/* Found! */
 
 			return(TRUE);
@@ -748,7 +822,7 @@ rw_lock_own(
 
 		info = UT_LIST_GET_NEXT(list, info);
 	}
-	mutex_exit(&(lock->mutex));
+	rw_lock_debug_mutex_exit();
 
 	return(FALSE);
 }
@@ -770,22 +844,18 @@ rw_lock_is_locked(
 	ut_ad(lock);
 	ut_ad(rw_lock_validate(lock));
 
-	mutex_enter(&(lock->mutex));
-
 	if (lock_type == RW_LOCK_SHARED) {
-		if (lock->reader_count > 0) {
+		if (rw_lock_get_reader_count(lock) > 0) {
 			ret = TRUE;
 		}
 	} else if (lock_type == RW_LOCK_EX) {
-		if (lock->writer == RW_LOCK_EX) {
+		if (rw_lock_get_writer(lock) == RW_LOCK_EX) {
 			ret = TRUE;
 		}
 	} else {
 		ut_error;
 	}
 
-	mutex_exit(&(lock->mutex));
-
 	return(ret);
 }
 
@@ -814,11 +884,10 @@ rw_lock_list_print_info(
 
 		count++;
 
+#ifndef INNODB_RW_LOCKS_USE_ATOMICS
 		mutex_enter(&(lock->mutex));
-
-		if ((rw_lock_get_writer(lock) != RW_LOCK_NOT_LOCKED)
-		    || (rw_lock_get_reader_count(lock) != 0)
-		    || (rw_lock_get_waiters(lock) != 0)) {
+#endif
+		if (lock->lock_word != X_LOCK_DECR) {
 
 			fprintf(file, "RW-LOCK: %p ", (void*) lock);
 
@@ -828,14 +897,17 @@ rw_lock_list_print_info(
 				putc('\n', file);
 			}
 
+			rw_lock_debug_mutex_enter();
 			info = UT_LIST_GET_FIRST(lock->debug_list);
 			while (info != NULL) {
 				rw_lock_debug_print(info);
 				info = UT_LIST_GET_NEXT(list, info);
 			}
+			rw_lock_debug_mutex_exit();
 		}
-
+#ifndef INNODB_RW_LOCKS_USE_ATOMICS
 		mutex_exit(&(lock->mutex));
+#endif
 		lock = UT_LIST_GET_NEXT(list, lock);
 	}
 
@@ -858,9 +930,7 @@ rw_lock_print(
 		"RW-LATCH INFO\n"
 		"RW-LATCH: %p ", (void*) lock);
 
-	if ((rw_lock_get_writer(lock) != RW_LOCK_NOT_LOCKED)
-	    || (rw_lock_get_reader_count(lock) != 0)
-	    || (rw_lock_get_waiters(lock) != 0)) {
+	if (lock->lock_word != X_LOCK_DECR) {
 
 		if (rw_lock_get_waiters(lock)) {
 			fputs(" Waiters for the lock exist\n", stderr);
@@ -922,14 +992,11 @@ rw_lock_n_locked(void)
 	lock = UT_LIST_GET_FIRST(rw_lock_list);
 
 	while (lock != NULL) {
-		mutex_enter(rw_lock_get_mutex(lock));
 
-		if ((rw_lock_get_writer(lock) != RW_LOCK_NOT_LOCKED)
-		    || (rw_lock_get_reader_count(lock) != 0)) {
+		if (lock->lock_word != X_LOCK_DECR) {
 			count++;
 		}
 
-		mutex_exit(rw_lock_get_mutex(lock));
 		lock = UT_LIST_GET_NEXT(list, lock);
 	}
 
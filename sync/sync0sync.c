@@ -15,6 +15,8 @@ Created 9/5/1995 Heikki Tuuri
 #include "buf0buf.h"
 #include "srv0srv.h"
 #include "buf0types.h"
+#include "hash0hash.h"
+#include "mem0mem.h"
 
 /*
 	REASONS FOR IMPLEMENTING THE SPIN LOCK MUTEX
@@ -125,13 +127,14 @@ value returned from the earlier call of os_event_reset(), it will
 return immediately without waiting.
 Q.E.D.
 
-Proof (windows): If there is a writer thread which is forced to wait for
-the lock, it may be able to set the state of rw_lock to RW_LOCK_WAIT_EX
+Proof (windows), and for the next-writer of an rw_lock on all platforms:
+If there is a writer thread which is forced to wait for the lock, it may
+be able to set the state of rw_lock to RW_LOCK_WAIT_EX
 The design of rw_lock ensures that there is one and only one thread
 that is able to change the state to RW_LOCK_WAIT_EX and this thread is
 guaranteed to acquire the lock after it is released by the current
 holders and before any other waiter gets the lock.
-On windows this thread waits on a separate event i.e.: wait_ex_event.
+This thread waits on a separate event i.e.: wait_ex_event.
 Since only one thread can wait on this event there is no chance
 of this event getting reset before the writer starts wait on it.
 Therefore, this thread is guaranteed to catch the os_set_event()
@@ -151,10 +154,6 @@ UNIV_INTERN ulint	mutex_spin_wait_count		= 0;
 UNIV_INTERN ulint	mutex_os_wait_count		= 0;
 UNIV_INTERN ulint	mutex_exit_count		= 0;
 
-/* The global array of wait cells for implementation of the database's own
-mutexes and read-write locks */
-UNIV_INTERN sync_array_t*	sync_primary_wait_array;
-
 /* This variable is set to TRUE when sync_init is called */
 UNIV_INTERN ibool	sync_initialized	= FALSE;
 
@@ -237,14 +236,14 @@ mutex_create_func(
 	mutex->cline = cline;
 #ifndef UNIV_HOTBACKUP
 	mutex->count_os_wait = 0;
+	mutex->count_spin_loop = 0;
+	mutex->count_spin_rounds = 0;
+	mutex->lspent_time = 0;
 # ifdef UNIV_DEBUG
 	mutex->cmutex_name=	  cmutex_name;
 	mutex->count_using=	  0;
 	mutex->mutex_type=	  0;
-	mutex->lspent_time=	  0;
 	mutex->lmax_spent_time=     0;
-	mutex->count_spin_loop= 0;
-	mutex->count_spin_rounds=   0;
 	mutex->count_os_yield=  0;
 # endif /* UNIV_DEBUG */
 #endif /* !UNIV_HOTBACKUP */
@@ -416,14 +415,14 @@ mutex_spin_wait(
 	ulint		line)		/* in: line where requested */
 {
 	ulint	   index; /* index of the reserved wait cell */
+	sync_array_t*	sync_arr; /* wait array of the cell */
 	ulint	   i;	  /* spin round count */
-#if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
-	ib_longlong lstart_time = 0, lfinish_time; /* for timing os_wait */
-	ulint ltime_diff;
-	ulint sec;
-	ulint ms;
-	uint timer_started = 0;
-#endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+#ifndef UNIV_HOTBACKUP
+	ibool	   profile = srv_latch_profiling; /* TRUE if the contention
+				  profile of the mutex is to be updated */
+	ullint	   lstart_time = 0; /* for timing os_wait */
+	ullint	   ltime_diff;
+#endif /* !UNIV_HOTBACKUP */
 	ut_ad(mutex);
 
 mutex_loop:
@@ -439,8 +438,12 @@ mutex_loop:
 spin_loop:
 #if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
 	mutex_spin_wait_count++;
-	mutex->count_spin_loop++;
 #endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+#ifndef UNIV_HOTBACKUP
+	if (UNIV_UNLIKELY(profile)) {
+		mutex->count_spin_loop++;
+	}
+#endif /* !UNIV_HOTBACKUP */
 
 	while (mutex_get_lock_word(mutex) != 0 && i < SYNC_SPIN_ROUNDS) {
 		if (srv_spin_wait_delay) {
@@ -453,12 +456,12 @@ spin_loop:
 	if (i == SYNC_SPIN_ROUNDS) {
 #if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
 		mutex->count_os_yield++;
-		if (timed_mutexes == 1 && timer_started==0) {
-			ut_usectime(&sec, &ms);
-			lstart_time= (ib_longlong)sec * 1000000 + ms;
-			timer_started = 1;
-		}
 #endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+#ifndef UNIV_HOTBACKUP
+		if (UNIV_UNLIKELY(profile) && lstart_time == 0) {
+			lstart_time = ut_time_us(NULL);
+		}
+#endif /* !UNIV_HOTBACKUP */
 		os_thread_yield();
 	}
 
@@ -472,9 +475,11 @@ spin_loop:
 
 	mutex_spin_round_count += i;
 
-#if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
-	mutex->count_spin_rounds += i;
-#endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+#ifndef UNIV_HOTBACKUP
+	if (UNIV_UNLIKELY(profile)) {
+		mutex->count_spin_rounds += i;
+	}
+#endif /* !UNIV_HOTBACKUP */
 
 	if (mutex_test_and_set(mutex) == 0) {
 		/* Succeeded! */
@@ -500,8 +505,8 @@ spin_loop:
 		goto spin_loop;
 	}
 
-	sync_array_reserve_cell(sync_primary_wait_array, mutex,
-				SYNC_MUTEX, file_name, line, &index);
+	sync_arr = sync_array_get_and_reserve_cell(mutex, SYNC_MUTEX,
+						   file_name, line, &index);
 
 	mutex_system_call_count++;
 
@@ -518,7 +523,7 @@ spin_loop:
 		if (mutex_test_and_set(mutex) == 0) {
 			/* Succeeded! Free the reserved wait cell */
 
-			sync_array_free_cell(sync_primary_wait_array, index);
+			sync_array_free_cell(sync_arr, index);
 
 			ut_d(mutex->thread_id = os_thread_get_curr_id());
 #ifdef UNIV_SYNC_DEBUG
@@ -556,34 +561,32 @@ spin_loop:
 
 #ifndef UNIV_HOTBACKUP
 	mutex->count_os_wait++;
-# ifdef UNIV_DEBUG
-	/* !!!!! Sometimes os_wait can be called without os_thread_yield */
 
-	if (timed_mutexes == 1 && timer_started==0) {
-		ut_usectime(&sec, &ms);
-		lstart_time= (ib_longlong)sec * 1000000 + ms;
-		timer_started = 1;
+	/* Sometimes os_wait can be called without os_thread_yield */
+
+	if (UNIV_UNLIKELY(profile) && lstart_time == 0) {
+		lstart_time = ut_time_us(NULL);
 	}
-# endif /* UNIV_DEBUG */
 #endif /* !UNIV_HOTBACKUP */
 
-	sync_array_wait_event(sync_primary_wait_array, index);
+	sync_array_wait_event(sync_arr, index);
 	goto mutex_loop;
 
 finish_timing:
-#if defined UNIV_DEBUG && !defined UNIV_HOTBACKUP
-	if (timed_mutexes == 1 && timer_started==1) {
-		ut_usectime(&sec, &ms);
-		lfinish_time= (ib_longlong)sec * 1000000 + ms;
-
-		ltime_diff= (ulint) (lfinish_time - lstart_time);
+#ifndef UNIV_HOTBACKUP
+	if (UNIV_UNLIKELY(lstart_time != 0)
+	    && ut_time_us(&ltime_diff) > lstart_time) {
+		/* The clock did not go backwards */
+		ltime_diff -= lstart_time;
 		mutex->lspent_time += ltime_diff;
 
+# ifdef UNIV_DEBUG
 		if (mutex->lmax_spent_time < ltime_diff) {
-			mutex->lmax_spent_time= ltime_diff;
+			mutex->lmax_spent_time = ltime_diff;
 		}
+# endif /* UNIV_DEBUG */
 	}
-#endif /* UNIV_DEBUG && !UNIV_HOTBACKUP */
+#endif /* !UNIV_HOTBACKUP */
 	return;
 }
 
@@ -600,7 +603,7 @@ mutex_signal_object(
 	/* The memory order of resetting the waiters field and
 	signaling the object is important. See LEMMA 1 above. */
 	os_event_set(mutex->event);
-	sync_array_object_signalled(sync_primary_wait_array);
+	sync_array_object_signalled();
 }
 
 #ifdef UNIV_SYNC_DEBUG
@@ -727,6 +730,150 @@ sync_all_freed(void)
 	return(mutex_n_reserved() + rw_lock_n_locked() == 0);
 }
 
+#ifndef UNIV_HOTBACKUP
+/**********************************************************************
+Adds the counters of one latch to the class of its creation site,
+creating the class if this is the first latch of the site that has been
+waited for. */
+static
+void
+sync_latch_class_add(
+/*=================*/
+	hash_table_t*	table,		/* in/out: latch classes hashed by
+					the creation site */
+	mem_heap_t*	heap,		/* in: memory heap for new classes */
+	ulint*		n_classes,	/* in/out: number of classes */
+	const char*	cfile_name,	/* in: file where the latch was
+					created */
+	ulint		cline,		/* in: line where the latch was
+					created */
+	ibool		is_rw_lock,	/* in: TRUE if an rw-lock */
+	ulint		spin_waits,	/* in: spin loops on the latch */
+	ulint		spin_rounds,	/* in: spin rounds on the latch */
+	ulint		os_waits,	/* in: OS waits on the latch */
+	ullint		os_wait_time)	/* in: time waited, in microseconds */
+{
+	sync_latch_class_t*	latch_class;
+	ulint			fold;
+
+	if (spin_waits == 0 && os_waits == 0) {
+
+		return;
+	}
+
+	fold = ut_fold_ulint_pair(ut_fold_string(cfile_name), cline);
+
+	HASH_SEARCH(hash, table, fold, sync_latch_class_t*, latch_class,
+		    latch_class->cline == cline
+		    && latch_class->is_rw_lock == is_rw_lock
+		    && !strcmp(latch_class->cfile_name, cfile_name));
+
+	if (latch_class == NULL) {
+		latch_class = mem_heap_zalloc(heap, sizeof *latch_class);
+
+		latch_class->cfile_name = cfile_name;
+		latch_class->cline = cline;
+		latch_class->is_rw_lock = is_rw_lock;
+
+		HASH_INSERT(sync_latch_class_t, hash, table, fold,
+			    latch_class);
+		(*n_classes)++;
+	}
+
+	latch_class->n_latches++;
+	latch_class->spin_waits += spin_waits;
+	latch_class->spin_rounds += spin_rounds;
+	latch_class->os_waits += os_waits;
+	latch_class->os_wait_time += os_wait_time;
+}
+
+/**********************************************************************
+Sums up the contention counters of the mutexes and rw-locks by the
+place where they were created. Only the creation sites where some latch
+has been waited for are returned. */
+UNIV_INTERN
+sync_latch_class_t*
+sync_latch_classes_collect(
+/*=======================*/
+				/* out, own: array of latch classes, to
+				be freed with ut_free(), or NULL if
+				there were none */
+	ulint*	n_classes)	/* out: number of elements in the array */
+{
+	hash_table_t*		table;
+	mem_heap_t*		heap;
+	mutex_t*		mutex;
+	rw_lock_t*		lock;
+	sync_latch_class_t*	classes;
+	sync_latch_class_t*	latch_class;
+	ulint			i;
+	ulint			j;
+
+	*n_classes = 0;
+
+	/* There are typically a few hundred creation sites; all the
+	buffer pool block latches share one of them */
+	table = hash_create(256);
+	heap = mem_heap_create(1024);
+
+	mutex_enter(&mutex_list_mutex);
+
+	for (mutex = UT_LIST_GET_FIRST(mutex_list); mutex != NULL;
+	     mutex = UT_LIST_GET_NEXT(list, mutex)) {
+
+		sync_latch_class_add(table, heap, n_classes,
+				     mutex->cfile_name, mutex->cline, FALSE,
+				     mutex->count_spin_loop,
+				     mutex->count_spin_rounds,
+				     mutex->count_os_wait,
+				     mutex->lspent_time);
+	}
+
+	mutex_exit(&mutex_list_mutex);
+
+	mutex_enter(&rw_lock_list_mutex);
+
+	for (lock = UT_LIST_GET_FIRST(rw_lock_list); lock != NULL;
+	     lock = UT_LIST_GET_NEXT(list, lock)) {
+
+		sync_latch_class_add(table, heap, n_classes,
+				     lock->cfile_name, lock->cline, TRUE,
+				     lock->count_spin_loop,
+				     lock->count_spin_rounds,
+				     lock->count_os_wait,
+				     lock->lspent_time);
+	}
+
+	mutex_exit(&rw_lock_list_mutex);
+
+	classes = NULL;
+
+	if (*n_classes > 0) {
+		classes = ut_malloc(*n_classes * sizeof *classes);
+
+		j = 0;
+
+		for (i = 0; i < hash_get_n_cells(table); i++) {
+			for (latch_class = HASH_GET_FIRST(table, i);
+			     latch_class != NULL;
+			     latch_class = HASH_GET_NEXT(hash, latch_class)) {
+
+				classes[j] = *latch_class;
+				classes[j].hash = NULL;
+				j++;
+			}
+		}
+
+		ut_a(j == *n_classes);
+	}
+
+	mem_heap_free(heap);
+	hash_table_free(table);
+
+	return(classes);
+}
+#endif /* !UNIV_HOTBACKUP */
+
 /**********************************************************************
 Gets the value in the nth slot in the thread level arrays. */
 static
@@ -1054,6 +1201,7 @@ sync_thread_add_level(
 	case SYNC_LOG:
 	case SYNC_THR_LOCAL:
 	case SYNC_ANY_LATCH:
+	case SYNC_FIL_IO:
 	case SYNC_TRX_SYS_HEADER:
 	case SYNC_DOUBLEWRITE:
 	case SYNC_BUF_POOL:
@@ -1248,11 +1396,10 @@ sync_init(void)
 
 	sync_initialized = TRUE;
 
-	/* Create the primary system wait array which is protected by an OS
-	mutex */
+	/* Create the primary system wait arrays which are protected by OS
+	mutexes */
 
-	sync_primary_wait_array = sync_array_create(OS_THREAD_MAX_N,
-						    SYNC_ARRAY_OS_MUTEX);
+	sync_array_init(OS_THREAD_MAX_N);
 #ifdef UNIV_SYNC_DEBUG
 	/* Create the thread latch level array where the latch levels
 	are stored for each OS thread */
@@ -1296,7 +1443,7 @@ sync_close(void)
 {
 	mutex_t*	mutex;
 
-	sync_array_free(sync_primary_wait_array);
+	sync_array_close();
 
 	mutex = UT_LIST_GET_FIRST(mutex_list);
 
@@ -1351,7 +1498,7 @@ sync_print(
 	rw_lock_list_print_info(file);
 #endif /* UNIV_SYNC_DEBUG */
 
-	sync_array_print_info(file, sync_primary_wait_array);
+	sync_array_print_info(file);
 
 	sync_print_wait_info(file);
 }
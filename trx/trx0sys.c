@@ -93,6 +93,9 @@ trx_doublewrite_init(
 	byte*	doublewrite)	/* in: pointer to the doublewrite buf
 				header on trx sys page */
 {
+	ulint	n_pages;
+	ulint	i;
+
 	trx_doublewrite = mem_alloc(sizeof(trx_doublewrite_t));
 
 	/* Since we now start to use the doublewrite buffer, no need to call
@@ -101,10 +104,6 @@ trx_doublewrite_init(
 	os_do_not_call_flush_at_each_write = TRUE;
 #endif /* UNIV_DO_FLUSH */
 
-	mutex_create(&trx_doublewrite->mutex, SYNC_DOUBLEWRITE);
-
-	trx_doublewrite->first_free = 0;
-
 	trx_doublewrite->block1 = mach_read_from_4(
 		doublewrite + TRX_SYS_DOUBLEWRITE_BLOCK1);
 	trx_doublewrite->block2 = mach_read_from_4(
@@ -116,6 +115,34 @@ trx_doublewrite_init(
 		trx_doublewrite->write_buf_unaligned, UNIV_PAGE_SIZE);
 	trx_doublewrite->buf_block_arr = mem_alloc(
 		2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE * sizeof(void*));
+
+	/* Divide the two blocks into slots so that no slot crosses the
+	boundary of a block: a slot is written with a single i/o */
+
+	n_pages = 2 * TRX_SYS_DOUBLEWRITE_BLOCK_SIZE / TRX_DOUBLEWRITE_N_SLOTS;
+
+	ut_a(n_pages > 0);
+	ut_a(TRX_SYS_DOUBLEWRITE_BLOCK_SIZE % n_pages == 0);
+
+	for (i = 0; i < TRX_DOUBLEWRITE_N_SLOTS; i++) {
+		trx_doublewrite_slot_t*	slot	= &trx_doublewrite->slots[i];
+		ulint			pos	= i * n_pages;
+
+		mutex_create(&slot->mutex, SYNC_DOUBLEWRITE);
+
+		if (pos < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE) {
+			slot->page_no = trx_doublewrite->block1 + pos;
+		} else {
+			slot->page_no = trx_doublewrite->block2 + pos
+				- TRX_SYS_DOUBLEWRITE_BLOCK_SIZE;
+		}
+
+		slot->n_pages = n_pages;
+		slot->first_free = 0;
+		slot->write_buf = trx_doublewrite->write_buf
+			+ pos * UNIV_PAGE_SIZE;
+		slot->buf_block_arr = trx_doublewrite->buf_block_arr + pos;
+	}
 }
 
 /********************************************************************
@@ -534,6 +561,21 @@ trx_sys_doublewrite_init_or_restore_pages(
 				fprintf(stderr,
 					"InnoDB: Recovered the page from"
 					" the doublewrite buffer.\n");
+			} else if (mach_read_ull(read_buf + FIL_PAGE_LSN)
+				   < mach_read_ull(page + FIL_PAGE_LSN)
+				   && !buf_page_is_corrupted(page, zip_size)) {
+
+				/* The buffer pool flushes through several
+				slots of the doublewrite buffer, and an older
+				copy of the page in another slot may have been
+				restored above. Write the newer copy: it was
+				written to the doublewrite buffer before the
+				write to the intended position began. */
+
+				fil_io(OS_FILE_WRITE, TRUE, space_id,
+				       zip_size, page_no, 0,
+				       zip_size ? zip_size : UNIV_PAGE_SIZE,
+				       page, NULL);
 			}
 		}
 
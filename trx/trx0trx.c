@@ -139,6 +139,8 @@ trx_create(
 
 	trx->wait_lock = NULL;
 	trx->was_chosen_as_deadlock_victim = FALSE;
+	trx->deadlock_mark = 0;
+	trx->deadlock_check_deferred = FALSE;
 	UT_LIST_INIT(trx->wait_thrs);
 
 	trx->lock_heap = mem_heap_create_in_buffer(256);